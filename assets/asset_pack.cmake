@@ -0,0 +1,40 @@
+# Single file asset pack next to the executable: cooked meshes and textures plus compiled shaders
+add_executable(asset_packer "tools/asset_packer.cpp" "src/asset_pack.cpp" "src/asset_pack.hpp" "src/mapped_file.cpp" "src/mapped_file.hpp")
+set_target_properties(asset_packer PROPERTIES CXX_STANDARD 23)
+
+# imports models through ModelLoader so the pack carries the same cache the runtime would write
+add_executable(mesh_cooker "tools/mesh_cooker.cpp" "src/model_loader.cpp" "src/mesh_cache.cpp" "src/mesh_optimizer.cpp" "src/asset_pack.cpp" "src/mapped_file.cpp")
+set_target_properties(mesh_cooker PROPERTIES CXX_STANDARD 23)
+target_link_libraries(mesh_cooker PRIVATE assimp::assimp wis::wisdom) # wisdom brings DirectXMath
+
+# textures that were not cooked (missing sources) are skipped by the packer
+set(PACKED_ASSETS
+	"assets/SnowmanOBJ.obj.mesh"
+	"assets/Snowman_C.dds"
+	"assets/Snowman_NM.dds"
+	"assets/Snowman_S.dds"
+	"assets/Snowman_Emessive.dds"
+	"shaders"
+)
+
+# the cache is rewritten only when stale, the touch keeps an up to date cache from cooking on every build
+set(MESH_CACHE "${CMAKE_BINARY_DIR}/assets/SnowmanOBJ.obj.mesh")
+add_custom_command(OUTPUT ${MESH_CACHE}
+	COMMAND mesh_cooker "${CMAKE_BINARY_DIR}/assets/SnowmanOBJ.obj"
+	COMMAND ${CMAKE_COMMAND} -E touch ${MESH_CACHE}
+	DEPENDS mesh_cooker "${CMAKE_SOURCE_DIR}/assets/SnowmanOBJ.obj"
+	WORKING_DIRECTORY "${CMAKE_BINARY_DIR}"
+	COMMENT "Cooking SnowmanOBJ mesh"
+)
+
+# compiled shaders are not file outputs of this directory, so their sources stand in for them
+get_property(COOKED_TEXTURES GLOBAL PROPERTY COOKED_TEXTURES)
+file(GLOB SHADER_SOURCES CONFIGURE_DEPENDS "${CMAKE_SOURCE_DIR}/shaders/*")
+add_custom_command(OUTPUT "${CMAKE_BINARY_DIR}/assets.pack"
+	COMMAND asset_packer "${CMAKE_BINARY_DIR}/assets.pack" "${CMAKE_BINARY_DIR}" ${PACKED_ASSETS}
+	DEPENDS asset_packer ${MESH_CACHE} ${COOKED_TEXTURES} ${SHADER_SOURCES}
+	WORKING_DIRECTORY "${CMAKE_BINARY_DIR}"
+	COMMENT "Packing assets"
+)
+add_custom_target(asset_pack ALL DEPENDS "${CMAKE_BINARY_DIR}/assets.pack")
+add_dependencies(asset_pack copy_assets cook_textures shaders)
@@ -0,0 +1,29 @@
+# Offline texture cooker: full mip chains, block compressed into DDS next to the copied assets
+add_executable(texture_cooker "tools/texture_cooker.cpp" "tools/bc_encoder.cpp" "tools/bc_encoder.hpp" "src/dds.hpp")
+set_target_properties(texture_cooker PROPERTIES CXX_STANDARD 23)
+find_package(Threads REQUIRED)
+target_link_libraries(texture_cooker PRIVATE Threads::Threads)
+
+add_custom_target(cook_textures ALL)
+
+function(cook_texture NAME CODEC)
+	set(INPUT "${CMAKE_SOURCE_DIR}/assets/${NAME}.png")
+	set(OUTPUT "${CMAKE_BINARY_DIR}/assets/${NAME}.dds")
+	if (NOT EXISTS ${INPUT})
+		return()
+	endif()
+	add_custom_command(OUTPUT ${OUTPUT}
+		COMMAND ${CMAKE_COMMAND} -E make_directory "${CMAKE_BINARY_DIR}/assets"
+		COMMAND texture_cooker ${INPUT} ${OUTPUT} ${CODEC} kaiser
+		DEPENDS texture_cooker ${INPUT}
+		COMMENT "Cooking ${NAME} (${CODEC})"
+	)
+	add_custom_target(cook_${NAME} DEPENDS ${OUTPUT})
+	set_property(GLOBAL APPEND PROPERTY COOKED_TEXTURES ${OUTPUT}) # the pack depends on these files
+	add_dependencies(cook_textures cook_${NAME})
+endfunction()
+
+cook_texture(Snowman_C bc7)
+cook_texture(Snowman_NM bc5)
+cook_texture(Snowman_S bc4)
+cook_texture(Snowman_Emessive bc7)
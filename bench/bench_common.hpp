@@ -0,0 +1,41 @@
+#pragma once
+// Setup the CPU benchmarks share: a model as a cpu::TriangleMesh, the app's camera and a frame of primary rays
+#include "model_loader.hpp"
+#include "cpu/primary_rays.hpp"
+#include "cpu/triangle_mesh.hpp"
+#include <numbers>
+#include <vector>
+
+namespace w::bench {
+inline w::cpu::TriangleMesh LoadMesh(const std::filesystem::path& p)
+{
+    return w::cpu::TriangleMesh::FromModel(w::ModelLoader(p));
+}
+
+// the app's projection at width x height, 60 degree vertical field of view
+inline w::Camera MakeCamera(uint32_t width, uint32_t height) noexcept
+{
+    w::Camera camera;
+    camera.SetPerspective(std::numbers::pi_v<float> / 3.0f, float(width) / float(height), 0.1f, 1000.0f);
+    return camera;
+}
+
+// primary rays of the camera as it is now
+inline w::cpu::PrimaryRays ViewRays(w::Camera& camera, uint32_t width, uint32_t height)
+{
+    w::Camera::CBuffer cbuffer;
+    camera.PutCBuffer(&cbuffer);
+    return { cbuffer, width, height };
+}
+
+// one ray per pixel, rays[y * width + x]
+inline void GenerateFrame(const w::cpu::PrimaryRays& generator, std::vector<w::cpu::Ray>& rays)
+{
+    rays.resize(size_t(generator.width) * generator.height);
+    for (uint32_t y = 0; y < generator.height; ++y) {
+        for (uint32_t x = 0; x < generator.width; ++x) {
+            rays[size_t(y) * generator.width + x] = generator.Generate(x, y);
+        }
+    }
+}
+} // namespace w::bench
@@ -0,0 +1,55 @@
+// Build time, node count and SAH cost of the CPU reference BVH over the Snowman, across thread counts
+// usage: bvh_build_bench [model] [copies] [parallel_threshold]
+// copies > 1 tiles the mesh on a grid to get a build big enough for the parallel top splits
+#include "bench_common.hpp"
+#include "cpu/bvh.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t copies = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1;
+    w::cpu::BvhBuildSettings settings;
+    if (argc > 3) {
+        settings.parallel_threshold = uint32_t(std::atoi(argv[3]));
+    }
+
+    w::cpu::TriangleMesh mesh = w::bench::LoadMesh(path);
+    if (copies > 1) {
+        w::cpu::Aabb bounds;
+        for (auto& p : mesh.positions) {
+            bounds.Grow(p);
+        }
+        uint32_t side = uint32_t(std::ceil(std::sqrt(double(copies))));
+        uint32_t vertex_count = uint32_t(mesh.positions.size());
+        size_t index_count = mesh.indices.size();
+        w::cpu::float3 step = bounds.Extent() * 1.25f;
+        for (uint32_t c = 1; c < copies; ++c) {
+            w::cpu::float3 offset{ step.x * float(c % side), 0, step.z * float(c / side) };
+            for (uint32_t v = 0; v < vertex_count; ++v) {
+                mesh.positions.push_back(mesh.positions[v] + offset);
+            }
+            for (size_t i = 0; i < index_count; ++i) {
+                mesh.indices.push_back(mesh.indices[i] + c * vertex_count);
+            }
+        }
+    }
+    std::printf("%s x%u: %u triangles, parallel threshold %u\n", path, copies, mesh.TriangleCount(), settings.parallel_threshold);
+    std::printf("%8s %10s %10s %10s %8s %10s %10s\n", "threads", "build ms", "nodes", "leaves", "depth", "leaf size", "SAH cost");
+
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        settings.thread_count = threads;
+        auto bvh = w::cpu::BuildBvh(mesh, settings);
+        auto stats = bvh.Stats(settings.traversal_cost);
+        std::printf("%8u %10.2f %10u %10u %8u %10.2f %10.2f\n", threads, stats.build_ms, stats.node_count, stats.leaf_count,
+                    stats.max_depth, stats.average_leaf_size, stats.sah_cost);
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2; // always finish on the full machine
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Decode throughput of the Snowman textures: stb, the row decoder and fpng (on an fpng re-encode of the same pixels)
+// usage: decode_bench [assets dir] [iterations]
+#include "mapped_file.hpp"
+#include "png_decoder.hpp"
+#include <fpng.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace {
+template<typename F>
+double MegabytesPerSecond(uint64_t bytes, uint32_t iterations, F&& decode)
+{
+    decode(); // warm up caches and thread_local buffers
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        decode();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return double(bytes) * iterations / (1024.0 * 1024.0) / elapsed.count();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path assets = argc > 1 ? argv[1] : "assets";
+    uint32_t iterations = argc > 2 ? uint32_t(std::atoi(argv[2])) : 3;
+    fpng::fpng_init();
+
+    std::printf("%-28s %11s %12s %12s %12s\n", "texture", "size", "stb MB/s", "rows MB/s", "fpng MB/s");
+    for (const char* name : { "Snowman_NM.png", "Snowman_S.png", "Snowman_Emessive.png", "Snowman_AO.png", "Snowman_Transmission.png" }) {
+        w::MappedFile file{ assets / name };
+        if (!file) {
+            std::printf("%-28s missing\n", name);
+            continue;
+        }
+        auto bytes = file.Bytes();
+        auto* encoded = reinterpret_cast<const stbi_uc*>(bytes.data());
+
+        int width, height, channels;
+        stbi_uc* reference = stbi_load_from_memory(encoded, int(bytes.size()), &width, &height, &channels, 4);
+        if (!reference) {
+            std::printf("%-28s not decodable\n", name);
+            continue;
+        }
+        uint64_t rgba_bytes = uint64_t(width) * height * 4; // throughput is measured on decoded RGBA8
+
+        double stb = MegabytesPerSecond(rgba_bytes, iterations, [&]() {
+            int x, y, c;
+            stbi_image_free(stbi_load_from_memory(encoded, int(bytes.size()), &x, &y, &c, 4));
+        });
+
+        std::vector<uint8_t> rows(rgba_bytes);
+        double row_decoder = 0;
+        if (auto info = w::png::ReadInfo(bytes); info && info->RowDecodable()) {
+            row_decoder = MegabytesPerSecond(rgba_bytes, iterations, [&]() {
+                w::png::DecodeRows(bytes, rows.data(), uint32_t(width) * 4);
+            });
+        }
+
+        // fpng only decodes its own files, so measure it on an fpng encode of the same image
+        std::vector<uint8_t> fpng_file;
+        std::vector<uint8_t> fpng_pixels;
+        double fast = 0;
+        if (fpng::fpng_encode_image_to_memory(reference, uint32_t(width), uint32_t(height), 4, fpng_file)) {
+            fast = MegabytesPerSecond(rgba_bytes, iterations, [&]() {
+                uint32_t x, y, c;
+                fpng::fpng_decode_memory(fpng_file.data(), uint32_t(fpng_file.size()), fpng_pixels, x, y, c, 4);
+            });
+        }
+        stbi_image_free(reference);
+
+        std::printf("%-28s %5dx%-5d %12.1f %12.1f %12.1f\n", name, width, height, stb, row_decoder, fast);
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Node layouts on one SAH tree: node cache lines and pages each ray reads, and trace speed
+// usage: layout_bench [model] [width] [height] [frames]
+// primary rays come from a camera orbiting the model, bounce rays leave every primary hit in a random direction.
+// The first picks the default BvhBuildSettings::layout, bounce rays are where node fetches miss the cache
+#include "bench_common.hpp"
+#include "cpu/blas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+struct Layout {
+    const char* name;
+    BvhLayout layout;
+};
+constexpr Layout layouts[]{
+    { "build", BvhLayout::Build },
+    { "DFS", BvhLayout::DepthFirst },
+    { "vEB", BvhLayout::VanEmdeBoas },
+    { "treelet", BvhLayout::Treelet },
+};
+
+struct Result {
+    TraversalCounters counters;
+    double seconds = 0;
+    uint64_t mismatches = 0;
+};
+
+void TraceAll(std::span<const Blas> blases, std::span<const Ray> rays, std::span<Result> results)
+{
+    std::vector<Hit> reference(rays.size());
+    for (size_t l = 0; l < blases.size(); ++l) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Hit hit = blases[l].Trace(rays[i]);
+            if (l == 0) {
+                reference[i] = hit;
+            }
+            results[l].mismatches += hit.primitive != reference[i].primitive;
+        }
+        results[l].seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (const Ray& ray : rays) {
+            blases[l].Trace(ray, results[l].counters);
+        }
+    }
+}
+
+void Print(const char* workload, std::span<const Result> results, uint64_t ray_count)
+{
+    double rays = double(ray_count);
+    std::printf("\n%s, %llu rays, one thread\n", workload, (unsigned long long)ray_count);
+    std::printf("%-8s %10s %10s %10s %10s %12s\n", "layout", "nodes/ray", "lines/ray", "pages/ray", "Mrays/s", "mismatches");
+    for (size_t l = 0; l < results.size(); ++l) {
+        const auto& counters = results[l].counters;
+        std::printf("%-8s %10.2f %10.2f %10.2f %10.2f %12llu\n", layouts[l].name, double(counters.node_visits) / rays,
+                    double(counters.node_cache_lines) / rays, double(counters.node_pages) / rays, rays / results[l].seconds * 1e-6,
+                    (unsigned long long)results[l].mismatches);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    uint32_t frames = argc > 4 ? uint32_t(std::atoi(argv[4])) : 8;
+
+    TriangleMesh mesh = LoadMesh(path);
+    Blas built = Blas::Build(mesh, { .layout = BvhLayout::Build });
+    std::vector<Blas> blases;
+    std::printf("%s: %u triangles, %zu nodes\n\n", path, mesh.TriangleCount(), built.bvh.nodes.size());
+    std::printf("%-8s %10s %10s\n", "layout", "layout ms", "node KiB");
+    for (const auto& layout : layouts) {
+        blases.push_back(built);
+        auto start = std::chrono::steady_clock::now();
+        ReorderBvh(blases.back().bvh, layout.layout);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-8s %10.2f %10.1f\n", layout.name, ms, blases.back().bvh.nodes.size() * sizeof(BvhNode) / 1024.0);
+    }
+
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.5f);
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> uniform{ -1.0f, 1.0f };
+    std::vector<Ray> rays, bounces;
+    std::vector<Result> primary(blases.size()), bounce(blases.size());
+    uint64_t primary_count = 0, bounce_count = 0;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        camera.Rotate(2 * std::numbers::pi_v<float> / float(frames), 0);
+        GenerateFrame(ViewRays(camera, width, height), rays);
+        bounces.clear();
+        for (const Ray& ray : rays) {
+            Hit hit = built.Trace(ray);
+            if (hit.Missed()) {
+                continue;
+            }
+            float3 dir;
+            do {
+                dir = { uniform(rng), uniform(rng), uniform(rng) };
+            } while (Dot(dir, dir) > 1.0f || Dot(dir, dir) < 1e-4f);
+            bounces.push_back({ .origin = ray.origin + ray.dir * hit.t, .dir = Normalize(dir) });
+        }
+        TraceAll(blases, rays, primary);
+        TraceAll(blases, bounces, bounce);
+        primary_count += rays.size();
+        bounce_count += bounces.size();
+    }
+    Print("primary rays", primary, primary_count);
+    Print("bounce rays", bounce, bounce_count);
+    return 0;
+}
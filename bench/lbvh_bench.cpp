@@ -0,0 +1,124 @@
+// Build time against trace time: the binned SAH builder (FastTrace) next to the Morton LBVH (FastBuild)
+// usage: lbvh_bench [model] [copies] [width] [height] [repeats]
+// copies > 1 tiles the mesh on a grid like bvh_build_bench; the camera keeps looking at the first copy
+#include "bench_common.hpp"
+#include "cpu/blas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+void TileMesh(TriangleMesh& mesh, uint32_t copies)
+{
+    Aabb bounds;
+    for (auto& p : mesh.positions) {
+        bounds.Grow(p);
+    }
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(copies))));
+    uint32_t vertex_count = uint32_t(mesh.positions.size());
+    size_t index_count = mesh.indices.size();
+    float3 step = bounds.Extent() * 1.25f;
+    for (uint32_t c = 1; c < copies; ++c) {
+        float3 offset{ step.x * float(c % side), 0, step.z * float(c / side) };
+        for (uint32_t v = 0; v < vertex_count; ++v) {
+            mesh.positions.push_back(mesh.positions[v] + offset);
+        }
+        for (size_t i = 0; i < index_count; ++i) {
+            mesh.indices.push_back(mesh.indices[i] + c * vertex_count);
+        }
+    }
+}
+
+double BestBuildMs(std::span<const Aabb> bounds, const BvhBuildSettings& settings, uint32_t repeats)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        best = std::min(best, BuildBvh(bounds, settings).build_ms);
+    }
+    return best;
+}
+
+// best of repeats, milliseconds for one pass over rays
+double TraceMs(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits, uint32_t repeats)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); ++i) {
+            hits[i] = blas.Trace(rays[i]);
+        }
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t copies = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1;
+    uint32_t width = argc > 3 ? uint32_t(std::atoi(argv[3])) : 1280;
+    uint32_t height = argc > 4 ? uint32_t(std::atoi(argv[4])) : 720;
+    uint32_t repeats = argc > 5 ? uint32_t(std::atoi(argv[5])) : 5;
+
+    TriangleMesh mesh = LoadMesh(path);
+    if (copies > 1) {
+        TileMesh(mesh, copies);
+    }
+    std::vector<Aabb> bounds(mesh.TriangleCount());
+    for (uint32_t t = 0; t < bounds.size(); ++t) {
+        bounds[t] = mesh.TriangleBounds(t);
+    }
+    std::printf("%s x%u: %u triangles, best of %u\n\n", path, copies, mesh.TriangleCount(), repeats);
+
+    BvhBuildSettings sah;
+    BvhBuildSettings lbvh{ .mode = BvhBuildMode::FastBuild };
+    std::printf("%8s %12s %12s %8s\n", "threads", "SAH ms", "LBVH ms", "ratio");
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        sah.thread_count = lbvh.thread_count = threads;
+        double sah_ms = BestBuildMs(bounds, sah, repeats);
+        double lbvh_ms = BestBuildMs(bounds, lbvh, repeats);
+        std::printf("%8u %12.3f %12.3f %8.1f\n", threads, sah_ms, lbvh_ms, sah_ms / lbvh_ms);
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2; // always finish on the full machine
+        }
+    }
+
+    // trace quality, both trees built on the full machine
+    sah.thread_count = lbvh.thread_count = 0;
+    Blas sah_blas = Blas::Build(mesh, sah);
+    Blas lbvh_blas = Blas::Build(mesh, lbvh);
+    double sah_build = BestBuildMs(bounds, sah, repeats);
+    double lbvh_build = BestBuildMs(bounds, lbvh, repeats);
+    auto sah_stats = sah_blas.bvh.Stats(sah.traversal_cost);
+    auto lbvh_stats = lbvh_blas.bvh.Stats(lbvh.traversal_cost);
+    std::printf("\n%-6s %8s %8s %10s %10s\n", "tree", "nodes", "depth", "leaf size", "SAH cost");
+    std::printf("%-6s %8u %8u %10.2f %10.2f\n", "SAH", sah_stats.node_count, sah_stats.max_depth, sah_stats.average_leaf_size, sah_stats.sah_cost);
+    std::printf("%-6s %8u %8u %10.2f %10.2f\n", "LBVH", lbvh_stats.node_count, lbvh_stats.max_depth, lbvh_stats.average_leaf_size,
+                lbvh_stats.sah_cost);
+
+    w::Camera camera = MakeCamera(width, height);
+    std::vector<Ray> rays(size_t(width) * height);
+    std::vector<Hit> sah_hits(rays.size());
+    std::vector<Hit> lbvh_hits(rays.size());
+    std::printf("\n%ux%u primary rays, one thread; a frame is one rebuild and one trace\n", width, height);
+    std::printf("%-9s %12s %12s %10s %14s %14s\n", "view", "SAH Mrays/s", "LBVH Mrays/s", "mismatches", "SAH frame ms", "LBVH frame ms");
+    for (float zoom : { 0.0f, 6.0f }) {
+        camera.Zoom(zoom);
+        GenerateFrame(ViewRays(camera, width, height), rays);
+        double sah_trace = TraceMs(sah_blas, rays, sah_hits, repeats);
+        double lbvh_trace = TraceMs(lbvh_blas, rays, lbvh_hits, repeats);
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            mismatches += sah_hits[i].primitive != lbvh_hits[i].primitive;
+        }
+        std::printf("%-9s %12.2f %12.2f %10u %14.2f %14.2f\n", zoom == 0 ? "default" : "close-up", double(rays.size()) / sah_trace * 1e-3,
+                    double(rays.size()) / lbvh_trace * 1e-3, mismatches, sah_build + sah_trace, lbvh_build + lbvh_trace);
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+// Before/after numbers of the mesh optimization pass on the Snowman: vertex cache and fetch metrics, a brute force
+// primary ray trace over the triangle stream and closest hit attribute fetch in 8x8 tile order
+// usage: mesh_opt_bench [model] [resolution]
+#include <assimp/Importer.hpp>
+#include <assimp/config.h>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "mesh_optimizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+using DirectX::XMFLOAT3;
+
+struct Mesh {
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT3> normals;
+    std::vector<XMFLOAT3> texcoords;
+    std::vector<XMFLOAT3> tangents;
+    std::vector<uint32_t> indices; // global, submeshes are concatenated
+    std::vector<std::pair<uint32_t, uint32_t>> submeshes; // first index, vertex offset
+};
+
+struct Hit {
+    uint32_t triangle = ~0u;
+    float u = 0, v = 0;
+};
+
+XMFLOAT3 Sub(XMFLOAT3 a, XMFLOAT3 b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+XMFLOAT3 Cross(XMFLOAT3 a, XMFLOAT3 b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+float Dot(XMFLOAT3 a, XMFLOAT3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Mesh Load(const char* path)
+{
+    Assimp::Importer imp;
+    // same import as ModelLoader: points and lines are dropped, every mesh left is triangles only
+    imp.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+    const aiScene* scene = imp.ReadFile(path,
+                                        aiProcess_Triangulate |
+                                                aiProcess_SortByPType |
+                                                aiProcess_JoinIdenticalVertices |
+                                                aiProcess_ConvertToLeftHanded |
+                                                aiProcess_GenNormals |
+                                                aiProcess_CalcTangentSpace);
+    Mesh mesh;
+    if (!scene) {
+        return mesh;
+    }
+    auto append = [](std::vector<XMFLOAT3>& out, const aiVector3D* in, uint32_t count) {
+        if (in) {
+            out.insert(out.end(), (const XMFLOAT3*)in, (const XMFLOAT3*)in + count);
+        } else {
+            out.resize(out.size() + count, XMFLOAT3{});
+        }
+    };
+    for (uint32_t m = 0; m < scene->mNumMeshes; ++m) {
+        const aiMesh* in = scene->mMeshes[m];
+        if (!in->mNumVertices || !in->mNumFaces || !(in->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)) {
+            continue;
+        }
+        uint32_t base = uint32_t(mesh.positions.size());
+        mesh.submeshes.emplace_back(uint32_t(mesh.indices.size()), base);
+        append(mesh.positions, in->mVertices, in->mNumVertices);
+        append(mesh.normals, in->mNormals, in->mNumVertices);
+        append(mesh.texcoords, in->mTextureCoords[0], in->mNumVertices);
+        append(mesh.tangents, in->mTangents, in->mNumVertices);
+        // a face of any other size would shift every triangle after it, like in ModelLoader
+        for (uint32_t f = 0; f < in->mNumFaces; ++f) {
+            const aiFace& face = in->mFaces[f];
+            if (face.mNumIndices == 3) {
+                mesh.indices.insert(mesh.indices.end(), { base + face.mIndices[0], base + face.mIndices[1], base + face.mIndices[2] });
+            }
+        }
+    }
+    return mesh;
+}
+
+// same per submesh pass as ModelLoader::Import, indices are made local for the duration
+void Optimize(Mesh& mesh)
+{
+    for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+        auto [first, base] = mesh.submeshes[s];
+        uint32_t last = s + 1 < mesh.submeshes.size() ? mesh.submeshes[s + 1].first : uint32_t(mesh.indices.size());
+        uint32_t end = s + 1 < mesh.submeshes.size() ? mesh.submeshes[s + 1].second : uint32_t(mesh.positions.size());
+        auto indices = std::span{ mesh.indices }.subspan(first, last - first);
+        for (uint32_t& index : indices) {
+            index -= base;
+        }
+        auto stream = [&](std::vector<XMFLOAT3>& v) { return std::span{ v }.subspan(base, end - base); };
+        std::span<XMFLOAT3> attributes[]{ stream(mesh.normals), stream(mesh.texcoords), stream(mesh.tangents) };
+        w::OptimizeMesh(indices, stream(mesh.positions), attributes);
+        for (uint32_t& index : indices) {
+            index += base;
+        }
+    }
+}
+
+// Moller-Trumbore against every triangle in stream order, the index stream and vertex layout decide the access pattern
+Hit Trace(const Mesh& mesh, XMFLOAT3 origin, XMFLOAT3 dir)
+{
+    Hit hit;
+    float t_max = 1e30f;
+    for (uint32_t t = 0; t < mesh.indices.size() / 3; ++t) {
+        XMFLOAT3 a = mesh.positions[mesh.indices[t * 3 + 0]];
+        XMFLOAT3 e1 = Sub(mesh.positions[mesh.indices[t * 3 + 1]], a);
+        XMFLOAT3 e2 = Sub(mesh.positions[mesh.indices[t * 3 + 2]], a);
+        XMFLOAT3 p = Cross(dir, e2);
+        float det = Dot(e1, p);
+        if (std::abs(det) < 1e-12f) {
+            continue;
+        }
+        float inv = 1.0f / det;
+        XMFLOAT3 s = Sub(origin, a);
+        float u = Dot(s, p) * inv;
+        if (u < 0 || u > 1) {
+            continue;
+        }
+        XMFLOAT3 q = Cross(s, e1);
+        float v = Dot(dir, q) * inv;
+        if (v < 0 || u + v > 1) {
+            continue;
+        }
+        float dist = Dot(e2, q) * inv;
+        if (dist > 0 && dist < t_max) {
+            t_max = dist;
+            hit = { t, u, v };
+        }
+    }
+    return hit;
+}
+
+struct Result {
+    w::VertexCacheStats cache;
+    w::VertexFetchStats fetch;
+    double trace_ms = 0;
+    double shade_ns = 0; // per hit
+    double lines_per_tile = 0; // distinct 64 byte lines of vertex data touched by the hits of an 8x8 tile
+    float checksum = 0;
+};
+
+Result Run(const Mesh& mesh, uint32_t resolution)
+{
+    using clock = std::chrono::steady_clock;
+    Result result;
+    result.cache = w::AnalyzeVertexCache(mesh.indices, uint32_t(mesh.positions.size()));
+    result.fetch = w::AnalyzeVertexFetch(mesh.indices, uint32_t(mesh.positions.size()), sizeof(XMFLOAT3));
+
+    // frame the bounds from the front
+    XMFLOAT3 lo{ 1e30f, 1e30f, 1e30f }, hi{ -1e30f, -1e30f, -1e30f };
+    for (auto& p : mesh.positions) {
+        lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+        hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+    }
+    XMFLOAT3 center{ (lo.x + hi.x) / 2, (lo.y + hi.y) / 2, (lo.z + hi.z) / 2 };
+    float radius = std::sqrt(Dot(Sub(hi, lo), Sub(hi, lo))) / 2;
+    XMFLOAT3 origin{ center.x, center.y, center.z - radius * 2.0f };
+
+    // pixels are visited tile by tile like a GPU dispatch of 8x8 groups
+    std::vector<Hit> hits(size_t(resolution) * resolution);
+    auto start = clock::now();
+    for (uint32_t ty = 0; ty < resolution; ty += 8) {
+        for (uint32_t tx = 0; tx < resolution; tx += 8) {
+            for (uint32_t y = ty; y < std::min(ty + 8, resolution); ++y) {
+                for (uint32_t x = tx; x < std::min(tx + 8, resolution); ++x) {
+                    float px = (x + 0.5f) / resolution * 2 - 1;
+                    float py = 1 - (y + 0.5f) / resolution * 2;
+                    XMFLOAT3 dir{ px * 0.6f, py * 0.6f, 1.0f };
+                    float len = std::sqrt(Dot(dir, dir));
+                    hits[size_t(y) * resolution + x] = Trace(mesh, origin, { dir.x / len, dir.y / len, dir.z / len });
+                }
+            }
+        }
+    }
+    result.trace_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    // closest hit: interpolate every attribute of the hit triangle, as the hit shader does
+    auto shade = [&](const Hit& hit) {
+        float w0 = 1 - hit.u - hit.v;
+        float sum = 0;
+        for (auto* stream : { &mesh.normals, &mesh.texcoords, &mesh.tangents }) {
+            XMFLOAT3 a = (*stream)[mesh.indices[hit.triangle * 3 + 0]];
+            XMFLOAT3 b = (*stream)[mesh.indices[hit.triangle * 3 + 1]];
+            XMFLOAT3 c = (*stream)[mesh.indices[hit.triangle * 3 + 2]];
+            sum += (a.x * w0 + b.x * hit.u + c.x * hit.v) + (a.y * w0 + b.y * hit.u + c.y * hit.v) + (a.z * w0 + b.z * hit.u + c.z * hit.v);
+        }
+        return sum;
+    };
+    constexpr uint32_t shade_passes = 64;
+    size_t shaded = 0;
+    start = clock::now();
+    for (uint32_t pass = 0; pass < shade_passes; ++pass) {
+        for (auto& hit : hits) {
+            if (hit.triangle != ~0u) {
+                result.checksum += shade(hit);
+                shaded++;
+            }
+        }
+    }
+    result.shade_ns = shaded ? std::chrono::duration<double, std::nano>(clock::now() - start).count() / shaded : 0;
+
+    size_t tiles = 0;
+    size_t lines = 0;
+    std::unordered_set<uint64_t> touched;
+    for (uint32_t ty = 0; ty < resolution; ty += 8) {
+        for (uint32_t tx = 0; tx < resolution; tx += 8) {
+            touched.clear();
+            for (uint32_t y = ty; y < std::min(ty + 8, resolution); ++y) {
+                for (uint32_t x = tx; x < std::min(tx + 8, resolution); ++x) {
+                    auto& hit = hits[size_t(y) * resolution + x];
+                    for (uint32_t k = 0; hit.triangle != ~0u && k < 3; ++k) {
+                        touched.insert(uint64_t(mesh.indices[hit.triangle * 3 + k]) * sizeof(XMFLOAT3) / 64);
+                    }
+                }
+            }
+            if (!touched.empty()) {
+                tiles++;
+                lines += touched.size();
+            }
+        }
+    }
+    result.lines_per_tile = tiles ? double(lines) / tiles : 0;
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t resolution = argc > 2 ? uint32_t(std::atoi(argv[2])) : 128;
+
+    Mesh mesh = Load(path);
+    if (mesh.indices.empty()) {
+        std::printf("Failed to load %s\n", path);
+        return 1;
+    }
+    std::printf("%s: %zu vertices, %zu triangles, %ux%u primary rays\n", path, mesh.positions.size(), mesh.indices.size() / 3, resolution, resolution);
+    std::printf("%-10s %7s %7s %10s %10s %9s %14s %11s\n", "layout", "ACMR", "ATVR", "overfetch", "trace ms", "Mrays/s", "shade ns/hit", "lines/tile");
+
+    auto report = [&](const char* name, const Result& r) {
+        double rays = double(resolution) * resolution;
+        std::printf("%-10s %7.3f %7.3f %10.3f %10.1f %9.3f %14.2f %11.1f\n", name, r.cache.acmr, r.cache.atvr, r.fetch.overfetch,
+                    r.trace_ms, rays / r.trace_ms / 1000.0, r.shade_ns, r.lines_per_tile);
+    };
+    Result source = Run(mesh, resolution);
+    Optimize(mesh);
+    Result optimized = Run(mesh, resolution);
+    report("source", source);
+    report("optimized", optimized);
+    if (std::abs(source.checksum - optimized.checksum) > std::abs(source.checksum) * 1e-3f) {
+        std::printf("warning: shading differs between layouts (%f vs %f)\n", source.checksum, optimized.checksum);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Occlusion queries against closest hit traversal on the same shadow and ambient occlusion rays
+// usage: occlusion_bench [model] [width] [height] [frames] [repeats]
+// every primary hit of a camera orbiting the model sends a shadow ray to light at (0, 200, 0), as ClosestHit would,
+// and ao_rays short random rays. Closest hit counts a ray as occluded when it hits anything
+#include "bench_common.hpp"
+#include "cpu/reference_renderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+constexpr uint32_t ao_rays = 4; // per primary hit
+constexpr float ao_radius = 0.05f; // of the model's bounding box diagonal
+
+// best of repeats, in Mrays/s
+double Measure(uint32_t repeats, size_t ray_count, const std::function<void()>& trace)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        trace();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return double(ray_count) / best * 1e-6;
+}
+
+void Compare(const char* workload, const Blas& blas, std::span<const Ray> rays, uint32_t repeats)
+{
+    std::vector<Hit> hits(rays.size());
+    std::vector<uint8_t> occluded(rays.size());
+    blas.TracePackets(rays, hits);
+    size_t occluded_count = std::count_if(hits.begin(), hits.end(), [](const Hit& h) { return !h.Missed(); });
+    std::printf("\n%s, %zu rays, %.1f%% occluded\n", workload, rays.size(), 100.0 * double(occluded_count) / double(rays.size()));
+    std::printf("%-10s %14s %14s %8s %12s\n", "kernel", "closest Mr/s", "occluded Mr/s", "speedup", "mismatches");
+
+    auto mismatches = [&]() {
+        size_t count = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            count += occluded[i] != !hits[i].Missed();
+        }
+        return count;
+    };
+    double closest = Measure(repeats, rays.size(), [&]() {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            hits[i] = blas.Trace(rays[i]);
+        }
+    });
+    double occlusion = Measure(repeats, rays.size(), [&]() {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            occluded[i] = blas.Occluded(rays[i]);
+        }
+    });
+    std::printf("%-10s %14.2f %14.2f %8.2f %12zu\n", "scalar", closest, occlusion, occlusion / closest, mismatches());
+
+    for (auto isa : { SimdIsa::SSE, SimdIsa::AVX2, SimdIsa::AVX512 }) {
+        if (ClampSimdIsa(isa) != isa) {
+            std::printf("%-10s not supported by this CPU or build\n", SimdIsaName(isa).data());
+            continue;
+        }
+        PacketTraceSettings settings{ .isa = isa };
+        closest = Measure(repeats, rays.size(), [&]() { blas.TracePackets(rays, hits, settings); });
+        occlusion = Measure(repeats, rays.size(), [&]() { blas.OccludedPackets(rays, occluded, settings); });
+        std::printf("%-10s %14.2f %14.2f %8.2f %12zu\n", SimdIsaName(isa).data(), closest, occlusion, occlusion / closest, mismatches());
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1920;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 1080;
+    uint32_t frames = argc > 4 ? uint32_t(std::atoi(argv[4])) : 4;
+    uint32_t repeats = argc > 5 ? uint32_t(std::atoi(argv[5])) : 3;
+
+    Blas blas = Blas::Build(LoadMesh(path));
+    float radius = ao_radius * Length(blas.bvh.nodes[0].Bounds().Extent());
+    std::printf("%s, %ux%u, %u frames, one thread\n", path, width, height, frames);
+
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.5f);
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> uniform{ -1.0f, 1.0f };
+    std::vector<Ray> primary, shadow, ambient;
+    std::vector<uint32_t> pixels;
+    std::vector<Hit> hits;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        camera.Rotate(2 * std::numbers::pi_v<float> / float(frames), 0);
+        ViewRays(camera, width, height).GenerateTiled(8, 8, primary, pixels);
+        hits.resize(primary.size());
+        blas.TracePackets(primary, hits);
+        for (size_t i = 0; i < primary.size(); ++i) {
+            if (hits[i].Missed()) {
+                continue;
+            }
+            float3 p = primary[i].origin + primary[i].dir * hits[i].t;
+            float3 to_light = light - p;
+            float distance = Length(to_light);
+            shadow.push_back({ .origin = p, .dir = to_light * (1.0f / distance), .t_max = distance });
+            for (uint32_t k = 0; k < ao_rays; ++k) {
+                float3 dir;
+                do {
+                    dir = { uniform(rng), uniform(rng), uniform(rng) };
+                } while (Dot(dir, dir) > 1.0f || Dot(dir, dir) < 1e-4f);
+                ambient.push_back({ .origin = p, .dir = Normalize(dir), .t_max = radius });
+            }
+        }
+    }
+    Compare("shadow rays to light", blas, shadow, repeats);
+    Compare("ambient occlusion rays", blas, ambient, repeats);
+    return 0;
+}
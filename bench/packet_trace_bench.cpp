@@ -0,0 +1,92 @@
+// Primary ray throughput of the CPU packet kernels against one ray at a time, over the Snowman BVH
+// usage: packet_trace_bench [model] [width] [height] [repeats]
+// rays are the ones RayGeneration shoots, ordered in screen tiles of one packet each. Two views: the default
+// camera, where the model covers a few percent of the frame, and a close-up where it fills most of it
+#include "bench_common.hpp"
+#include "cpu/blas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+// best of repeats, in Mrays/s
+double Measure(uint32_t repeats, size_t ray_count, const std::function<void()>& trace)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        trace();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return double(ray_count) / best * 1e-6;
+}
+
+void RunView(const w::cpu::Blas& blas, const w::cpu::PrimaryRays& generator, uint32_t repeats)
+{
+    using namespace w::cpu;
+    std::vector<Ray> rays;
+    std::vector<uint32_t> pixels;
+    generator.GenerateTiled(4, 2, rays, pixels);
+    std::vector<Hit> reference(rays.size());
+    double scalar = Measure(repeats, rays.size(), [&]() {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            reference[i] = blas.Trace(rays[i]);
+        }
+    });
+    std::vector<uint32_t> reference_by_pixel(rays.size());
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        reference_by_pixel[pixels[i]] = reference[i].primitive;
+    }
+    size_t hit_count = std::count_if(reference.begin(), reference.end(), [](const Hit& h) { return !h.Missed(); });
+    std::printf("%.1f%% of the rays hit\n", 100.0 * double(hit_count) / double(rays.size()));
+    std::printf("%-10s %6s %10s %10s %8s %10s\n", "kernel", "width", "culling", "Mrays/s", "speedup", "mismatches");
+    std::printf("%-10s %6u %10s %10.2f %8.2f %10u\n", "scalar", 1, "-", scalar, 1.0, 0);
+
+    for (auto isa : { SimdIsa::SSE, SimdIsa::AVX2, SimdIsa::AVX512 }) {
+        if (ClampSimdIsa(isa) != isa) {
+            std::printf("%-10s not supported by this CPU or build\n", SimdIsaName(isa).data());
+            continue;
+        }
+        uint32_t packet = PacketWidth(isa);
+        std::vector<Ray> packet_rays;
+        std::vector<uint32_t> packet_pixels;
+        generator.GenerateTiled(4, packet / 4, packet_rays, packet_pixels);
+        std::vector<Hit> hits(packet_rays.size());
+        for (bool culling : { false, true }) {
+            PacketTraceSettings settings{ .isa = isa, .interval_culling = culling };
+            double mrays = Measure(repeats, packet_rays.size(), [&]() { blas.TracePackets(packet_rays, hits, settings); });
+
+            // packet tiles differ from the scalar order, compare per pixel
+            uint32_t mismatches = 0;
+            for (size_t i = 0; i < packet_pixels.size(); ++i) {
+                mismatches += reference_by_pixel[packet_pixels[i]] != hits[i].primitive;
+            }
+            std::printf("%-10s %6u %10s %10.2f %8.2f %10u\n", SimdIsaName(isa).data(), packet, culling ? "interval" : "off", mrays,
+                        mrays / scalar, mismatches);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace w::cpu;
+    using namespace w::bench;
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1280;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 720;
+    uint32_t repeats = argc > 4 ? uint32_t(std::atoi(argv[4])) : 5;
+
+    Blas blas = Blas::Build(LoadMesh(path));
+    std::printf("%s: %zu triangles, %zu nodes, %ux%u primary rays, best of %u, widest kernel %s\n", path, blas.triangles.size(),
+                blas.bvh.nodes.size(), width, height, repeats, SimdIsaName(DetectSimdIsa()).data());
+
+    w::Camera camera = MakeCamera(width, height);
+    for (float zoom : { 0.0f, 6.0f }) {
+        camera.Zoom(zoom);
+        std::printf("\n%s view: ", zoom == 0 ? "default" : "close-up");
+        RunView(blas, ViewRays(camera, width, height), repeats);
+    }
+    return 0;
+}
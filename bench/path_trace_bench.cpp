@@ -0,0 +1,79 @@
+// Wavefront against megakernel path tracing over bounce depth: rays per second, time per wavefront stage and
+// how far the two images drift apart
+// usage: path_trace_bench [model] [width] [height] [samples per pixel]
+// one thread and one image sized tile, so the wavefront queues hold every path of the frame
+#include "bench_common.hpp"
+#include "cpu/path_tracer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+struct Result {
+    PathTraceStats stats;
+    double ms = HUGE_VAL;
+};
+
+Result Render(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, std::span<uint32_t> image,
+              const PathTraceSettings& settings, uint32_t repeats)
+{
+    Result result;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        PathTraceStats stats = RenderPaths(blas, mesh, camera, image, settings);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms < result.ms) {
+            result = { stats, ms };
+        }
+    }
+    return result;
+}
+
+double MraysPerSecond(const Result& result)
+{
+    return double(result.stats.extension_rays + result.stats.shadow_rays) / result.ms * 1e-3;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    uint32_t samples = argc > 4 ? uint32_t(std::atoi(argv[4])) : 4;
+    constexpr uint32_t repeats = 3;
+
+    TriangleMesh mesh = LoadMesh(path);
+    Blas blas = Blas::Build(mesh);
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.5f);
+    PrimaryRays rays = ViewRays(camera, width, height);
+
+    std::printf("%s: %u triangles, %ux%u, %u spp, %s, one thread, best of %u\n", path, mesh.TriangleCount(), width, height, samples,
+                SimdIsaName(DetectSimdIsa()).data(), repeats);
+    std::printf("%8s %12s %12s %8s %10s %10s %10s %10s %12s\n", "bounces", "mega Mray/s", "wave Mray/s", "speedup", "generate",
+                "extend", "shade", "shadow", "mean diff");
+    std::vector<uint32_t> mega_image(size_t(width) * height), wave_image(size_t(width) * height);
+    for (uint32_t bounces : { 1u, 2u, 4u, 8u, 16u }) {
+        PathTraceSettings settings{ .max_bounces = bounces, .samples_per_pixel = samples };
+        settings.kernel = PathKernel::Megakernel;
+        Result mega = Render(blas, mesh, rays, mega_image, settings, repeats);
+        settings.kernel = PathKernel::Wavefront;
+        Result wave = Render(blas, mesh, rays, wave_image, settings, repeats);
+
+        // both kernels draw the same numbers, differences come from packet and single ray traversal breaking ties apart
+        double diff = 0;
+        for (size_t i = 0; i < wave_image.size(); ++i) {
+            for (uint32_t shift = 0; shift < 24; shift += 8) {
+                diff += std::abs(int(wave_image[i] >> shift & 0xff) - int(mega_image[i] >> shift & 0xff));
+            }
+        }
+        std::printf("%8u %12.2f %12.2f %8.2f %10.2f %10.2f %10.2f %10.2f %12.4f\n", bounces, MraysPerSecond(mega), MraysPerSecond(wave),
+                    mega.ms / wave.ms, wave.stats.generate_ms, wave.stats.extend_ms, wave.stats.shade_ms, wave.stats.shadow_ms,
+                    diff / double(wave_image.size() * 3));
+    }
+    return 0;
+}
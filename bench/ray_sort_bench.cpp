@@ -0,0 +1,115 @@
+// When sorting incoherent rays pays for itself: RaySorter cost against the packet traversal time it saves
+// usage: ray_sort_bench [model] [width] [height] [frames] [sort threads]
+// bounce rays leave every primary hit in a random direction. In pixel order they still share origins with their
+// neighbours like the first bounce of the wavefront, shuffled they stand in for the later bounces.
+// The last table runs the wavefront path tracer with and without PathTraceSettings::sort_rays
+#include "bench_common.hpp"
+#include "cpu/path_tracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+constexpr uint32_t repeats = 3;
+
+template<typename F>
+double BestMs(F&& f)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void SortTable(const char* workload, const Blas& blas, std::span<const Ray> rays, uint32_t threads)
+{
+    std::vector<Hit> hits(rays.size());
+    double unsorted = BestMs([&] { blas.TracePackets(rays, hits); });
+    std::printf("\n%s, %zu rays, unsorted trace %.2f ms\n", workload, rays.size(), unsorted);
+    std::printf("%12s %10s %10s %10s %10s %8s\n", "origin bits", "sort ms", "trace ms", "saved ms", "net ms", "pays");
+
+    std::vector<uint32_t> order;
+    std::vector<Ray> sorted(rays.size());
+    std::vector<Hit> sorted_hits(rays.size());
+    for (uint32_t bits = 4; bits <= 9; ++bits) {
+        RaySorter sorter{ { .origin_bits = bits, .thread_count = threads } };
+        // sorting includes the gather before and the scatter after traversal, as in the wavefront
+        double sort_ms = BestMs([&] {
+            sorter.Sort(rays, order);
+            for (size_t i = 0; i < order.size(); ++i) {
+                sorted[i] = rays[order[i]];
+            }
+            for (size_t i = 0; i < order.size(); ++i) {
+                hits[order[i]] = sorted_hits[i];
+            }
+        });
+        double trace_ms = BestMs([&] { blas.TracePackets(sorted, sorted_hits); });
+        double saved = unsorted - trace_ms;
+        std::printf("%12u %10.2f %10.2f %10.2f %10.2f %8s\n", bits, sort_ms, trace_ms, saved, saved - sort_ms, saved > sort_ms ? "yes" : "no");
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    uint32_t frames = argc > 4 ? uint32_t(std::atoi(argv[4])) : 4;
+    uint32_t threads = argc > 5 ? uint32_t(std::atoi(argv[5])) : 1;
+
+    TriangleMesh mesh = LoadMesh(path);
+    Blas blas = Blas::Build(mesh);
+    std::printf("%s: %u triangles, %s packets, %u sort threads\n", path, mesh.TriangleCount(), SimdIsaName(DetectSimdIsa()).data(), threads);
+
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.5f);
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> uniform{ -1.0f, 1.0f };
+    std::vector<Ray> bounces;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        camera.Rotate(2 * std::numbers::pi_v<float> / float(frames), 0);
+        PrimaryRays generator = ViewRays(camera, width, height);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                Ray ray = generator.Generate(x, y);
+                Hit hit = blas.Trace(ray);
+                if (hit.Missed()) {
+                    continue;
+                }
+                float3 dir;
+                do {
+                    dir = { uniform(rng), uniform(rng), uniform(rng) };
+                } while (Dot(dir, dir) > 1.0f || Dot(dir, dir) < 1e-4f);
+                bounces.push_back({ .origin = ray.origin + ray.dir * hit.t, .dir = Normalize(dir) });
+            }
+        }
+    }
+    SortTable("bounce rays in pixel order", blas, bounces, threads);
+    std::shuffle(bounces.begin(), bounces.end(), rng);
+    SortTable("bounce rays shuffled", blas, bounces, threads);
+
+    PrimaryRays rays = ViewRays(camera, width, height);
+    std::vector<uint32_t> image(size_t(width) * height);
+    std::printf("\nwavefront path tracing, 4 spp, one image sized tile\n");
+    std::printf("%8s %14s %14s %10s %10s %10s\n", "bounces", "unsorted ms", "sorted ms", "sort ms", "saved ms", "pays");
+    for (uint32_t max_bounces : { 2u, 4u, 8u }) {
+        PathTraceSettings settings{ .max_bounces = max_bounces, .samples_per_pixel = 4, .sort = { .thread_count = threads } };
+        PathTraceStats unsorted, sorted;
+        double unsorted_ms = BestMs([&] { unsorted = RenderPaths(blas, mesh, rays, image, settings); });
+        settings.sort_rays = true;
+        double sorted_ms = BestMs([&] { sorted = RenderPaths(blas, mesh, rays, image, settings); });
+        double saved = unsorted.extend_ms + unsorted.shadow_ms - sorted.extend_ms - sorted.shadow_ms;
+        std::printf("%8u %14.2f %14.2f %10.2f %10.2f %10s\n", max_bounces, unsorted_ms, sorted_ms, sorted.sort_ms, saved,
+                    saved > sorted.sort_ms ? "yes" : "no");
+    }
+    return 0;
+}
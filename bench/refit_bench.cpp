@@ -0,0 +1,83 @@
+// Refit against rebuild on a deforming Snowman: the mesh twists around its vertical axis a little more every frame
+// usage: refit_bench [model] [frames] [threshold] [width] [height]
+// every frame prints the update time and SAH cost of DynamicBlas, and its trace speed next to a fresh SAH build
+#include "bench_common.hpp"
+#include "cpu/dynamic_blas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+double TraceMs(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rays.size(); ++i) {
+        hits[i] = blas.Trace(rays[i]);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t frames = argc > 2 ? uint32_t(std::atoi(argv[2])) : 32;
+    float threshold = argc > 3 ? float(std::atof(argv[3])) : 1.3f;
+    uint32_t width = argc > 4 ? uint32_t(std::atoi(argv[4])) : 640;
+    uint32_t height = argc > 5 ? uint32_t(std::atoi(argv[5])) : 360;
+
+    w::ModelLoader model(path);
+    DynamicBlas dynamic{ TriangleMesh::FromModel(model), { .rebuild_threshold = threshold } };
+    float y_lo = HUGE_VALF, y_hi = -HUGE_VALF;
+    for (auto& v : model.vertices) {
+        y_lo = std::min(y_lo, v.y);
+        y_hi = std::max(y_hi, v.y);
+    }
+
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.0f);
+    std::vector<Ray> rays;
+    GenerateFrame(ViewRays(camera, width, height), rays);
+    std::vector<Hit> hits(rays.size());
+    std::vector<Hit> reference(rays.size());
+
+    std::printf("%s: %u triangles, %u frames, rebuild past %.2fx the built SAH cost, %ux%u rays\n", path,
+                dynamic.Mesh().TriangleCount(), frames, threshold, width, height);
+    std::printf("%6s %8s %10s %10s %10s %12s %12s %10s\n", "frame", "update", "update ms", "build ms", "SAH cost", "fresh cost",
+                "trace ratio", "mismatches");
+    std::vector<DirectX::XMFLOAT3> vertices(model.vertices.begin(), model.vertices.end());
+    double refit_ms = 0, rebuild_ms = 0;
+    uint32_t rebuilds = 0;
+    for (uint32_t frame = 1; frame <= frames; ++frame) {
+        // twist grows with height and time, the top spins a quarter turn further every 8 frames
+        float turns = 0.25f * float(frame) / 8.0f;
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const auto& v = model.vertices[i];
+            float angle = 2 * std::numbers::pi_v<float> * turns * (v.y - y_lo) / (y_hi - y_lo);
+            float c = std::cos(angle), s = std::sin(angle);
+            vertices[i] = { v.x * c - v.z * s, v.y, v.x * s + v.z * c };
+        }
+
+        BlasUpdate update = dynamic.Update(vertices);
+        (update == BlasUpdate::Rebuild ? rebuild_ms : refit_ms) += dynamic.UpdateMs();
+        rebuilds += update == BlasUpdate::Rebuild;
+
+        Blas fresh = Blas::Build(dynamic.Mesh());
+        double dynamic_trace = TraceMs(dynamic.Get(), rays, hits);
+        double fresh_trace = TraceMs(fresh, rays, reference);
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            mismatches += hits[i].primitive != reference[i].primitive;
+        }
+        std::printf("%6u %8s %10.3f %10.3f %10.2f %12.2f %12.2f %10u\n", frame, update == BlasUpdate::Rebuild ? "rebuild" : "refit",
+                    dynamic.UpdateMs(), fresh.bvh.build_ms, dynamic.SahCost(), fresh.bvh.Stats().sah_cost, dynamic_trace / fresh_trace,
+                    mismatches);
+    }
+    uint32_t refits = frames - rebuilds;
+    std::printf("\n%u refits at %.3f ms, %u rebuilds at %.3f ms on average\n", refits, refits ? refit_ms / refits : 0.0, rebuilds,
+                rebuilds ? rebuild_ms / rebuilds : 0.0);
+    return 0;
+}
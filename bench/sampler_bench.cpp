@@ -0,0 +1,133 @@
+// Texture sampler throughput on the lookups of a camera looking over a textured ground plane
+// usage: sampler_bench [texture size] [width] [height] [repeats]
+// every pixel that sees the plane y = 0 samples a procedural RGBA8 texture repeated every world unit: with the ray cone
+// level of detail, with ray differentials, with differentials and 16x anisotropy, and once more at random coordinates.
+// The scalar row is the reference, kernels report their largest channel difference to it
+#include "cpu/texture_sampler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numbers>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+
+constexpr float eye_height = 1.0f;
+constexpr float tilt = 0.3f; // radians below the horizon
+constexpr float fov = std::numbers::pi_v<float> / 3.0f; // vertical
+
+// best of repeats, in Mlookups/s
+double Measure(uint32_t repeats, size_t count, const std::function<void()>& sample)
+{
+    double best = HUGE_VAL;
+    for (uint32_t r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        sample();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return double(count) / best * 1e-6;
+}
+
+// checkers over a diagonal ramp, so every level and every channel has something to filter
+std::vector<uint32_t> MakeTexture(uint32_t size)
+{
+    std::vector<uint32_t> texels(size_t(size) * size);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint32_t check = ((x / 8) ^ (y / 8)) & 1 ? 0xe0 : 0x20;
+            uint32_t ramp = (x + y) * 255 / (2 * size - 1);
+            texels[size_t(y) * size + x] = 0xffu << 24 | ramp << 16 | (255 - check) << 8 | check;
+        }
+    }
+    return texels;
+}
+
+// sample(sampler, out) runs one batch
+void Compare(const char* workload, size_t count, uint32_t max_anisotropy, uint32_t repeats,
+             const std::function<void(const TextureSampler&, std::span<Rgba>)>& sample)
+{
+    std::printf("\n%s, %zu lookups\n", workload, count);
+    std::printf("%-10s %12s %10s %12s\n", "kernel", "Mlookups/s", "speedup", "max diff");
+    std::vector<Rgba> reference(count), out(count);
+    TextureSampler scalar{ { .max_anisotropy = max_anisotropy, .isa = SimdIsa::Scalar } };
+    double base = Measure(repeats, count, [&]() { sample(scalar, reference); });
+    std::printf("%-10s %12.2f %10.2f %12s\n", "scalar", base, 1.0, "-");
+
+    for (auto isa : { SimdIsa::SSE, SimdIsa::AVX2, SimdIsa::AVX512 }) {
+        if (ClampSimdIsa(isa) != isa) {
+            std::printf("%-10s not supported by this CPU or build\n", SimdIsaName(isa).data());
+            continue;
+        }
+        TextureSampler sampler{ { .max_anisotropy = max_anisotropy, .isa = isa } };
+        double rate = Measure(repeats, count, [&]() { sample(sampler, out); });
+        float diff = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const Rgba& a = out[i];
+            const Rgba& b = reference[i];
+            diff = std::max({ diff, std::fabs(a.r - b.r), std::fabs(a.g - b.g), std::fabs(a.b - b.b), std::fabs(a.a - b.a) });
+        }
+        std::printf("%-10s %12.2f %10.2f %12.3g\n", SimdIsaName(isa).data(), rate, rate / base, diff);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t size = argc > 1 ? uint32_t(std::atoi(argv[1])) : 1024;
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1920;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 1080;
+    uint32_t repeats = argc > 4 ? uint32_t(std::atoi(argv[4])) : 5;
+
+    TiledTexture texture = TiledTexture::FromRgba8(MakeTexture(size), size, size);
+    std::printf("%ux%u texture, %u levels, %ux%u view, one thread\n", size, size, texture.LevelCount(), width, height);
+
+    // pinhole camera at eye_height looking down by tilt, uv = world xz
+    float3 eye{ 0, eye_height, 0 };
+    float3 forward{ 0, -std::sin(tilt), std::cos(tilt) };
+    float3 up{ 0, std::cos(tilt), std::sin(tilt) };
+    float3 right{ 1, 0, 0 };
+    float pixel_size = 2.0f * std::tan(fov * 0.5f) / float(height);
+    auto plane = [&](float x, float y, float3& dir, float& t) {
+        dir = Normalize(forward + right * ((x - 0.5f * float(width)) * pixel_size) - up * ((y - 0.5f * float(height)) * pixel_size));
+        t = dir.y < -1e-4f ? -eye.y / dir.y : HUGE_VALF; // near the horizon uv runs off to infinity
+        return eye + dir * t;
+    };
+    // a unit of world space is a unit of uv: the same texel density over the whole plane
+    float triangle_lod = TriangleLod({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, 0, 0, 1, 0, 0, 1, size, size);
+
+    std::vector<LevelLookup> cones;
+    std::vector<GradLookup> differentials;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            float3 dir, dir_x, dir_y;
+            float t, t_x, t_y;
+            float3 p = plane(float(x) + 0.5f, float(y) + 0.5f, dir, t);
+            float3 p_x = plane(float(x) + 1.5f, float(y) + 0.5f, dir_x, t_x);
+            float3 p_y = plane(float(x) + 0.5f, float(y) + 1.5f, dir_y, t_y);
+            if (t == HUGE_VALF || t_x == HUGE_VALF || t_y == HUGE_VALF) {
+                continue; // the pixel or a neighbour sees the sky
+            }
+            cones.push_back({ .u = p.x, .v = p.z, .lod = RayConeLod(triangle_lod, pixel_size * t, dir.y) });
+            differentials.push_back({ .u = p.x, .v = p.z, .du_dx = p_x.x - p.x, .dv_dx = p_x.z - p.z, .du_dy = p_y.x - p.x, .dv_dy = p_y.z - p.z });
+        }
+    }
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> coordinate{ -64.0f, 64.0f };
+    std::uniform_real_distribution<float> lod{ 0.0f, float(texture.LevelCount() - 1) };
+    std::vector<LevelLookup> scattered(cones.size());
+    for (auto& lookup : scattered) {
+        lookup = { .u = coordinate(rng), .v = coordinate(rng), .lod = lod(rng) };
+    }
+
+    Compare("ray cones, trilinear", cones.size(), 1, repeats, [&](const TextureSampler& s, std::span<Rgba> out) { s.SampleLevel(texture, cones, out); });
+    Compare("ray differentials, trilinear", differentials.size(), 1, repeats,
+            [&](const TextureSampler& s, std::span<Rgba> out) { s.SampleGrad(texture, differentials, out); });
+    Compare("ray differentials, 16x anisotropic", differentials.size(), 16, repeats,
+            [&](const TextureSampler& s, std::span<Rgba> out) { s.SampleGrad(texture, differentials, out); });
+    Compare("random coordinates and levels", scattered.size(), 1, repeats,
+            [&](const TextureSampler& s, std::span<Rgba> out) { s.SampleLevel(texture, scattered, out); });
+    return 0;
+}
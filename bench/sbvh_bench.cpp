@@ -0,0 +1,109 @@
+// Spatial splits against plain binned SAH: duplicated references, traversal steps and trace speed
+// usage: sbvh_bench [model | slivers] [width] [height] [frames]
+// rays come from a camera orbiting the model close up, the same path for every tree. slivers replaces the model with
+// long thin triangles diagonal to every axis, the case spatial splits are for
+#include "bench_common.hpp"
+#include "cpu/blas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+struct Result {
+    TraversalCounters counters;
+    double seconds = 0;
+    uint64_t mismatches = 0;
+};
+
+// count slivers half a unit long and a hundredth wide at random points of a box around the origin, all along the
+// diagonal of the box: the bounds of each are a mostly empty cube overlapping many others
+TriangleMesh Slivers(uint32_t count)
+{
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> position{ -1.0f, 1.0f };
+    float3 along = Normalize(float3{ 1, 1, 1 }) * 0.5f;
+    float3 across = Normalize(float3{ 1, -1, 0 }) * 0.01f;
+    TriangleMesh mesh;
+    for (uint32_t i = 0; i < count; ++i) {
+        float3 a{ position(rng), position(rng), position(rng) };
+        mesh.positions.insert(mesh.positions.end(), { a, a + along, a + across });
+        mesh.indices.insert(mesh.indices.end(), { 3 * i, 3 * i + 1, 3 * i + 2 });
+    }
+    return mesh;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    uint32_t frames = argc > 4 ? uint32_t(std::atoi(argv[4])) : 8;
+
+    TriangleMesh mesh = std::strcmp(path, "slivers") == 0 ? Slivers(4096) : LoadMesh(path);
+    struct Variant {
+        const char* name;
+        BvhBuildSettings settings;
+    };
+    Variant variants[]{
+        { "SAH", {} },
+        { "SBVH 10%", { .mode = BvhBuildMode::SpatialSplits, .reference_budget = 0.1f } },
+        { "SBVH 30%", { .mode = BvhBuildMode::SpatialSplits, .reference_budget = 0.3f } },
+        { "SBVH 100%", { .mode = BvhBuildMode::SpatialSplits, .reference_budget = 1.0f } },
+    };
+    std::vector<Blas> blases;
+    std::printf("%s: %u triangles\n\n", path, mesh.TriangleCount());
+    std::printf("%-10s %10s %8s %10s %12s %10s\n", "tree", "build ms", "nodes", "references", "duplicated", "SAH cost");
+    for (const auto& variant : variants) {
+        blases.push_back(Blas::Build(mesh, variant.settings));
+        const Bvh& bvh = blases.back().bvh;
+        auto stats = bvh.Stats();
+        std::printf("%-10s %10.2f %8u %10zu %11.1f%% %10.2f\n", variant.name, bvh.build_ms, stats.node_count, bvh.references.size(),
+                    100.0 * double(bvh.references.size() - mesh.TriangleCount()) / mesh.TriangleCount(), stats.sah_cost);
+    }
+
+    w::Camera camera = MakeCamera(width, height);
+    camera.Zoom(5.5f);
+    std::vector<Ray> rays(size_t(width) * height);
+    std::vector<Hit> reference(rays.size());
+    std::vector<Result> results(blases.size());
+    uint64_t hit_count = 0;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        camera.Rotate(2 * std::numbers::pi_v<float> / float(frames), 0);
+        GenerateFrame(ViewRays(camera, width, height), rays);
+        for (size_t v = 0; v < blases.size(); ++v) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < rays.size(); ++i) {
+                Hit hit = blases[v].Trace(rays[i]);
+                if (v == 0) {
+                    reference[i] = hit;
+                    hit_count += !hit.Missed();
+                }
+                results[v].mismatches += hit.primitive != reference[i].primitive;
+            }
+            results[v].seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (const Ray& ray : rays) {
+                blases[v].Trace(ray, results[v].counters);
+            }
+        }
+    }
+
+    double ray_count = double(rays.size()) * frames;
+    double base_steps = double(results[0].counters.node_visits);
+    double base_tests = double(results[0].counters.triangle_tests);
+    std::printf("\n%ux%u rays over %u frames, %.1f%% hit, one thread\n", width, height, frames, 100.0 * double(hit_count) / ray_count);
+    std::printf("%-10s %12s %10s %12s %10s %10s %12s\n", "tree", "nodes/ray", "vs SAH", "tris/ray", "vs SAH", "Mrays/s", "mismatches");
+    for (size_t v = 0; v < blases.size(); ++v) {
+        const auto& counters = results[v].counters;
+        std::printf("%-10s %12.2f %9.1f%% %12.2f %9.1f%% %10.2f %12llu\n", variants[v].name, double(counters.node_visits) / ray_count,
+                    100.0 * (double(counters.node_visits) / base_steps - 1), double(counters.triangle_tests) / ray_count,
+                    100.0 * (double(counters.triangle_tests) / base_tests - 1), ray_count / results[v].seconds * 1e-6,
+                    (unsigned long long)results[v].mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Scaling of the tiled CPU reference render over 1..N threads, with and without work stealing
+// usage: tile_scaling_bench [width height] [tile_size] [pin] [repeats]
+// the default camera leaves most tiles to Miss, so a static split is badly balanced
+#include "bench_common.hpp"
+#include "cpu/reference_renderer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    using namespace w::cpu;
+    using namespace w::bench;
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[1])) : 1920;
+    uint32_t height = argc > 2 ? uint32_t(std::atoi(argv[2])) : 1080;
+    uint32_t tile_size = argc > 3 ? uint32_t(std::atoi(argv[3])) : 16;
+    bool pin = argc > 4 && std::atoi(argv[4]) != 0;
+    uint32_t repeats = argc > 5 ? uint32_t(std::atoi(argv[5])) : 5;
+
+    Blas blas = Blas::Build(LoadMesh("assets/SnowmanOBJ.obj"));
+    w::Camera camera = MakeCamera(width, height);
+    PrimaryRays rays = ViewRays(camera, width, height);
+    std::vector<uint32_t> image(size_t(width) * height);
+
+    std::printf("%ux%u, %ux%u tiles, %s packets, threads %s, best of %u\n", width, height, tile_size, tile_size,
+                SimdIsaName(DetectSimdIsa()).data(), pin ? "pinned" : "floating", repeats);
+    std::printf("%8s %10s %10s %8s %10s %8s %10s\n", "threads", "stealing", "frame ms", "speedup", "efficiency", "stolen",
+                "imbalance");
+
+    double single = 0;
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        for (bool stealing : { true, false }) {
+            TileScheduler scheduler{ { .thread_count = threads, .tile_width = tile_size, .tile_height = tile_size,
+                                       .pin_threads = pin, .work_stealing = stealing } };
+            RenderFrame(blas, rays, image, scheduler); // warm up caches and wake the workers once
+
+            double best = HUGE_VAL;
+            std::vector<TileThreadStats> stats;
+            for (uint32_t r = 0; r < repeats; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                RenderFrame(blas, rays, image, scheduler);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (ms < best) {
+                    best = ms;
+                    stats = scheduler.Stats();
+                }
+            }
+            if (threads == 1 && stealing) {
+                single = best;
+            }
+
+            // busiest worker against the average, 1.0 is a perfect split
+            uint32_t stolen = 0;
+            double busiest = 0, total = 0;
+            for (auto& s : stats) {
+                stolen += s.stolen;
+                busiest = std::max(busiest, s.busy_ms);
+                total += s.busy_ms;
+            }
+            double imbalance = total > 0 ? busiest / (total / double(stats.size())) : 1.0;
+            if (single > 0) {
+                std::printf("%8u %10s %10.2f %8.2f %9.0f%% %8u %10.2f\n", threads, stealing ? "on" : "off", best, single / best,
+                            100.0 * single / best / double(threads), stolen, imbalance);
+            } else {
+                std::printf("%8u %10s %10.2f %8s %10s %8u %10.2f\n", threads, stealing ? "on" : "off", best, "-", "-", stolen, imbalance);
+            }
+        }
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2; // always finish on the full machine
+        }
+    }
+    return 0;
+}
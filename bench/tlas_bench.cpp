@@ -0,0 +1,129 @@
+// Two-level structure over a grid of Snowman instances: build time, memory per instance and trace speed
+// usage: tlas_bench [instances] [width] [height] [model]
+// instances get a random yaw and scale and one of 8 mask bits; sampled rays are checked against a brute force walk
+#include "bench_common.hpp"
+#include "cpu/tlas.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+
+namespace {
+using namespace w::cpu;
+using namespace w::bench;
+
+constexpr float spacing = 2.5f; // the Snowman is about 1.6 units across
+
+std::vector<Instance> MakeGrid(uint32_t count)
+{
+    std::mt19937 rng{ 227 };
+    std::uniform_real_distribution<float> yaw{ 0, 2 * std::numbers::pi_v<float> };
+    std::uniform_real_distribution<float> scale{ 0.75f, 1.25f };
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(count))));
+    std::vector<Instance> instances(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        float a = yaw(rng), s = scale(rng);
+        float c = std::cos(a) * s, n = std::sin(a) * s;
+        instances[i] = { .transform = { { { c, 0, n, float(i % side) * spacing }, { 0, s, 0, 0 }, { -n, 0, c, float(i / side) * spacing } } },
+                         .instance_id = i,
+                         .mask = 1u << (i % 8),
+                         .blas = 0 };
+    }
+    return instances;
+}
+
+// pinhole camera standing at a corner of the grid and looking across it
+std::vector<Ray> GridView(uint32_t width, uint32_t height, float grid_size)
+{
+    float3 origin{ -4, 3, -4 };
+    float3 forward = Normalize(float3{ grid_size * 0.5f, 0, grid_size * 0.5f } - origin);
+    float3 right = Normalize(Cross(float3{ 0, 1, 0 }, forward));
+    float3 up = Cross(forward, right);
+    float tan_half = std::tan(std::numbers::pi_v<float> / 6.0f);
+    std::vector<Ray> rays;
+    rays.reserve(size_t(width) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            float u = ((float(x) + 0.5f) / float(width) * 2 - 1) * tan_half * float(width) / float(height);
+            float v = (1 - (float(y) + 0.5f) / float(height) * 2) * tan_half;
+            rays.push_back({ .origin = origin, .dir = Normalize(forward + right * u + up * v) });
+        }
+    }
+    return rays;
+}
+
+TlasHit BruteForce(const Tlas& tlas, const Ray& ray, uint32_t mask)
+{
+    TlasHit result;
+    for (const auto& instance : tlas.instances) {
+        if (!(instance.mask & mask)) {
+            continue;
+        }
+        const auto& m = instance.world_to_object;
+        auto row = [&](uint32_t r, float3 p, float w) {
+            return m[r][0] * p.x + m[r][1] * p.y + m[r][2] * p.z + m[r][3] * w;
+        };
+        Ray local{ .origin = { row(0, ray.origin, 1), row(1, ray.origin, 1), row(2, ray.origin, 1) },
+                   .t_min = ray.t_min,
+                   .dir = { row(0, ray.dir, 0), row(1, ray.dir, 0), row(2, ray.dir, 0) },
+                   .t_max = std::min(result.hit.t, ray.t_max) };
+        Hit hit = tlas.blases[instance.blas]->Trace(local);
+        if (!hit.Missed()) {
+            result = { hit, instance.index, instance.instance_id };
+        }
+    }
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t count = argc > 1 ? uint32_t(std::atoi(argv[1])) : 1'000'000;
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    const char* path = argc > 4 ? argv[4] : "assets/SnowmanOBJ.obj";
+
+    Blas blas = Blas::Build(LoadMesh(path));
+    const Blas* blases[]{ &blas };
+    size_t blas_bytes = blas.bvh.nodes.size() * sizeof(BvhNode) + blas.bvh.references.size() * sizeof(uint32_t) +
+            blas.triangles.size() * sizeof(Triangle);
+    std::vector<Instance> instances = MakeGrid(count);
+    std::printf("%u instances of %s (%zu triangles, BLAS %.2f MB), flattened they would take %.1f GB\n", count, path,
+                blas.triangles.size(), blas_bytes / 1e6, double(blas_bytes) * count / 1e9);
+
+    std::printf("\n%-6s %10s %10s %14s\n", "build", "ms", "TLAS MB", "bytes/instance");
+    Tlas tlas;
+    for (auto mode : { BvhBuildMode::FastBuild, BvhBuildMode::FastTrace }) {
+        tlas = Tlas::Build(blases, instances, { .mode = mode });
+        std::printf("%-6s %10.1f %10.1f %14.1f\n", mode == BvhBuildMode::FastTrace ? "SAH" : "LBVH", tlas.bvh.build_ms, tlas.MemoryBytes() / 1e6,
+                    double(tlas.MemoryBytes()) / count);
+    }
+
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(count))));
+    std::vector<Ray> rays = GridView(width, height, float(side) * spacing);
+    std::vector<TlasHit> hits(rays.size());
+    std::printf("\n%ux%u rays across the grid, SAH TLAS, one thread\n", width, height);
+    std::printf("%-6s %10s %8s %12s\n", "mask", "Mrays/s", "hit %", "mismatches");
+    for (uint32_t mask : { 0xffu, 0x01u }) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); ++i) {
+            hits[i] = tlas.Trace(rays[i], mask);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t hit_count = 0;
+        uint32_t mismatches = 0;
+        for (const auto& hit : hits) {
+            hit_count += !hit.Missed();
+            mismatches += !hit.Missed() && !(instances[hit.instance].mask & mask); // masked out instance reported
+        }
+        // brute force over every instance for a sample of the rays
+        for (size_t i = 0; i < rays.size(); i += std::max<size_t>(1, rays.size() / 64)) {
+            TlasHit reference = BruteForce(tlas, rays[i], mask);
+            mismatches += reference.instance != hits[i].instance || reference.hit.primitive != hits[i].hit.primitive;
+        }
+        std::printf("0x%02x   %10.2f %8.1f %12u\n", mask, double(rays.size()) / seconds * 1e-6, 100.0 * double(hit_count) / double(rays.size()),
+                    mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Single ray traversal of the binary SAH tree against its BVH4 and BVH8 collapses and their quantized nodes, over one camera path
+// and over random rays
+// usage: wide_bvh_bench [model] [width] [height] [frames]
+// the camera orbits the model and zooms in and back out, then as many rays as one frame has go from random points around
+// the model to random points near its center, incoherent like bounce rays. Every structure traces the same rays
+#include "bench_common.hpp"
+#include "cpu/wide_bvh.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+namespace {
+struct Result {
+    const char* name;
+    double seconds = 0;
+    uint64_t hits = 0; // of the reference
+    uint64_t mismatches = 0;
+};
+
+double Time(const std::function<void()>& work)
+{
+    auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace w::cpu;
+    using namespace w::bench;
+    const char* path = argc > 1 ? argv[1] : "assets/SnowmanOBJ.obj";
+    uint32_t width = argc > 2 ? uint32_t(std::atoi(argv[2])) : 640;
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 360;
+    uint32_t frames = argc > 4 ? uint32_t(std::atoi(argv[4])) : 16;
+
+    Blas blas = Blas::Build(LoadMesh(path));
+    Bvh4 bvh4 = Bvh4::Collapse(blas);
+    Bvh8 bvh8 = Bvh8::Collapse(blas);
+    QuantizedBvh4 qbvh4 = QuantizedBvh4::Quantize(bvh4);
+    QuantizedBvh8 qbvh8 = QuantizedBvh8::Quantize(bvh8);
+
+    std::printf("%s: %zu triangles, %ux%u, %u frames\n", path, blas.triangles.size(), width, height, frames);
+    std::printf("%-8s %8s %10s %12s %12s\n", "tree", "nodes", "node KB", "leaf slots", "empty slots");
+    std::printf("%-8s %8zu %10.1f %12u %12s\n", "binary", blas.bvh.nodes.size(), blas.bvh.nodes.size() * sizeof(BvhNode) / 1024.0,
+                blas.bvh.Stats().leaf_count, "-");
+    auto print_stats = [](const char* name, WideBvhStats stats, uint32_t width) {
+        std::printf("%-8s %8u %10.1f %12u %11.1f%%\n", name, stats.node_count, stats.node_bytes / 1024.0, stats.leaf_slots,
+                    100.0 * stats.empty_slots / double(stats.node_count * width));
+    };
+    print_stats("BVH4", bvh4.Stats(), 4);
+    print_stats("BVH8", bvh8.Stats(), 8);
+    print_stats("QBVH4", qbvh4.Stats(), 4);
+    print_stats("QBVH8", qbvh8.Stats(), 8);
+    std::printf("quantized nodes: %.1f%% of the BVH4 and %.1f%% of the BVH8 node memory\n",
+                100.0 * qbvh4.Stats().node_bytes / bvh4.Stats().node_bytes, 100.0 * qbvh8.Stats().node_bytes / bvh8.Stats().node_bytes);
+    if (!Bvh4::HasKernel() || !Bvh8::HasKernel()) {
+        std::printf("no SIMD kernel for %s on this CPU or build, those use the scalar box test\n", Bvh4::HasKernel() ? "BVH8" : "BVH4 / BVH8");
+    }
+
+    std::vector<Hit> reference;
+    std::vector<Hit> hits;
+    // traces rays with every structure into results, the binary tree's hits are the reference
+    auto trace = [&](std::span<const Ray> rays, Result (&results)[5]) {
+        reference.resize(rays.size());
+        hits.resize(rays.size());
+        results[0].seconds += Time([&]() {
+            for (size_t i = 0; i < rays.size(); ++i) {
+                reference[i] = blas.Trace(rays[i]);
+            }
+        });
+        for (auto& hit : reference) {
+            results[0].hits += !hit.Missed();
+        }
+        auto compare = [&](Result& result) {
+            for (size_t i = 0; i < rays.size(); ++i) {
+                result.mismatches += hits[i].primitive != reference[i].primitive;
+            }
+        };
+        results[1].seconds += Time([&]() { bvh4.Trace(rays, hits); });
+        compare(results[1]);
+        results[2].seconds += Time([&]() { bvh8.Trace(rays, hits); });
+        compare(results[2]);
+        results[3].seconds += Time([&]() { qbvh4.Trace(rays, hits); });
+        compare(results[3]);
+        results[4].seconds += Time([&]() { qbvh8.Trace(rays, hits); });
+        compare(results[4]);
+    };
+    auto print = [](const char* workload, double ray_count, const Result (&results)[5]) {
+        std::printf("\n%s, %.1f%% of the rays hit\n", workload, 100.0 * double(results[0].hits) / ray_count);
+        std::printf("%-8s %10s %8s %12s\n", "tree", "Mrays/s", "speedup", "mismatches");
+        for (auto& result : results) {
+            std::printf("%-8s %10.2f %8.2f %12llu\n", result.name, ray_count / result.seconds * 1e-6, results[0].seconds / result.seconds,
+                        (unsigned long long)result.mismatches);
+        }
+        std::printf("quantized against float nodes: QBVH4 %+.1f%%, QBVH8 %+.1f%% trace speed\n", 100.0 * (results[1].seconds / results[3].seconds - 1),
+                    100.0 * (results[2].seconds / results[4].seconds - 1));
+    };
+
+    w::Camera camera = MakeCamera(width, height);
+    std::vector<Ray> rays(size_t(width) * height);
+    Result camera_results[5]{ { "binary" }, { "BVH4" }, { "BVH8" }, { "QBVH4" }, { "QBVH8" } };
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        camera.Rotate(2 * std::numbers::pi_v<float> / float(frames), 0);
+        camera.Zoom(frame < frames / 2 ? 0.75f : -0.75f);
+        GenerateFrame(ViewRays(camera, width, height), rays);
+        trace(rays, camera_results);
+    }
+    print("camera rays", double(rays.size()) * frames, camera_results);
+
+    // origins in the cube of the bounds diagonal around the center, targets in a cube a quarter of that size
+    Aabb bounds = blas.bvh.nodes[0].Bounds();
+    float3 center = (bounds.lo + bounds.hi) * 0.5f;
+    float size = Length(bounds.hi - bounds.lo);
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> unit{ -0.5f, 0.5f };
+    Result random_results[5]{ { "binary" }, { "BVH4" }, { "BVH8" }, { "QBVH4" }, { "QBVH8" } };
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        for (Ray& ray : rays) {
+            float3 origin = center + float3{ unit(rng), unit(rng), unit(rng) } * size;
+            float3 target = center + float3{ unit(rng), unit(rng), unit(rng) } * (0.25f * size);
+            ray = { .origin = origin, .dir = Normalize(target - origin) };
+        }
+        trace(rays, random_results);
+    }
+    print("random rays", double(rays.size()) * frames, random_results);
+    return 0;
+}
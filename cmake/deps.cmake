@@ -37,3 +37,22 @@ CPMAddPackage(
   GIT_TAG v5.4.3
 )
 
+# fpng: fast decoder for PNGs written by fpng itself, sources only
+CPMAddPackage(
+  NAME fpng
+  GITHUB_REPOSITORY richgel999/fpng
+  GIT_TAG v1.0.6
+  DOWNLOAD_ONLY YES
+)
+
+# fpng has no CMake project of its own
+add_library(fpng STATIC "${fpng_SOURCE_DIR}/src/fpng.cpp" "${fpng_SOURCE_DIR}/src/fpng.h")
+target_include_directories(fpng PUBLIC "${fpng_SOURCE_DIR}/src")
+set_target_properties(fpng PROPERTIES CXX_STANDARD 17)
+if (CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+  if (NOT MSVC)
+    target_compile_options(fpng PRIVATE -msse4.1 -mpclmul)
+  endif()
+else()
+  target_compile_definitions(fpng PRIVATE FPNG_NO_SSE=1)
+endif()
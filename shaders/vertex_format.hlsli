@@ -0,0 +1,56 @@
+// Decoders for the compressed vertex layout, mirrors src/vertex_format.hpp. No shader includes it yet: ClosestHit
+// shades flat until the pipeline binds vertex and index buffers to fetch from
+#ifndef VERTEX_FORMAT_HLSLI
+#define VERTEX_FORMAT_HLSLI
+
+struct QuantizationBounds
+{
+    float3 center;
+    float3 halfExtent;
+};
+
+float2 UnpackSnorm16x2(uint packed)
+{
+    int2 v = int2(int(packed << 16) >> 16, int(packed) >> 16);
+    return max(float2(v) / 32767.0, -1.0);
+}
+
+// PackedPosition, 8 bytes: snorm16 xyz, w unused
+float3 UnpackPosition(uint2 packed, QuantizationBounds bounds)
+{
+    float3 q = float3(UnpackSnorm16x2(packed.x), UnpackSnorm16x2(packed.y).x);
+    return bounds.center + q * bounds.halfExtent;
+}
+
+float3 UnpackOctahedral(uint packed)
+{
+    float2 f = UnpackSnorm16x2(packed);
+    float3 n = float3(f, 1 - abs(f.x) - abs(f.y));
+    float t = saturate(-n.z);
+    n.xy += select(n.xy >= 0, -t, t);
+    return normalize(n);
+}
+
+float2 UnpackHalf2(uint packed)
+{
+    return f16tof32(uint2(packed, packed >> 16));
+}
+
+// PackedAttributes, 12 bytes: octahedral normal, octahedral tangent, half uv
+struct VertexAttributes
+{
+    float3 normal;
+    float3 tangent;
+    float2 uv;
+};
+
+VertexAttributes UnpackAttributes(uint3 packed)
+{
+    VertexAttributes attributes;
+    attributes.normal = UnpackOctahedral(packed.x);
+    attributes.tangent = UnpackOctahedral(packed.y);
+    attributes.uv = UnpackHalf2(packed.z);
+    return attributes;
+}
+
+#endif // VERTEX_FORMAT_HLSLI
@@ -2,6 +2,8 @@
 #include "sdl.hpp"
 #include "graphics.hpp"
 #include "scene.hpp"
+#include "upload_context.hpp"
+#include "asset_pack.hpp"
 
 namespace w {
 class App
@@ -11,16 +13,22 @@ public:
         : window("Window", 800, 600)
         , gfx(window.GetPlatformExtension())
         , swapchain(CreateSwapchain())
-        , scene(gfx)
+        , assets("assets.pack")
+        , upload(gfx)
+        , scene(gfx, upload, assets)
     {
+        // all model uploads and the BLAS build go out in one batch, pipelines are created meanwhile
+        w::UploadToken scene_uploaded = upload.Submit();
+
         wis::Result res = wis::success;
         for (auto& cmd_list : cmd_lists) {
             cmd_list = gfx.GetDevice().CreateCommandList(res, wis::QueueType::Graphics);
         }
         aux_cmd_list = gfx.GetDevice().CreateCommandList(res, wis::QueueType::Graphics);
 
-        scene.CreatePipelines(gfx);
+        scene.CreatePipelines(gfx, assets);
         scene.Resize(gfx, 800, 600);
+        upload.Wait(scene_uploaded); // TLAS build needs the BLAS
         scene.CreateTLAS(gfx, aux_cmd_list); // reset the command list (local buffers)
         scene.TransitionTextures(gfx, aux_cmd_list);
         aux_cmd_list.Close();
@@ -86,6 +94,8 @@ private:
     w::Window window;
     w::Graphics gfx;
     w::Swapchain swapchain;
+    w::AssetPack assets; // built next to the executable, loaders fall back to loose files without it
+    w::UploadContext upload;
     w::Scene scene;
 
     wis::CommandList cmd_lists[w::flight_frames];
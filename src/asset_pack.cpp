@@ -0,0 +1,138 @@
+#include "asset_pack.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+w::AssetPack::AssetPack(const std::filesystem::path& p)
+    : file(p)
+{
+    auto bytes = file.Bytes();
+    w::AssetPackHeader header;
+    if (bytes.size() < sizeof(header)) {
+        return;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    uint64_t toc_bytes = uint64_t(header.entry_count) * sizeof(w::AssetPackEntry);
+    if (header.magic != w::AssetPackHeader::magic_value ||
+        header.version != w::AssetPackHeader::current_version ||
+        header.toc_offset % alignof(w::AssetPackEntry) != 0 ||
+        header.toc_offset > bytes.size() || toc_bytes > bytes.size() - header.toc_offset ||
+        header.names_offset > bytes.size() || header.names_size > bytes.size() - header.names_offset) {
+        file = {};
+        return;
+    }
+
+    auto toc = std::span{ reinterpret_cast<const w::AssetPackEntry*>(bytes.data() + header.toc_offset), header.entry_count };
+    for (auto& entry : toc) {
+        if (entry.offset > bytes.size() || entry.size > bytes.size() - entry.offset ||
+            uint64_t(entry.name_offset) + entry.name_length > header.names_size) {
+            file = {};
+            return;
+        }
+    }
+    entries = toc;
+    names = reinterpret_cast<const char*>(bytes.data() + header.names_offset);
+}
+
+const w::AssetPackEntry* w::AssetPack::FindEntry(std::string_view name) const noexcept
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), name, [this](const w::AssetPackEntry& entry, std::string_view name) {
+        return Name(entry) < name;
+    });
+    return it != entries.end() && Name(*it) == name ? &*it : nullptr;
+}
+
+std::span<const std::byte> w::AssetPack::Find(std::string_view name) const noexcept
+{
+    auto* entry = FindEntry(name);
+    return entry ? file.Bytes().subspan(entry->offset, entry->size) : std::span<const std::byte>{};
+}
+
+void w::AssetPack::Prefetch(std::string_view name) const noexcept
+{
+    w::MappedFile::Prefetch(Find(name));
+}
+
+bool w::AssetPack::Verify(std::string_view name) const noexcept
+{
+    auto* entry = FindEntry(name);
+    return entry && w::HashBytes(file.Bytes().subspan(entry->offset, entry->size)) == entry->hash;
+}
+
+bool w::WriteAssetPack(const std::filesystem::path& p, std::vector<w::AssetPackSource> sources)
+{
+    std::sort(sources.begin(), sources.end(), [](auto& a, auto& b) { return a.name < b.name; });
+
+    std::vector<w::MappedFile> files;
+    std::vector<w::AssetPackEntry> toc;
+    std::string names;
+    files.reserve(sources.size());
+    toc.reserve(sources.size());
+    for (auto& source : sources) {
+        w::MappedFile& mapped = files.emplace_back(source.path);
+        if (!mapped) {
+            std::cerr << "Failed to read " << source.path.string() << '\n';
+            return false;
+        }
+        toc.push_back({ .size = mapped.Bytes().size(),
+                        .hash = w::HashBytes(mapped.Bytes()),
+                        .name_offset = uint32_t(names.size()),
+                        .name_length = uint32_t(source.name.size()) });
+        names += source.name;
+    }
+
+    auto align = [](uint64_t offset) {
+        return (offset + w::AssetPackHeader::blob_alignment - 1) / w::AssetPackHeader::blob_alignment * w::AssetPackHeader::blob_alignment;
+    };
+    w::AssetPackHeader header{
+        .entry_count = uint32_t(toc.size()),
+        .toc_offset = sizeof(w::AssetPackHeader),
+        .names_offset = sizeof(w::AssetPackHeader) + toc.size() * sizeof(w::AssetPackEntry),
+        .names_size = names.size(),
+    };
+    uint64_t offset = align(header.names_offset + header.names_size);
+    for (auto& entry : toc) {
+        entry.offset = offset;
+        offset = align(offset + entry.size);
+    }
+
+    // write to a side file first like the mesh cache, a half written pack never replaces a good one
+    auto temp_path = p;
+    temp_path += ".tmp";
+    {
+        std::ofstream out{ temp_path, std::ios::binary | std::ios::trunc };
+        if (!out) {
+            return false;
+        }
+        uint64_t written = 0;
+        auto write = [&](const void* data, uint64_t size) {
+            out.write(static_cast<const char*>(data), std::streamsize(size));
+            written += size;
+        };
+        auto pad_to = [&](uint64_t at) {
+            static constexpr char zeros[w::AssetPackHeader::blob_alignment]{};
+            write(zeros, at - written);
+        };
+        write(&header, sizeof(header));
+        write(toc.data(), toc.size() * sizeof(w::AssetPackEntry));
+        write(names.data(), names.size());
+        for (size_t i = 0; i < toc.size(); ++i) {
+            pad_to(toc[i].offset);
+            write(files[i].Bytes().data(), toc[i].size);
+        }
+        if (!out) {
+            return false;
+        }
+    }
+    files.clear();
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, p, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "mapped_file.hpp"
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace w {
+// Pack layout: header, table of contents sorted by name, name strings, then the blobs.
+// Blobs start on page boundaries so each can be prefetched on its own and keeps the alignment of cooked data.
+struct AssetPackHeader {
+    static constexpr uint32_t magic_value = 0x4b415057; // "WPAK"
+    static constexpr uint32_t current_version = 1;
+    static constexpr uint64_t blob_alignment = 4096;
+
+    uint32_t magic = magic_value;
+    uint32_t version = current_version;
+    uint32_t entry_count = 0;
+    uint32_t reserved = 0;
+    uint64_t toc_offset = 0;
+    uint64_t names_offset = 0;
+    uint64_t names_size = 0;
+};
+
+struct AssetPackEntry {
+    uint64_t offset = 0; // from the file start
+    uint64_t size = 0;
+    uint64_t hash = 0; // w::HashBytes of the blob
+    uint32_t name_offset = 0; // into the name strings
+    uint32_t name_length = 0;
+};
+
+// Read-only view of a pack, blobs are handed out as spans into the mapping
+class AssetPack
+{
+public:
+    AssetPack() = default;
+    AssetPack(const std::filesystem::path& p); // empty if the pack is missing or malformed
+
+public:
+    explicit operator bool() const noexcept
+    {
+        return !entries.empty();
+    }
+    // names are paths relative to the build directory with forward slashes, e.g. "assets/Snowman_NM.dds"
+    std::span<const std::byte> Find(std::string_view name) const noexcept; // empty if absent
+    void Prefetch(std::string_view name) const noexcept;
+    bool Verify(std::string_view name) const noexcept; // rehashes the blob
+
+private:
+    const w::AssetPackEntry* FindEntry(std::string_view name) const noexcept;
+    std::string_view Name(const w::AssetPackEntry& entry) const noexcept
+    {
+        return { names + entry.name_offset, entry.name_length };
+    }
+
+private:
+    w::MappedFile file;
+    std::span<const w::AssetPackEntry> entries;
+    const char* names = nullptr;
+};
+
+struct AssetPackSource {
+    std::string name;
+    std::filesystem::path path;
+};
+bool WriteAssetPack(const std::filesystem::path& p, std::vector<w::AssetPackSource> sources);
+} // namespace w
@@ -6,6 +6,9 @@ static constexpr wis::DataFormat swap_format = wis::DataFormat::RGBA8Unorm; // s
 static constexpr wis::DataFormat depth_format = wis::DataFormat::D32Float; // standard format for the application
 static constexpr uint32_t swap_frames = 2; // 
 static constexpr uint32_t flight_frames = 2; //
+// upload the compressed layout from vertex_format.hpp instead of float3 streams. Off by default: it changes the geometry
+// the BLAS is built from by up to half a snorm16 step, TriangleMesh::FromModel follows the switch to keep CPU renders comparable
+static constexpr bool quantized_vertices = false;
 
 struct Exception : public std::exception {
     Exception(std::string message)
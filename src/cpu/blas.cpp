@@ -0,0 +1,201 @@
+#include "blas.hpp"
+#include "packet_kernels.hpp"
+#include "triangle_mesh.hpp"
+
+w::cpu::Blas w::cpu::Blas::Build(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings)
+{
+    Blas blas;
+    blas.bvh = BuildBvh(mesh, settings);
+    blas.triangles.reserve(blas.bvh.references.size());
+    for (uint32_t t : blas.bvh.references) {
+        float3 v0 = mesh.positions[mesh.indices[t * 3 + 0]];
+        float3 v1 = mesh.positions[mesh.indices[t * 3 + 1]];
+        float3 v2 = mesh.positions[mesh.indices[t * 3 + 2]];
+        blas.triangles.push_back({ v0, v1 - v0, v2 - v0 });
+    }
+    return blas;
+}
+
+namespace {
+constexpr uintptr_t lines_per_page = 4096 / w::cpu::cache_line_size;
+
+// the scalar traversal, with counting compiled in only for the instrumented overload
+template<bool counted>
+w::cpu::Hit TraceBlas(const w::cpu::Blas& blas, const w::cpu::Ray& ray, w::cpu::TraversalCounters* counters) noexcept
+{
+    using namespace w::cpu;
+    const Bvh& bvh = blas.bvh;
+    Hit hit;
+    if (bvh.nodes.empty()) {
+        return hit;
+    }
+
+    [[maybe_unused]] std::vector<uintptr_t>* lines = nullptr;
+    if constexpr (counted) {
+        thread_local std::vector<uintptr_t> touched;
+        touched.clear();
+        lines = &touched;
+    }
+    auto finish = [&]() {
+        if constexpr (counted) {
+            std::sort(lines->begin(), lines->end());
+            lines->erase(std::unique(lines->begin(), lines->end()), lines->end());
+            counters->node_cache_lines += lines->size();
+            for (size_t i = 0; i < lines->size(); ++i) {
+                counters->node_pages += i == 0 || (*lines)[i] / lines_per_page != (*lines)[i - 1] / lines_per_page;
+            }
+        }
+        return hit;
+    };
+
+    struct Entry {
+        uint32_t node;
+        float t_near;
+    };
+    Entry stack[traversal_stack_size];
+    uint32_t top = 0;
+
+    float3 inv_dir = SafeInverse(ray.dir);
+    auto visit = [&](const BvhNode& node) {
+        if constexpr (counted) {
+            lines->push_back(reinterpret_cast<uintptr_t>(&node) / cache_line_size);
+        }
+        return IntersectAabb(ray.origin, inv_dir, ray.t_min, std::min(hit.t, ray.t_max), node.lo, node.hi);
+    };
+    Entry current{ 0, visit(bvh.nodes[0]) };
+    if (current.t_near == HUGE_VALF) {
+        return finish();
+    }
+    while (true) {
+        const BvhNode& node = bvh.nodes[current.node];
+        if constexpr (counted) {
+            counters->node_visits++;
+        }
+        if (node.IsLeaf()) {
+            if constexpr (counted) {
+                counters->triangle_tests += node.count;
+            }
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i) {
+                IntersectTriangle(ray, blas.triangles[i], i, hit);
+            }
+        } else {
+            Entry near{ node.left_first, visit(bvh.nodes[node.left_first]) };
+            Entry far{ node.left_first + 1, visit(bvh.nodes[node.left_first + 1]) };
+            if (far.t_near < near.t_near) {
+                std::swap(near, far);
+            }
+            if (near.t_near != HUGE_VALF) {
+                if (far.t_near != HUGE_VALF) {
+                    stack[top++] = far;
+                }
+                current = near;
+                continue;
+            }
+        }
+
+        // pop, skipping nodes a closer hit has since ruled out
+        do {
+            if (top == 0) {
+                if (!hit.Missed()) {
+                    hit.primitive = bvh.references[hit.primitive];
+                }
+                return finish();
+            }
+            current = stack[--top];
+        } while (current.t_near >= hit.t);
+    }
+}
+} // namespace
+
+w::cpu::Hit w::cpu::Blas::Trace(const Ray& ray) const noexcept
+{
+    return TraceBlas<false>(*this, ray, nullptr);
+}
+
+w::cpu::Hit w::cpu::Blas::Trace(const Ray& ray, TraversalCounters& counters) const noexcept
+{
+    return TraceBlas<true>(*this, ray, &counters);
+}
+
+// any hit: the nearer child first like Trace, which finds the occluder soonest, and the first triangle inside
+// [t_min, t_max] ends the walk
+bool w::cpu::Blas::Occluded(const Ray& ray) const noexcept
+{
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    float3 inv_dir = SafeInverse(ray.dir);
+    auto visit = [&](const BvhNode& node) {
+        return IntersectAabb(ray.origin, inv_dir, ray.t_min, ray.t_max, node.lo, node.hi);
+    };
+    if (visit(bvh.nodes[0]) == HUGE_VALF) {
+        return false;
+    }
+    uint32_t stack[traversal_stack_size];
+    uint32_t top = 0;
+    uint32_t current = 0;
+    while (true) {
+        const BvhNode& node = bvh.nodes[current];
+        if (node.IsLeaf()) {
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i) {
+                if (OccludesTriangle(ray, triangles[i])) {
+                    return true;
+                }
+            }
+        } else {
+            uint32_t near = node.left_first, far = node.left_first + 1;
+            float t_near = visit(bvh.nodes[near]), t_far = visit(bvh.nodes[far]);
+            if (t_far < t_near) {
+                std::swap(near, far);
+                std::swap(t_near, t_far);
+            }
+            if (t_near != HUGE_VALF) {
+                if (t_far != HUGE_VALF) {
+                    stack[top++] = far;
+                }
+                current = near;
+                continue;
+            }
+        }
+        if (top == 0) {
+            return false;
+        }
+        current = stack[--top];
+    }
+}
+
+void w::cpu::Blas::TracePackets(std::span<const Ray> rays, std::span<Hit> hits, const PacketTraceSettings& settings) const noexcept
+{
+    switch (ClampSimdIsa(settings.isa)) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::TracePackets(*this, rays, hits, settings.interval_culling);
+    case SimdIsa::AVX2:
+        return avx2::TracePackets(*this, rays, hits, settings.interval_culling);
+    case SimdIsa::SSE:
+        return sse::TracePackets(*this, rays, hits, settings.interval_culling);
+#endif
+    default:
+        for (size_t i = 0; i < rays.size(); ++i) {
+            hits[i] = Trace(rays[i]);
+        }
+    }
+}
+
+void w::cpu::Blas::OccludedPackets(std::span<const Ray> rays, std::span<uint8_t> occluded, const PacketTraceSettings& settings) const noexcept
+{
+    switch (ClampSimdIsa(settings.isa)) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::OccludedPackets(*this, rays, occluded, settings.interval_culling);
+    case SimdIsa::AVX2:
+        return avx2::OccludedPackets(*this, rays, occluded, settings.interval_culling);
+    case SimdIsa::SSE:
+        return sse::OccludedPackets(*this, rays, occluded, settings.interval_culling);
+#endif
+    default:
+        for (size_t i = 0; i < rays.size(); ++i) {
+            occluded[i] = Occluded(rays[i]);
+        }
+    }
+}
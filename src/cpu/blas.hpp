@@ -0,0 +1,49 @@
+#pragma once
+#include "bvh.hpp"
+#include "ray.hpp"
+#include "simd_isa.hpp"
+#include <span>
+#include <vector>
+
+namespace w::cpu {
+struct TriangleMesh;
+
+struct PacketTraceSettings {
+    SimdIsa isa = DetectSimdIsa(); // clamped to what the CPU supports
+    bool interval_culling = true; // packet wide bounds test for inner nodes, only used for packets whose rays share direction signs
+};
+
+// what a traced ray cost, summed over every ray passed in
+struct TraversalCounters {
+    uint64_t node_visits = 0; // inner nodes and leaves the traversal stepped into
+    uint64_t triangle_tests = 0;
+    uint64_t node_cache_lines = 0; // distinct lines of bvh.nodes each ray read, what the node layout decides
+    uint64_t node_pages = 0; // distinct 4 KiB pages of bvh.nodes each ray read
+};
+
+// Triangle BVH the CPU traversal kernels run on, the software counterpart of a BLAS
+class Blas
+{
+public:
+    static Blas Build(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings = {});
+
+public:
+    // one ray at a time, closest hit
+    Hit Trace(const Ray& ray) const noexcept;
+    Hit Trace(const Ray& ray, TraversalCounters& counters) const noexcept; // same traversal, instrumented
+
+    // consecutive runs of PacketWidth(isa) rays are traced together as one packet,
+    // coherent rays (a screen tile of primary rays) make the most of it
+    void TracePackets(std::span<const Ray> rays, std::span<Hit> hits, const PacketTraceSettings& settings = {}) const noexcept;
+
+    // Occlusion queries for shadow and ambient occlusion rays: whether anything lies within [t_min, t_max]. Traversal
+    // stops at the first triangle found and no hit record is kept, so these are cheaper than Trace on the same rays.
+    // OccludedPackets takes batches of any size, occluded[i] is 1 or 0 for rays[i]
+    bool Occluded(const Ray& ray) const noexcept;
+    void OccludedPackets(std::span<const Ray> rays, std::span<uint8_t> occluded, const PacketTraceSettings& settings = {}) const noexcept;
+
+public:
+    Bvh bvh;
+    std::vector<Triangle> triangles; // in leaf order: triangles[i] is mesh triangle bvh.references[i]
+};
+} // namespace w::cpu
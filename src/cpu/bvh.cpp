@@ -0,0 +1,366 @@
+#include "bvh.hpp"
+#include "triangle_mesh.hpp"
+#include "../worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace w::cpu;
+
+constexpr uint32_t max_bins = 64;
+
+struct Bin {
+    Aabb bounds;
+    uint32_t count = 0;
+};
+
+struct Split {
+    uint32_t axis = 0;
+    uint32_t bin = 0; // first bin on the right side
+    float cost = HUGE_VALF;
+};
+
+// bounds of the primitives and of their centroids over a reference range
+struct RangeBounds {
+    Aabb bounds;
+    Aabb centroids;
+
+    void Grow(const RangeBounds& other) noexcept
+    {
+        bounds.Grow(other.bounds);
+        centroids.Grow(other.centroids);
+    }
+};
+
+class Builder
+{
+public:
+    Builder(std::span<const Aabb> primitives, const BvhBuildSettings& settings, Bvh& bvh)
+        : primitives(primitives), settings(settings), bvh(bvh)
+    {
+        bin_count = std::clamp(settings.bin_count, 2u, max_bins);
+        max_depth = std::clamp(settings.max_depth, min_bvh_depth, traversal_stack_size);
+        uint32_t threads = settings.thread_count ? settings.thread_count : std::max(1u, std::thread::hardware_concurrency());
+        if (threads > 1 && primitives.size() > settings.parallel_threshold) {
+            pool = std::make_unique<w::WorkerPool>(threads);
+        }
+
+        centroids.resize(primitives.size());
+        bvh.references.resize(primitives.size());
+        for (uint32_t i = 0; i < primitives.size(); ++i) {
+            centroids[i] = primitives[i].Center();
+            bvh.references[i] = i;
+        }
+        if (!primitives.empty()) {
+            bvh.nodes.resize(primitives.size() * 2 - 1);
+        }
+    }
+
+public:
+    void Build()
+    {
+        if (primitives.empty()) {
+            bvh.nodes.clear();
+            return;
+        }
+        bvh.nodes[0] = { .left_first = 0, .count = uint32_t(primitives.size()) };
+        node_count = 1;
+
+        // top levels run here with parallel binning, everything below the threshold is an independent subtree
+        std::vector<NodeDepth> subtrees;
+        BuildTop({ 0, 1 }, subtrees);
+        if (!subtrees.empty()) {
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(subtrees.size());
+            for (NodeDepth subtree : subtrees) {
+                tasks.push_back(pool->Submit([this, subtree]() { Subdivide(subtree); }));
+            }
+            for (auto& task : tasks) {
+                task.get();
+            }
+        }
+        bvh.nodes.resize(node_count);
+    }
+
+private:
+    struct NodeDepth {
+        uint32_t node;
+        uint32_t depth; // the root is 1, like BvhStats::max_depth
+    };
+
+    RangeBounds ComputeBounds(uint32_t first, uint32_t count) const noexcept
+    {
+        RangeBounds result;
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t prim = bvh.references[i];
+            result.bounds.Grow(primitives[prim]);
+            result.centroids.Grow(centroids[prim]);
+        }
+        return result;
+    }
+
+    uint32_t BinIndex(float centroid, float lo, float scale) const noexcept
+    {
+        return std::min(bin_count - 1, uint32_t(std::max(0.0f, (centroid - lo) * scale)));
+    }
+
+    void BinRange(uint32_t first, uint32_t count, const Aabb& centroid_bounds, Bin (&bins)[3][max_bins]) const noexcept
+    {
+        float3 extent = centroid_bounds.Extent();
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t prim = bvh.references[i];
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                if (extent[axis] <= 0) {
+                    continue;
+                }
+                float scale = float(bin_count) / extent[axis];
+                Bin& bin = bins[axis][BinIndex(centroids[prim][axis], centroid_bounds.lo[axis], scale)];
+                bin.bounds.Grow(primitives[prim]);
+                bin.count++;
+            }
+        }
+    }
+
+    // chunks of the range go to the pool, the calling thread only merges
+    template<typename Result, typename F, typename Merge>
+    Result ParallelOver(uint32_t first, uint32_t count, F&& work, Merge&& merge)
+    {
+        uint32_t chunks = pool->ThreadCount();
+        uint32_t chunk_size = (count + chunks - 1) / chunks;
+        std::vector<std::future<Result>> tasks;
+        for (uint32_t begin = first; begin < first + count; begin += chunk_size) {
+            uint32_t size = std::min(chunk_size, first + count - begin);
+            tasks.push_back(pool->Submit([&work, begin, size]() { return work(begin, size); }));
+        }
+        Result result{};
+        for (auto& task : tasks) {
+            merge(result, task.get());
+        }
+        return result;
+    }
+
+    Split FindSplit(uint32_t first, uint32_t count, const RangeBounds& range, bool parallel)
+    {
+        struct Bins {
+            Bin bins[3][max_bins];
+        };
+        auto bins = std::make_unique<Bins>();
+        if (parallel) {
+            *bins = ParallelOver<Bins>(
+                    first, count,
+                    [this, &range](uint32_t begin, uint32_t size) {
+                        Bins local;
+                        BinRange(begin, size, range.centroids, local.bins);
+                        return local;
+                    },
+                    [this](Bins& into, const Bins& from) {
+                        for (uint32_t axis = 0; axis < 3; ++axis) {
+                            for (uint32_t b = 0; b < bin_count; ++b) {
+                                into.bins[axis][b].bounds.Grow(from.bins[axis][b].bounds);
+                                into.bins[axis][b].count += from.bins[axis][b].count;
+                            }
+                        }
+                    });
+        } else {
+            BinRange(first, count, range.centroids, bins->bins);
+        }
+
+        // sweep from both sides, cost is relative to the parent area and counted in primitive intersections
+        Split best;
+        float parent_area = range.bounds.HalfArea();
+        float3 extent = range.centroids.Extent();
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            if (extent[axis] <= 0) {
+                continue;
+            }
+            float right_cost[max_bins]{};
+            Aabb right;
+            uint32_t right_count = 0;
+            for (uint32_t b = bin_count - 1; b > 0; --b) {
+                right.Grow(bins->bins[axis][b].bounds);
+                right_count += bins->bins[axis][b].count;
+                right_cost[b] = right.HalfArea() * float(right_count);
+            }
+            Aabb left;
+            uint32_t left_count = 0;
+            for (uint32_t b = 1; b < bin_count; ++b) {
+                left.Grow(bins->bins[axis][b - 1].bounds);
+                left_count += bins->bins[axis][b - 1].count;
+                if (left_count == 0 || left_count == count) {
+                    continue;
+                }
+                float cost = settings.traversal_cost + (left.HalfArea() * float(left_count) + right_cost[b]) / parent_area;
+                if (cost < best.cost) {
+                    best = { axis, b, cost };
+                }
+            }
+        }
+        return best;
+    }
+
+    // turns node into an inner node with two fresh children, or leaves it a leaf; returns false for a leaf
+    bool SplitNode(NodeDepth at, bool parallel)
+    {
+        BvhNode& node = bvh.nodes[at.node];
+        uint32_t first = node.left_first;
+        uint32_t count = node.count;
+
+        RangeBounds range = parallel
+                ? ParallelOver<RangeBounds>(
+                          first, count, [this](uint32_t begin, uint32_t size) { return ComputeBounds(begin, size); },
+                          [](RangeBounds& into, const RangeBounds& from) { into.Grow(from); })
+                : ComputeBounds(first, count);
+        node.lo = range.bounds.lo;
+        node.hi = range.bounds.hi;
+        if (count == 1) {
+            return false;
+        }
+
+        // once a SAH split that peels off one primitive could leave too few levels for halving the rest, the node
+        // is split at the centroid median instead; at max_depth every node fits in a leaf
+        if (at.depth + 1 + MedianSplitLevels(count - 1, settings.max_leaf_size) > max_depth) {
+            if (count <= settings.max_leaf_size) {
+                return false;
+            }
+            uint32_t axis = range.centroids.LargestAxis();
+            auto* begin = bvh.references.data() + first;
+            std::nth_element(begin, begin + count / 2, begin + count,
+                             [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+            return MakeChildren(node, first + count / 2);
+        }
+
+        Split split = FindSplit(first, count, range, parallel);
+        bool worth_it = split.cost < float(count);
+        if (!worth_it && count <= settings.max_leaf_size) {
+            return false;
+        }
+
+        uint32_t middle;
+        if (split.cost < HUGE_VALF) {
+            float lo = range.centroids.lo[split.axis];
+            float scale = float(bin_count) / range.centroids.Extent()[split.axis];
+            auto* begin = bvh.references.data() + first;
+            middle = uint32_t(std::partition(begin, begin + count, [&](uint32_t prim) {
+                                  return BinIndex(centroids[prim][split.axis], lo, scale) < split.bin;
+                              }) -
+                              bvh.references.data());
+        } else {
+            middle = first + count / 2; // centroids coincide, any split is as good as another
+        }
+        return MakeChildren(node, middle);
+    }
+
+    bool MakeChildren(BvhNode& node, uint32_t middle)
+    {
+        uint32_t first = node.left_first;
+        uint32_t count = node.count;
+        uint32_t left = node_count.fetch_add(2, std::memory_order_relaxed);
+        bvh.nodes[left] = { .left_first = first, .count = middle - first };
+        bvh.nodes[left + 1] = { .left_first = middle, .count = first + count - middle };
+        node.left_first = left;
+        node.count = 0;
+        return true;
+    }
+
+    void BuildTop(NodeDepth at, std::vector<NodeDepth>& subtrees)
+    {
+        if (!pool || bvh.nodes[at.node].count <= settings.parallel_threshold) {
+            if (pool) {
+                subtrees.push_back(at);
+            } else {
+                Subdivide(at);
+            }
+            return;
+        }
+        if (SplitNode(at, true)) {
+            uint32_t left = bvh.nodes[at.node].left_first;
+            BuildTop({ left, at.depth + 1 }, subtrees);
+            BuildTop({ left + 1, at.depth + 1 }, subtrees);
+        }
+    }
+
+    void Subdivide(NodeDepth root)
+    {
+        // explicit stack, degenerate inputs can get deep
+        std::vector<NodeDepth> stack{ root };
+        while (!stack.empty()) {
+            NodeDepth at = stack.back();
+            stack.pop_back();
+            if (SplitNode(at, false)) {
+                uint32_t left = bvh.nodes[at.node].left_first;
+                stack.push_back({ left + 1, at.depth + 1 });
+                stack.push_back({ left, at.depth + 1 });
+            }
+        }
+    }
+
+private:
+    std::span<const Aabb> primitives;
+    const BvhBuildSettings& settings;
+    Bvh& bvh;
+    uint32_t bin_count = 16;
+    uint32_t max_depth = traversal_stack_size;
+    std::vector<float3> centroids;
+    std::atomic<uint32_t> node_count{ 0 };
+    std::unique_ptr<w::WorkerPool> pool;
+};
+} // namespace
+
+w::cpu::Bvh w::cpu::BuildBvh(std::span<const Aabb> primitives, const BvhBuildSettings& settings)
+{
+    if (settings.mode == BvhBuildMode::FastBuild) {
+        return BuildLbvh(primitives, settings);
+    }
+    auto start = std::chrono::steady_clock::now();
+    Bvh bvh;
+    Builder{ primitives, settings, bvh }.Build();
+    ReorderBvh(bvh, settings.layout, settings.treelet_size);
+    bvh.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return bvh;
+}
+
+w::cpu::Bvh w::cpu::BuildBvh(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings)
+{
+    if (settings.mode == BvhBuildMode::SpatialSplits) {
+        return BuildSbvh(mesh, settings);
+    }
+    std::vector<Aabb> bounds(mesh.TriangleCount());
+    for (uint32_t t = 0; t < bounds.size(); ++t) {
+        bounds[t] = mesh.TriangleBounds(t);
+    }
+    return BuildBvh(bounds, settings);
+}
+
+w::cpu::BvhStats w::cpu::Bvh::Stats(float traversal_cost) const
+{
+    BvhStats stats{ .build_ms = build_ms };
+    if (nodes.empty()) {
+        return stats;
+    }
+
+    float root_area = nodes[0].Bounds().HalfArea();
+    double cost = 0;
+    uint64_t leaf_references = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> stack{ { 0, 1 } }; // node, depth
+    while (!stack.empty()) {
+        auto [index, depth] = stack.back();
+        stack.pop_back();
+        const BvhNode& node = nodes[index];
+        stats.node_count++;
+        stats.max_depth = std::max(stats.max_depth, depth);
+        float area = root_area > 0 ? node.Bounds().HalfArea() / root_area : 1.0f;
+        if (node.IsLeaf()) {
+            stats.leaf_count++;
+            leaf_references += node.count;
+            cost += area * node.count;
+        } else {
+            cost += area * traversal_cost;
+            stack.push_back({ node.left_first, depth + 1 });
+            stack.push_back({ node.left_first + 1, depth + 1 });
+        }
+    }
+    stats.average_leaf_size = stats.leaf_count ? float(leaf_references) / float(stats.leaf_count) : 0;
+    stats.sah_cost = float(cost);
+    return stats;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "math.hpp"
+#include <algorithm>
+#include <bit>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace w::cpu {
+struct TriangleMesh;
+
+// 32 bytes, two per cache line. Children of an inner node are adjacent: left_first and left_first + 1
+struct BvhNode {
+    float3 lo;
+    uint32_t left_first = 0; // first child of an inner node, first reference of a leaf
+    float3 hi;
+    uint32_t count = 0; // references in a leaf, 0 for inner nodes
+
+    bool IsLeaf() const noexcept
+    {
+        return count != 0;
+    }
+    Aabb Bounds() const noexcept
+    {
+        return { lo, hi };
+    }
+};
+static_assert(sizeof(BvhNode) == 32);
+
+// fixed traversal stacks hold one entry per level, the builders keep every tree within this many levels
+constexpr uint32_t traversal_stack_size = 128;
+
+// a root and 32 halvings reach single primitives from any uint32 count
+constexpr uint32_t min_bvh_depth = 33;
+
+// levels below a node of count primitives that median splits need to get down to leaves of max_leaf_size
+constexpr uint32_t MedianSplitLevels(uint32_t count, uint32_t max_leaf_size) noexcept
+{
+    max_leaf_size = std::max(1u, max_leaf_size);
+    return count <= max_leaf_size ? 0 : uint32_t(std::bit_width((count - 1) / max_leaf_size));
+}
+
+constexpr uint32_t cache_line_size = 64;
+
+// node storage starts on a cache line, so a laid out tree keeps every sibling pair on a line of its own
+template<typename T>
+struct CacheLineAllocator {
+    using value_type = T;
+
+    CacheLineAllocator() noexcept = default;
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ cache_line_size }));
+    }
+    void deallocate(T* p, size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t{ cache_line_size });
+    }
+    template<typename U>
+    bool operator==(const CacheLineAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+// the same trade-off as wis::AccelerationStructureFlags::PreferFastTrace / PreferFastBuild on the GPU side
+enum class BvhBuildMode {
+    FastTrace, // binned SAH
+    FastBuild, // LBVH over Morton codes, for geometry rebuilt every frame
+    SpatialSplits, // SBVH, binned SAH that may also split triangles; needs the TriangleMesh overload
+};
+
+// node order in memory, applied once the tree is built. Every layout keeps the root at 0 and siblings adjacent;
+// all but Build put the root's line apart and give each sibling pair a line of its own
+enum class BvhLayout {
+    Build, // whatever order the builder produced
+    DepthFirst, // sibling pairs in preorder, left subtree first
+    VanEmdeBoas, // the tree cut at half its height, top part first, then every bottom part, each laid out the same way
+    Treelet, // greedy clusters of the pairs a ray most likely visits, by parent surface area
+};
+
+struct BvhBuildSettings {
+    BvhBuildMode mode = BvhBuildMode::FastTrace;
+    uint32_t bin_count = 16;
+    uint32_t max_leaf_size = 8; // leaves never get bigger unless the primitives cannot be separated
+    uint32_t max_depth = traversal_stack_size; // FastTrace, SpatialSplits: nodes that would outgrow it get median splits; clamped to [min_bvh_depth, traversal_stack_size]
+    float traversal_cost = 1.0f; // cost of visiting an inner node relative to one primitive intersection
+    uint32_t thread_count = 0; // 0 for hardware concurrency
+    uint32_t parallel_threshold = 16384; // nodes with more primitives are binned in parallel, smaller ones become subtree tasks
+    float reference_budget = 0.3f; // SpatialSplits: references may grow by this fraction of the triangle count
+    float spatial_split_alpha = 1e-5f; // SpatialSplits: only try spatial splits where object split children overlap more than this, relative to the root area
+    BvhLayout layout = BvhLayout::Treelet; // fewest node pages per ray on the Snowman, see layout_bench
+    uint32_t treelet_size = 64; // Treelet: sibling pairs per cluster, 64 lines fill a 4 KiB page
+};
+
+struct BvhStats {
+    double build_ms = 0;
+    uint32_t node_count = 0; // reachable from the root, layout padding is left out
+    uint32_t leaf_count = 0;
+    uint32_t max_depth = 0;
+    float average_leaf_size = 0;
+    float sah_cost = 0; // expected cost of a random ray through the root, in primitive intersections
+};
+
+class Bvh
+{
+public:
+    BvhStats Stats(float traversal_cost = 1.0f) const;
+
+public:
+    std::vector<BvhNode, CacheLineAllocator<BvhNode>> nodes; // nodes[0] is the root
+    std::vector<uint32_t> references; // primitive ids, leaves own contiguous ranges
+    double build_ms = 0;
+};
+
+// Binned SAH over primitive bounds, the top splits bin in parallel and the subtrees below them are built concurrently.
+// settings.mode = FastBuild hands off to BuildLbvh. Bounds alone cannot be split, SpatialSplits builds plain SAH here
+Bvh BuildBvh(std::span<const Aabb> primitives, const BvhBuildSettings& settings = {});
+Bvh BuildBvh(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings = {});
+
+// Linear BVH: centroids are sorted along a 30 bit Morton curve with a parallel radix sort and the tree follows
+// the highest differing bit of the codes. Ranges of at most max_leaf_size primitives become leaves, the SAH fields are unused.
+// 30 code bits and then halvings of duplicate codes keep it within 63 levels, so max_depth is not needed here
+Bvh BuildLbvh(std::span<const Aabb> primitives, const BvhBuildSettings& settings = {});
+
+// SBVH (Stich et al. 2009): every node weighs the best object split against the best spatial split, which clips the
+// triangles straddling the plane into both children. A triangle can then sit in several leaves, references holds
+// each copy. Unsplitting puts a straddler on one side when that is cheaper, and spatial splits stop once the budget is spent
+Bvh BuildSbvh(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings = {});
+
+// Moves the nodes into layout order and renumbers left_first, references stay where they are.
+// Every builder ends with this for settings.layout, call it again to compare layouts on one tree
+void ReorderBvh(Bvh& bvh, BvhLayout layout, uint32_t treelet_size = 64);
+} // namespace w::cpu
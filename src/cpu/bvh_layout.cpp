@@ -0,0 +1,149 @@
+#include "bvh.hpp"
+#include <queue>
+
+// Layouts move sibling pairs, the unit traversal reads: visiting an inner node tests both of its children.
+// A pair is named by its parent, the inner node whose left_first points at it
+namespace {
+using namespace w::cpu;
+
+bool HasPair(const Bvh& bvh, uint32_t parent) noexcept
+{
+    return !bvh.nodes[parent].IsLeaf();
+}
+
+std::vector<uint32_t> DepthFirstOrder(const Bvh& bvh)
+{
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack{ 0 };
+    while (!stack.empty()) {
+        uint32_t parent = stack.back();
+        stack.pop_back();
+        order.push_back(parent);
+        uint32_t left = bvh.nodes[parent].left_first;
+        if (HasPair(bvh, left + 1)) {
+            stack.push_back(left + 1);
+        }
+        if (HasPair(bvh, left)) {
+            stack.push_back(left);
+        }
+    }
+    return order;
+}
+
+class VanEmdeBoasOrder
+{
+public:
+    explicit VanEmdeBoasOrder(const Bvh& bvh)
+        : bvh(bvh)
+    {
+    }
+
+public:
+    std::vector<uint32_t> Build()
+    {
+        // pair levels below every inner node, children come after parents in preorder
+        std::vector<uint32_t> preorder = DepthFirstOrder(bvh);
+        std::vector<uint32_t> levels(bvh.nodes.size(), 0);
+        for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+            uint32_t left = bvh.nodes[*it].left_first;
+            levels[*it] = 1 + std::max(levels[left], levels[left + 1]);
+        }
+        std::vector<uint32_t> frontier;
+        Lay(0, levels[0], frontier);
+        return std::move(order);
+    }
+
+private:
+    // lays out the top levels of the subtree under parent, the pairs just below them go to frontier
+    void Lay(uint32_t parent, uint32_t levels, std::vector<uint32_t>& frontier)
+    {
+        if (levels == 1) {
+            order.push_back(parent);
+            uint32_t left = bvh.nodes[parent].left_first;
+            for (uint32_t child : { left, left + 1 }) {
+                if (HasPair(bvh, child)) {
+                    frontier.push_back(child);
+                }
+            }
+            return;
+        }
+        uint32_t top = levels / 2;
+        std::vector<uint32_t> middle;
+        Lay(parent, top, middle);
+        for (uint32_t bottom : middle) {
+            Lay(bottom, levels - top, frontier);
+        }
+    }
+
+private:
+    const Bvh& bvh;
+    std::vector<uint32_t> order;
+};
+
+// a treelet grows from its root by taking the candidate with the largest parent area, the chance a ray that got
+// this far visits the pair. What is left over when it is full roots the next treelets, largest first
+std::vector<uint32_t> TreeletOrder(const Bvh& bvh, uint32_t treelet_size)
+{
+    using Candidate = std::pair<float, uint32_t>; // parent area, parent
+    auto candidate = [&bvh](uint32_t parent) { return Candidate{ bvh.nodes[parent].Bounds().HalfArea(), parent }; };
+
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> roots{ 0 };
+    std::vector<Candidate> left_over;
+    while (!roots.empty()) {
+        std::priority_queue<Candidate> candidates;
+        candidates.push(candidate(roots.back()));
+        roots.pop_back();
+        for (uint32_t size = 0; size < treelet_size && !candidates.empty(); ++size) {
+            uint32_t parent = candidates.top().second;
+            candidates.pop();
+            order.push_back(parent);
+            uint32_t left = bvh.nodes[parent].left_first;
+            for (uint32_t child : { left, left + 1 }) {
+                if (HasPair(bvh, child)) {
+                    candidates.push(candidate(child));
+                }
+            }
+        }
+        left_over.clear();
+        for (; !candidates.empty(); candidates.pop()) {
+            left_over.push_back(candidates.top());
+        }
+        for (auto it = left_over.rbegin(); it != left_over.rend(); ++it) { // smallest pushed first, largest popped next
+            roots.push_back(it->second);
+        }
+    }
+    return order;
+}
+} // namespace
+
+void w::cpu::ReorderBvh(Bvh& bvh, BvhLayout layout, uint32_t treelet_size)
+{
+    if (layout == BvhLayout::Build || bvh.nodes.empty() || bvh.nodes[0].IsLeaf()) {
+        return;
+    }
+    std::vector<uint32_t> order = layout == BvhLayout::VanEmdeBoas ? VanEmdeBoasOrder{ bvh }.Build()
+            : layout == BvhLayout::Treelet                         ? TreeletOrder(bvh, std::max(1u, treelet_size))
+                                                                   : DepthFirstOrder(bvh);
+
+    // the root and a padding node share the first line, pair k takes line k + 1
+    std::vector<uint32_t> first_child(bvh.nodes.size());
+    for (uint32_t k = 0; k < order.size(); ++k) {
+        first_child[order[k]] = 2 + 2 * k;
+    }
+    auto move_node = [&](uint32_t from) {
+        BvhNode node = bvh.nodes[from];
+        if (!node.IsLeaf()) {
+            node.left_first = first_child[from];
+        }
+        return node;
+    };
+    decltype(Bvh::nodes) nodes(2 + 2 * order.size());
+    nodes[0] = move_node(0);
+    for (uint32_t k = 0; k < order.size(); ++k) {
+        uint32_t left = bvh.nodes[order[k]].left_first;
+        nodes[2 + 2 * k] = move_node(left);
+        nodes[3 + 2 * k] = move_node(left + 1);
+    }
+    bvh.nodes = std::move(nodes);
+}
@@ -0,0 +1,135 @@
+#include "dynamic_blas.hpp"
+#include "../worker_pool.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+constexpr uint32_t min_chunk_size = 2048; // triangles per parallel chunk, smaller meshes refit on the calling thread
+}
+
+w::cpu::DynamicBlas::DynamicBlas(TriangleMesh mesh, const DynamicBlasSettings& settings)
+    : mesh(std::move(mesh)), settings(settings)
+{
+    uint32_t threads = settings.build.thread_count ? settings.build.thread_count : std::max(1u, std::thread::hardware_concurrency());
+    chunk_count = std::clamp(this->mesh.TriangleCount() / min_chunk_size, 1u, threads);
+    if (chunk_count > 1) {
+        pool = std::make_unique<w::WorkerPool>(chunk_count);
+    }
+    Rebuild();
+}
+
+w::cpu::DynamicBlas::~DynamicBlas() = default;
+
+w::cpu::BlasUpdate w::cpu::DynamicBlas::Update(std::span<const DirectX::XMFLOAT3> vertices)
+{
+    if (vertices.size() != mesh.positions.size()) {
+        throw std::runtime_error("DynamicBlas::Update: vertex count differs from the mesh the BLAS was built from");
+    }
+    auto start = std::chrono::steady_clock::now();
+    w::ParallelFor(pool.get(), uint32_t(vertices.size()), chunk_count, [this, vertices](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            mesh.positions[i] = float3{ vertices[i].x, vertices[i].y, vertices[i].z } * settings.scale;
+        }
+    });
+
+    Refit();
+    BlasUpdate result = BlasUpdate::Refit;
+    if (sah_cost > build_sah_cost * settings.rebuild_threshold) {
+        Rebuild();
+        result = BlasUpdate::Rebuild;
+    }
+    update_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void w::cpu::DynamicBlas::Rebuild()
+{
+    blas = Blas::Build(mesh, settings.build);
+    sah_cost = build_sah_cost = blas.bvh.Stats(settings.build.traversal_cost).sah_cost;
+    PlanRefit();
+}
+
+// widens the frontier level by level until there are a few subtrees per thread
+void w::cpu::DynamicBlas::PlanRefit()
+{
+    top.clear();
+    subtrees.clear();
+    if (blas.bvh.nodes.empty()) {
+        return;
+    }
+    subtrees.push_back(0);
+    if (!pool) {
+        return;
+    }
+    std::vector<uint32_t> next;
+    while (subtrees.size() < chunk_count * 4) {
+        next.clear();
+        for (uint32_t index : subtrees) {
+            const BvhNode& node = blas.bvh.nodes[index];
+            if (node.IsLeaf()) {
+                next.push_back(index);
+            } else {
+                top.push_back(index);
+                next.push_back(node.left_first);
+                next.push_back(node.left_first + 1);
+            }
+        }
+        if (next.size() == subtrees.size()) {
+            break; // only leaves left
+        }
+        subtrees.swap(next);
+    }
+}
+
+w::cpu::Aabb w::cpu::DynamicBlas::RefitSubtree(uint32_t node_index)
+{
+    BvhNode& node = blas.bvh.nodes[node_index];
+    Aabb bounds;
+    if (node.IsLeaf()) {
+        for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i) {
+            uint32_t t = blas.bvh.references[i];
+            float3 v0 = mesh.positions[mesh.indices[t * 3 + 0]];
+            float3 v1 = mesh.positions[mesh.indices[t * 3 + 1]];
+            float3 v2 = mesh.positions[mesh.indices[t * 3 + 2]];
+            blas.triangles[i] = { v0, v1 - v0, v2 - v0 };
+            bounds.Grow(v0);
+            bounds.Grow(v1);
+            bounds.Grow(v2);
+        }
+    } else {
+        bounds = RefitSubtree(node.left_first);
+        bounds.Grow(RefitSubtree(node.left_first + 1));
+    }
+    node.lo = bounds.lo;
+    node.hi = bounds.hi;
+    return bounds;
+}
+
+void w::cpu::DynamicBlas::Refit()
+{
+    if (blas.bvh.nodes.empty()) {
+        return;
+    }
+    if (pool) {
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(subtrees.size());
+        for (uint32_t node : subtrees) {
+            tasks.push_back(pool->Submit([this, node]() { RefitSubtree(node); }));
+        }
+        for (auto& task : tasks) {
+            task.get();
+        }
+    } else {
+        RefitSubtree(0);
+    }
+
+    // children were planned after their parents, walking back merges them first
+    for (auto it = top.rbegin(); it != top.rend(); ++it) {
+        BvhNode& node = blas.bvh.nodes[*it];
+        const BvhNode& left = blas.bvh.nodes[node.left_first];
+        const BvhNode& right = blas.bvh.nodes[node.left_first + 1];
+        node.lo = Min(left.lo, right.lo);
+        node.hi = Max(left.hi, right.hi);
+    }
+    sah_cost = blas.bvh.Stats(settings.build.traversal_cost).sah_cost;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "blas.hpp"
+#include "triangle_mesh.hpp"
+#include <DirectXMath.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace w {
+class WorkerPool;
+}
+
+namespace w::cpu {
+struct DynamicBlasSettings {
+    BvhBuildSettings build; // used for the first build and every rebuild, thread_count also sizes the refit
+    float3 scale{ 0.01f, -0.01f, 0.01f }; // applied to new vertices, same default as TriangleMesh::FromModel
+    float rebuild_threshold = 1.3f; // rebuild once the SAH cost is this many times the cost after the last build
+};
+
+enum class BlasUpdate {
+    Refit,
+    Rebuild,
+};
+
+// Blas for geometry whose vertices move but whose topology stays: updates refit the boxes of the existing tree
+// bottom-up and only rebuild when refitting has let the tree quality drift too far
+class DynamicBlas
+{
+public:
+    explicit DynamicBlas(TriangleMesh mesh, const DynamicBlasSettings& settings = {});
+    ~DynamicBlas();
+
+public:
+    // new positions in the layout of ModelLoader::vertices, the count has to match the mesh
+    BlasUpdate Update(std::span<const DirectX::XMFLOAT3> vertices);
+    void Rebuild();
+
+    const Blas& Get() const noexcept
+    {
+        return blas;
+    }
+    const TriangleMesh& Mesh() const noexcept
+    {
+        return mesh;
+    }
+    float SahCost() const noexcept
+    {
+        return sah_cost;
+    }
+    float BuildSahCost() const noexcept // right after the last (re)build
+    {
+        return build_sah_cost;
+    }
+    double UpdateMs() const noexcept // last Update, rebuilds included
+    {
+        return update_ms;
+    }
+
+private:
+    void Refit();
+    Aabb RefitSubtree(uint32_t node_index);
+    void PlanRefit();
+
+private:
+    TriangleMesh mesh;
+    DynamicBlasSettings settings;
+    Blas blas;
+    float sah_cost = 0;
+    float build_sah_cost = 0;
+    double update_ms = 0;
+
+    // refit plan, made after every build: subtrees are refit as tasks, the nodes above them afterwards
+    std::vector<uint32_t> top; // parents before children
+    std::vector<uint32_t> subtrees;
+    uint32_t chunk_count = 1;
+    std::unique_ptr<w::WorkerPool> pool;
+};
+} // namespace w::cpu
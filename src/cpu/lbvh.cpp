@@ -0,0 +1,213 @@
+#include "bvh.hpp"
+#include "morton_sort.hpp"
+#include "../worker_pool.hpp"
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace w::cpu;
+
+constexpr uint32_t min_chunk_size = 2048; // primitives per parallel chunk, smaller inputs stay on the calling thread
+
+class LbvhBuilder
+{
+public:
+    LbvhBuilder(std::span<const Aabb> primitives, const BvhBuildSettings& settings, Bvh& bvh)
+        : primitives(primitives), bvh(bvh)
+    {
+        uint32_t threads = settings.thread_count ? settings.thread_count : std::max(1u, std::thread::hardware_concurrency());
+        chunk_count = std::clamp(uint32_t(primitives.size() / min_chunk_size), 1u, threads);
+        if (chunk_count > 1) {
+            pool = std::make_unique<w::WorkerPool>(chunk_count);
+        }
+        leaf_size = std::max(1u, settings.max_leaf_size);
+    }
+
+public:
+    void Build()
+    {
+        if (primitives.empty()) {
+            return;
+        }
+        ComputeKeys();
+        RadixSort();
+
+        bvh.references.resize(primitives.size());
+        w::ParallelFor(pool.get(), uint32_t(keys.size()), chunk_count, [this](uint32_t, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                bvh.references[i] = uint32_t(keys[i]);
+            }
+        });
+        BuildHierarchy();
+    }
+
+private:
+    // key = morton code << 32 | primitive, so sorting the code bits alone leaves ties in primitive order
+    void ComputeKeys()
+    {
+        uint32_t count = uint32_t(primitives.size());
+        std::vector<Aabb> chunk_bounds(chunk_count);
+        w::ParallelFor(pool.get(), count, chunk_count, [this, &chunk_bounds](uint32_t chunk, uint32_t begin, uint32_t end) {
+            Aabb bounds;
+            for (uint32_t i = begin; i < end; ++i) {
+                bounds.Grow(primitives[i].Center());
+            }
+            chunk_bounds[chunk] = bounds;
+        });
+        Aabb centroids;
+        for (const Aabb& bounds : chunk_bounds) {
+            centroids.Grow(bounds);
+        }
+
+        float3 extent = centroids.Extent();
+        float3 scale{ extent.x > 0 ? 1.0f / extent.x : 0.0f, extent.y > 0 ? 1.0f / extent.y : 0.0f, extent.z > 0 ? 1.0f / extent.z : 0.0f };
+        keys.resize(count);
+        w::ParallelFor(pool.get(), count, chunk_count, [this, &centroids, scale](uint32_t, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t code = MortonCode((primitives[i].Center() - centroids.lo) * scale);
+                keys[i] = uint64_t(code) << 32 | i;
+            }
+        });
+    }
+
+    // sorts by the code half, ties stay in primitive order
+    void RadixSort()
+    {
+        std::vector<uint64_t> scratch;
+        RadixSortKeys(keys, scratch, chunk_count, [this](uint32_t count, auto&& f) { w::ParallelFor(pool.get(), count, chunk_count, f); });
+    }
+
+    uint32_t Code(uint32_t i) const noexcept
+    {
+        return uint32_t(keys[i] >> 32);
+    }
+
+    // first index of the upper half: where the highest bit that differs across the range flips to 1
+    uint32_t SplitRange(uint32_t first, uint32_t count) const noexcept
+    {
+        uint32_t a = Code(first);
+        uint32_t b = Code(first + count - 1);
+        if (a == b) {
+            return first + count / 2; // duplicate codes, halve the range
+        }
+        uint32_t bit = 1u << (31 - std::countl_zero(a ^ b));
+        uint32_t lo = first, hi = first + count - 1; // Code(lo) has the bit clear, Code(hi) has it set
+        while (lo + 1 < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            (Code(mid) & bit ? hi : lo) = mid;
+        }
+        return hi;
+    }
+
+    // makes node a leaf or gives it two children, returns false for a leaf
+    bool SplitNode(uint32_t node_index)
+    {
+        BvhNode& node = bvh.nodes[node_index];
+        uint32_t first = node.left_first;
+        uint32_t count = node.count;
+        if (count <= leaf_size) {
+            return false;
+        }
+        uint32_t middle = SplitRange(first, count);
+        uint32_t left = node_count.fetch_add(2, std::memory_order_relaxed);
+        bvh.nodes[left] = { .left_first = first, .count = middle - first };
+        bvh.nodes[left + 1] = { .left_first = middle, .count = first + count - middle };
+        node.left_first = left;
+        node.count = 0;
+        return true;
+    }
+
+    // the subtree below node, bounds are filled in on the way back up
+    Aabb BuildSubtree(uint32_t node_index)
+    {
+        if (!SplitNode(node_index)) {
+            BvhNode& node = bvh.nodes[node_index];
+            Aabb bounds;
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i) {
+                bounds.Grow(primitives[bvh.references[i]]);
+            }
+            node.lo = bounds.lo;
+            node.hi = bounds.hi;
+            return bounds;
+        }
+        uint32_t left = bvh.nodes[node_index].left_first;
+        Aabb bounds = BuildSubtree(left);
+        bounds.Grow(BuildSubtree(left + 1));
+        BvhNode& node = bvh.nodes[node_index];
+        node.lo = bounds.lo;
+        node.hi = bounds.hi;
+        return bounds;
+    }
+
+    void BuildHierarchy()
+    {
+        uint32_t count = uint32_t(primitives.size());
+        bvh.nodes.resize(count * 2 - 1);
+        bvh.nodes[0] = { .left_first = 0, .count = count };
+        node_count = 1;
+
+        // the top levels split here without bounds until ranges are small enough to be tasks,
+        // a few per thread so uneven Morton splits still balance
+        uint32_t task_size = std::max(min_chunk_size / 4, count / (chunk_count * 4));
+        if (!pool) {
+            BuildSubtree(0);
+            bvh.nodes.resize(node_count);
+            return;
+        }
+        std::vector<uint32_t> top; // split here, a child always after its parent
+        std::vector<uint32_t> subtrees;
+        std::vector<uint32_t> pending{ 0 };
+        while (!pending.empty()) {
+            uint32_t index = pending.back();
+            pending.pop_back();
+            if (bvh.nodes[index].count > task_size && SplitNode(index)) {
+                top.push_back(index);
+                pending.push_back(bvh.nodes[index].left_first);
+                pending.push_back(bvh.nodes[index].left_first + 1);
+            } else {
+                subtrees.push_back(index);
+            }
+        }
+
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(subtrees.size());
+        for (uint32_t node : subtrees) {
+            tasks.push_back(pool->Submit([this, node]() { BuildSubtree(node); }));
+        }
+        for (auto& task : tasks) {
+            task.get();
+        }
+
+        // reverse split order reaches children before their parents
+        for (auto it = top.rbegin(); it != top.rend(); ++it) {
+            BvhNode& node = bvh.nodes[*it];
+            const BvhNode& left = bvh.nodes[node.left_first];
+            const BvhNode& right = bvh.nodes[node.left_first + 1];
+            node.lo = Min(left.lo, right.lo);
+            node.hi = Max(left.hi, right.hi);
+        }
+        bvh.nodes.resize(node_count);
+    }
+
+private:
+    std::span<const Aabb> primitives;
+    Bvh& bvh;
+    uint32_t chunk_count = 1;
+    uint32_t leaf_size = 1;
+    std::vector<uint64_t> keys;
+    std::atomic<uint32_t> node_count{ 0 };
+    std::unique_ptr<w::WorkerPool> pool;
+};
+} // namespace
+
+w::cpu::Bvh w::cpu::BuildLbvh(std::span<const Aabb> primitives, const BvhBuildSettings& settings)
+{
+    auto start = std::chrono::steady_clock::now();
+    Bvh bvh;
+    LbvhBuilder{ primitives, settings, bvh }.Build();
+    ReorderBvh(bvh, settings.layout, settings.treelet_size);
+    bvh.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return bvh;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Scalar math for the CPU reference code, kept apart from DirectXMath so hot loops stay plain structs of floats
+namespace w::cpu {
+struct float3 {
+    float x = 0, y = 0, z = 0;
+
+    float operator[](uint32_t axis) const noexcept
+    {
+        return axis == 0 ? x : axis == 1 ? y : z;
+    }
+    float& operator[](uint32_t axis) noexcept
+    {
+        return axis == 0 ? x : axis == 1 ? y : z;
+    }
+};
+
+inline float3 operator+(float3 a, float3 b) noexcept
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+inline float3 operator-(float3 a, float3 b) noexcept
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+inline float3 operator-(float3 a) noexcept
+{
+    return { -a.x, -a.y, -a.z };
+}
+inline float3 operator*(float3 a, float3 b) noexcept
+{
+    return { a.x * b.x, a.y * b.y, a.z * b.z };
+}
+inline float3 operator*(float3 a, float s) noexcept
+{
+    return { a.x * s, a.y * s, a.z * s };
+}
+inline float3 operator*(float s, float3 a) noexcept
+{
+    return a * s;
+}
+inline float3 operator/(float3 a, float3 b) noexcept
+{
+    return { a.x / b.x, a.y / b.y, a.z / b.z };
+}
+inline float3 Min(float3 a, float3 b) noexcept
+{
+    return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) };
+}
+inline float3 Max(float3 a, float3 b) noexcept
+{
+    return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) };
+}
+inline float Dot(float3 a, float3 b) noexcept
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+inline float3 Cross(float3 a, float3 b) noexcept
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+inline float Length(float3 a) noexcept
+{
+    return std::sqrt(Dot(a, a));
+}
+inline float3 Normalize(float3 a) noexcept
+{
+    return a * (1.0f / Length(a));
+}
+
+struct Aabb {
+    float3 lo{ HUGE_VALF, HUGE_VALF, HUGE_VALF };
+    float3 hi{ -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+
+    void Grow(float3 p) noexcept
+    {
+        lo = Min(lo, p);
+        hi = Max(hi, p);
+    }
+    void Grow(const Aabb& b) noexcept
+    {
+        lo = Min(lo, b.lo);
+        hi = Max(hi, b.hi);
+    }
+    bool Empty() const noexcept
+    {
+        return lo.x > hi.x;
+    }
+    float3 Extent() const noexcept
+    {
+        return hi - lo;
+    }
+    float3 Center() const noexcept
+    {
+        return (lo + hi) * 0.5f;
+    }
+    float HalfArea() const noexcept // SAH only needs areas relative to each other
+    {
+        if (Empty()) {
+            return 0;
+        }
+        float3 e = Extent();
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+    uint32_t LargestAxis() const noexcept
+    {
+        float3 e = Extent();
+        return e.x >= e.y && e.x >= e.z ? 0 : e.y >= e.z ? 1 : 2;
+    }
+};
+} // namespace w::cpu
@@ -0,0 +1,73 @@
+#pragma once
+#include "math.hpp"
+#include <array>
+#include <vector>
+
+// Morton codes and the radix sort that orders them, shared by the LBVH builder and ray sorting
+namespace w::cpu {
+inline constexpr uint32_t radix_bits = 8;
+inline constexpr uint32_t radix_size = 1u << radix_bits;
+
+// spreads the low 10 bits of v two bits apart
+inline uint32_t ExpandBits(uint32_t v) noexcept
+{
+    v = (v * 0x00010001u) & 0xff0000ffu;
+    v = (v * 0x00000101u) & 0x0f00f00fu;
+    v = (v * 0x00000011u) & 0xc30c30c3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+// p in [0, 1]^3, 10 bits per axis
+inline uint32_t MortonCode(float3 p) noexcept
+{
+    auto quantize = [](float f) {
+        return uint32_t(std::clamp(f * 1024.0f, 0.0f, 1023.0f));
+    };
+    return ExpandBits(quantize(p.x)) << 2 | ExpandBits(quantize(p.y)) << 1 | ExpandBits(quantize(p.z));
+}
+
+// LSD radix sort of the low key_bits of the upper half of keys, 8 bits a pass: per chunk histograms, a prefix sum over
+// (digit, chunk) and a stable scatter where every chunk writes to its own ranges. for_each_chunk(count, f) runs
+// f(chunk, begin, end) over chunk_count pieces of [0, count), scratch ends up with keys.size() elements
+template<typename ForEachChunk>
+void RadixSortKeys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, uint32_t chunk_count, ForEachChunk&& for_each_chunk,
+                   uint32_t key_bits = 32)
+{
+    uint32_t count = uint32_t(keys.size());
+    scratch.resize(count);
+    std::vector<std::array<uint32_t, radix_size>> offsets(chunk_count);
+    for (uint32_t shift = 32; shift < 32 + key_bits; shift += radix_bits) {
+        for_each_chunk(count, [&keys, &offsets, shift](uint32_t chunk, uint32_t begin, uint32_t end) {
+            auto& histogram = offsets[chunk];
+            histogram.fill(0);
+            for (uint32_t i = begin; i < end; ++i) {
+                histogram[(keys[i] >> shift) & (radix_size - 1)]++;
+            }
+        });
+
+        uint32_t sum = 0;
+        bool single_digit = false;
+        for (uint32_t digit = 0; digit < radix_size; ++digit) {
+            uint32_t digit_start = sum;
+            for (auto& histogram : offsets) {
+                uint32_t n = histogram[digit];
+                histogram[digit] = sum;
+                sum += n;
+            }
+            single_digit |= sum - digit_start == count;
+        }
+        if (single_digit) {
+            continue; // every key has the same digit, the pass would only copy
+        }
+
+        for_each_chunk(count, [&keys, &offsets, &scratch, shift](uint32_t chunk, uint32_t begin, uint32_t end) {
+            auto& offset = offsets[chunk];
+            for (uint32_t i = begin; i < end; ++i) {
+                scratch[offset[(keys[i] >> shift) & (radix_size - 1)]++] = keys[i];
+            }
+        });
+        keys.swap(scratch);
+    }
+}
+} // namespace w::cpu
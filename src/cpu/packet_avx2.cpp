@@ -0,0 +1,5 @@
+#define W_SIMD_AVX2 1
+#define W_SIMD_NS avx2
+#include "packet_kernel.inl"
+#include "wavefront_kernel.inl"
+#include "sampler_kernel.inl"
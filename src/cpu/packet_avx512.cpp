@@ -0,0 +1,5 @@
+#define W_SIMD_AVX512 1
+#define W_SIMD_NS avx512
+#include "packet_kernel.inl"
+#include "wavefront_kernel.inl"
+#include "sampler_kernel.inl"
@@ -0,0 +1,297 @@
+// Packet traversal, compiled once per instruction set: the including file defines W_SIMD_<ISA> and W_SIMD_NS.
+// Rays of a packet walk the tree together: a node is entered when any active ray hits it, leaves are
+// intersected for the whole packet with the triangle broadcast to all lanes.
+#include "blas.hpp"
+#include "packet_kernels.hpp"
+#include "simd.hpp"
+
+namespace w::cpu::W_SIMD_NS {
+namespace {
+struct alignas(64) PacketData {
+    float ox[width], oy[width], oz[width];
+    float rx[width], ry[width], rz[width]; // inverse directions
+    float dx[width], dy[width], dz[width];
+    float t_min[width], t_max[width];
+};
+
+struct Entry {
+    uint32_t node;
+    float t_near;
+};
+
+struct Packet {
+    vfloat ox, oy, oz;
+    vfloat rx, ry, rz;
+    vfloat dx, dy, dz;
+    vfloat t_min, t_hit; // t_hit starts at t_max and shrinks with every closer hit
+    vfloat u, v, triangle; // triangle holds leaf order indices as raw bits
+};
+
+// Bounds on origin and inverse direction over all rays of the packet, x/y/z in the first three lanes. When every
+// ray has the same direction signs, (plane - origin) * inv_dir has a conservative interval per slab plane, and a
+// node whose near interval starts past its far interval is missed by every ray without testing the lanes
+struct PacketInterval {
+    __m128 origin_lo, origin_hi;
+    __m128 inv_lo, inv_hi;
+    __m128 positive; // all ones per axis with positive directions
+    float t_min;
+    bool common_origin;
+};
+
+inline __m128 Min4(__m128 a, __m128 b, __m128 c, __m128 d) noexcept
+{
+    return _mm_min_ps(_mm_min_ps(a, b), _mm_min_ps(c, d));
+}
+inline __m128 Max4(__m128 a, __m128 b, __m128 c, __m128 d) noexcept
+{
+    return _mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d));
+}
+
+// conservative [t_near, t_far] of the packet over the node, HUGE_VALF when it is empty
+inline float IntervalEntry(const PacketInterval& interval, const BvhNode& node, float t_hit_max) noexcept
+{
+    __m128 lo = _mm_loadu_ps(&node.lo.x); // fourth lane is left_first / count, dropped below
+    __m128 hi = _mm_loadu_ps(&node.hi.x);
+    __m128 near_plane = _mm_blendv_ps(hi, lo, interval.positive);
+    __m128 far_plane = _mm_blendv_ps(lo, hi, interval.positive);
+
+    // (plane - [origin_lo, origin_hi]) * [inv_lo, inv_hi], the extremes are among the corner products.
+    // Rays from one point (a pinhole camera) only have the two from the inverse direction bounds
+    __m128 t_near, t_far;
+    __m128 near_a = _mm_sub_ps(near_plane, interval.origin_hi), far_a = _mm_sub_ps(far_plane, interval.origin_hi);
+    if (interval.common_origin) {
+        t_near = _mm_min_ps(_mm_mul_ps(near_a, interval.inv_lo), _mm_mul_ps(near_a, interval.inv_hi));
+        t_far = _mm_max_ps(_mm_mul_ps(far_a, interval.inv_lo), _mm_mul_ps(far_a, interval.inv_hi));
+    } else {
+        __m128 near_b = _mm_sub_ps(near_plane, interval.origin_lo), far_b = _mm_sub_ps(far_plane, interval.origin_lo);
+        t_near = Min4(_mm_mul_ps(near_a, interval.inv_lo), _mm_mul_ps(near_a, interval.inv_hi),
+                      _mm_mul_ps(near_b, interval.inv_lo), _mm_mul_ps(near_b, interval.inv_hi));
+        t_far = Max4(_mm_mul_ps(far_a, interval.inv_lo), _mm_mul_ps(far_a, interval.inv_hi),
+                     _mm_mul_ps(far_b, interval.inv_lo), _mm_mul_ps(far_b, interval.inv_hi));
+    }
+
+    // lane 3 becomes the packet's own [t_min, t_hit_max]
+    t_near = _mm_insert_ps(t_near, _mm_set_ss(interval.t_min), 0x30);
+    t_far = _mm_insert_ps(t_far, _mm_set_ss(t_hit_max), 0x30);
+    t_near = _mm_max_ps(t_near, _mm_movehl_ps(t_near, t_near));
+    t_near = _mm_max_ss(t_near, _mm_movehdup_ps(t_near));
+    t_far = _mm_min_ps(t_far, _mm_movehl_ps(t_far, t_far));
+    t_far = _mm_min_ss(t_far, _mm_movehdup_ps(t_far));
+    float entry = _mm_cvtss_f32(t_near);
+    return entry <= _mm_cvtss_f32(t_far) ? entry : HUGE_VALF;
+}
+
+// false when the rays disagree on a direction sign, padding lanes repeat lane 0 and cannot change the bounds
+inline bool BuildInterval(const Packet& p, PacketInterval& interval) noexcept
+{
+    vfloat zero = Broadcast(0.0f);
+    uint32_t all = (1u << width) - 1;
+    uint32_t signs[3]{ Bits(p.rx > zero), Bits(p.ry > zero), Bits(p.rz > zero) };
+    for (uint32_t sign : signs) {
+        if (sign != 0 && sign != all) {
+            return false;
+        }
+    }
+    interval = {
+        .origin_lo = _mm_setr_ps(ReduceMin(p.ox), ReduceMin(p.oy), ReduceMin(p.oz), 0),
+        .origin_hi = _mm_setr_ps(ReduceMax(p.ox), ReduceMax(p.oy), ReduceMax(p.oz), 0),
+        .inv_lo = _mm_setr_ps(ReduceMin(p.rx), ReduceMin(p.ry), ReduceMin(p.rz), 0),
+        .inv_hi = _mm_setr_ps(ReduceMax(p.rx), ReduceMax(p.ry), ReduceMax(p.rz), 0),
+        .positive = _mm_castsi128_ps(_mm_setr_epi32(signs[0] ? -1 : 0, signs[1] ? -1 : 0, signs[2] ? -1 : 0, 0)),
+        .t_min = ReduceMin(p.t_min),
+    };
+    interval.common_origin = _mm_movemask_ps(_mm_cmpeq_ps(interval.origin_lo, interval.origin_hi)) == 0xf;
+    return true;
+}
+
+// entry distance of the closest ray that hits the node, HUGE_VALF when none does
+inline float VisitNode(const Packet& p, const BvhNode& node) noexcept
+{
+    vfloat t0x = (Broadcast(node.lo.x) - p.ox) * p.rx;
+    vfloat t1x = (Broadcast(node.hi.x) - p.ox) * p.rx;
+    vfloat t0y = (Broadcast(node.lo.y) - p.oy) * p.ry;
+    vfloat t1y = (Broadcast(node.hi.y) - p.oy) * p.ry;
+    vfloat t0z = (Broadcast(node.lo.z) - p.oz) * p.rz;
+    vfloat t1z = (Broadcast(node.hi.z) - p.oz) * p.rz;
+    vfloat t_near = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), p.t_min));
+    vfloat t_far = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), p.t_hit));
+    vmask hit = t_near <= t_far;
+    if (!Bits(hit)) {
+        return HUGE_VALF;
+    }
+    return ReduceMin(Select(hit, t_near, Broadcast(HUGE_VALF)));
+}
+
+// same operation order as CrossesTriangle so lanes agree with the scalar path, lanes set in the mask hit
+// within (t_min, t_hit)
+inline vmask HitTriangle(const Packet& p, const Triangle& tri, vfloat& t, vfloat& u, vfloat& v) noexcept
+{
+    vfloat e1x = Broadcast(tri.e1.x), e1y = Broadcast(tri.e1.y), e1z = Broadcast(tri.e1.z);
+    vfloat e2x = Broadcast(tri.e2.x), e2y = Broadcast(tri.e2.y), e2z = Broadcast(tri.e2.z);
+
+    vfloat px = p.dy * e2z - p.dz * e2y;
+    vfloat py = p.dz * e2x - p.dx * e2z;
+    vfloat pz = p.dx * e2y - p.dy * e2x;
+    vfloat inv_det = Broadcast(1.0f) / (e1x * px + e1y * py + e1z * pz);
+    vfloat sx = p.ox - Broadcast(tri.v0.x);
+    vfloat sy = p.oy - Broadcast(tri.v0.y);
+    vfloat sz = p.oz - Broadcast(tri.v0.z);
+    u = (sx * px + sy * py + sz * pz) * inv_det;
+    vfloat qx = sy * e1z - sz * e1y;
+    vfloat qy = sz * e1x - sx * e1z;
+    vfloat qz = sx * e1y - sy * e1x;
+    v = (p.dx * qx + p.dy * qy + p.dz * qz) * inv_det;
+    t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+    vfloat zero = Broadcast(0.0f);
+    return (u >= zero) & (v >= zero) & (u + v <= Broadcast(1.0f)) & (t > p.t_min) & (t < p.t_hit);
+}
+
+inline void IntersectLeaf(Packet& p, const Triangle* triangles, uint32_t first, uint32_t count) noexcept
+{
+    for (uint32_t i = first; i < first + count; ++i) {
+        vfloat t, u, v;
+        vmask hit = HitTriangle(p, triangles[i], t, u, v);
+        if (Bits(hit)) {
+            p.t_hit = Select(hit, t, p.t_hit);
+            p.u = Select(hit, u, p.u);
+            p.v = Select(hit, v, p.v);
+            p.triangle = Select(hit, BroadcastBits(i), p.triangle);
+        }
+    }
+}
+
+// any hit: an occluded lane gets an empty interval, so no node or triangle takes it in again. Returns the lanes it occluded
+inline uint32_t OccludeLeaf(Packet& p, const Triangle* triangles, uint32_t first, uint32_t count) noexcept
+{
+    uint32_t occluded = 0;
+    for (uint32_t i = first; i < first + count; ++i) {
+        vfloat t, u, v;
+        vmask hit = HitTriangle(p, triangles[i], t, u, v);
+        if (Bits(hit)) {
+            occluded |= Bits(hit);
+            p.t_hit = Select(hit, Broadcast(-HUGE_VALF), p.t_hit);
+        }
+    }
+    return occluded;
+}
+
+// closest hit into hits, or with any_hit only whether something lies within [t_min, t_max] into occluded
+template<bool any_hit>
+void TracePacket(const Blas& blas, const Ray* rays, uint32_t count, Hit* hits, uint8_t* occluded, bool interval_culling) noexcept
+{
+    // padding lanes get an empty [t_min, t_max] and never hit anything
+    PacketData data;
+    for (uint32_t lane = 0; lane < width; ++lane) {
+        Ray ray = rays[lane < count ? lane : 0];
+        if (lane >= count) {
+            ray.t_min = 0;
+            ray.t_max = -1;
+        }
+        float3 inv = SafeInverse(ray.dir);
+        data.ox[lane] = ray.origin.x, data.oy[lane] = ray.origin.y, data.oz[lane] = ray.origin.z;
+        data.rx[lane] = inv.x, data.ry[lane] = inv.y, data.rz[lane] = inv.z;
+        data.dx[lane] = ray.dir.x, data.dy[lane] = ray.dir.y, data.dz[lane] = ray.dir.z;
+        data.t_min[lane] = ray.t_min, data.t_max[lane] = ray.t_max;
+    }
+    Packet p{
+        .ox = Load(data.ox), .oy = Load(data.oy), .oz = Load(data.oz),
+        .rx = Load(data.rx), .ry = Load(data.ry), .rz = Load(data.rz),
+        .dx = Load(data.dx), .dy = Load(data.dy), .dz = Load(data.dz),
+        .t_min = Load(data.t_min), .t_hit = Load(data.t_max),
+        .u = Broadcast(0.0f), .v = Broadcast(0.0f), .triangle = BroadcastBits(~0u)
+    };
+
+    const BvhNode* nodes = blas.bvh.nodes.data();
+    float t_hit_max = ReduceMax(p.t_hit); // furthest any ray can still reach
+    Entry current{ 0, blas.bvh.nodes.empty() ? HUGE_VALF : VisitNode(p, nodes[0]) };
+
+    // set up only for packets that made it past the root, most of a frame around a small model never does
+    PacketInterval interval;
+    interval_culling = interval_culling && current.t_near != HUGE_VALF && BuildInterval(p, interval);
+    // with an interval, inner nodes are entered on the packet bound alone and only leaves are tested per lane
+    auto visit = [&](const BvhNode& node) {
+        if (!interval_culling) {
+            return VisitNode(p, node);
+        }
+        float entry = IntervalEntry(interval, node, t_hit_max);
+        return entry == HUGE_VALF || !node.IsLeaf() ? entry : VisitNode(p, node);
+    };
+
+    Entry stack[traversal_stack_size];
+    uint32_t top = 0;
+    uint32_t occluded_bits = 0;
+    uint32_t live_bits = (1u << count) - 1;
+    while (current.t_near != HUGE_VALF) {
+        const BvhNode& node = nodes[current.node];
+        if (node.IsLeaf()) {
+            if constexpr (any_hit) {
+                occluded_bits |= OccludeLeaf(p, blas.triangles.data(), node.left_first, node.count);
+                if ((occluded_bits & live_bits) == live_bits) {
+                    break;
+                }
+            } else {
+                IntersectLeaf(p, blas.triangles.data(), node.left_first, node.count);
+            }
+            t_hit_max = ReduceMax(p.t_hit);
+        } else {
+            Entry near{ node.left_first, visit(nodes[node.left_first]) };
+            Entry far{ node.left_first + 1, visit(nodes[node.left_first + 1]) };
+            if (far.t_near < near.t_near) {
+                std::swap(near, far);
+            }
+            if (near.t_near != HUGE_VALF) {
+                if (far.t_near != HUGE_VALF) {
+                    stack[top++] = far;
+                }
+                current = near;
+                continue;
+            }
+        }
+
+        // pop, a node entered past every ray's current hit is dead
+        current.t_near = HUGE_VALF;
+        while (top > 0) {
+            Entry entry = stack[--top];
+            if (entry.t_near < t_hit_max) {
+                current = entry;
+                break;
+            }
+        }
+    }
+
+    if constexpr (any_hit) {
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            occluded[lane] = occluded_bits >> lane & 1;
+        }
+        return;
+    }
+    alignas(64) float t[width], u[width], v[width], triangle[width];
+    Store(t, p.t_hit);
+    Store(u, p.u);
+    Store(v, p.v);
+    Store(triangle, p.triangle);
+    for (uint32_t lane = 0; lane < count; ++lane) {
+        uint32_t index;
+        std::memcpy(&index, &triangle[lane], sizeof(index));
+        hits[lane] = index == ~0u ? Hit{} : Hit{ t[lane], u[lane], v[lane], blas.bvh.references[index] };
+    }
+}
+} // namespace
+
+void TracePackets(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits, bool interval_culling) noexcept
+{
+    for (size_t first = 0; first < rays.size(); first += width) {
+        uint32_t count = uint32_t(std::min<size_t>(width, rays.size() - first));
+        TracePacket<false>(blas, rays.data() + first, count, hits.data() + first, nullptr, interval_culling);
+    }
+}
+
+void OccludedPackets(const Blas& blas, std::span<const Ray> rays, std::span<uint8_t> occluded, bool interval_culling) noexcept
+{
+    for (size_t first = 0; first < rays.size(); first += width) {
+        uint32_t count = uint32_t(std::min<size_t>(width, rays.size() - first));
+        TracePacket<true>(blas, rays.data() + first, count, nullptr, occluded.data() + first, interval_culling);
+    }
+}
+} // namespace w::cpu::W_SIMD_NS
@@ -0,0 +1,21 @@
+#pragma once
+#include "ray.hpp"
+#include <span>
+
+// entry points of the per instruction set packet kernels, each built from packet_kernel.inl with its own flags
+namespace w::cpu {
+class Blas;
+
+namespace sse {
+void TracePackets(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits, bool interval_culling) noexcept;
+void OccludedPackets(const Blas& blas, std::span<const Ray> rays, std::span<uint8_t> occluded, bool interval_culling) noexcept;
+}
+namespace avx2 {
+void TracePackets(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits, bool interval_culling) noexcept;
+void OccludedPackets(const Blas& blas, std::span<const Ray> rays, std::span<uint8_t> occluded, bool interval_culling) noexcept;
+}
+namespace avx512 {
+void TracePackets(const Blas& blas, std::span<const Ray> rays, std::span<Hit> hits, bool interval_culling) noexcept;
+void OccludedPackets(const Blas& blas, std::span<const Ray> rays, std::span<uint8_t> occluded, bool interval_culling) noexcept;
+}
+} // namespace w::cpu
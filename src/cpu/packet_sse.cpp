@@ -0,0 +1,5 @@
+#define W_SIMD_SSE 1
+#define W_SIMD_NS sse
+#include "packet_kernel.inl"
+#include "wavefront_kernel.inl"
+#include "sampler_kernel.inl"
@@ -0,0 +1,343 @@
+#include "path_tracer.hpp"
+#include "wavefront_kernels.hpp"
+#include <bit>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace w::cpu;
+
+// hash of path, bounce and frame (PCG output permutation), the only source of randomness
+uint32_t Hash(uint32_t path, uint32_t bounce, uint32_t seed, uint32_t draw) noexcept
+{
+    uint32_t state = path * 747796405u + (bounce * 16 + draw) * 2891336453u + seed * 1181783497u + 1;
+    state = state * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// uniform point on the unit disk by rejection, the draws are deterministic so both kernels see the same point
+void DiskSample(uint32_t path, uint32_t bounce, uint32_t seed, float& x, float& y) noexcept
+{
+    for (uint32_t draw = 0; draw < 16; draw += 2) { // 8 misses in a row is a 1 in 200000 event
+        x = float(Hash(path, bounce, seed, draw) >> 8) * 0x1p-23f - 1.0f;
+        y = float(Hash(path, bounce, seed, draw + 1) >> 8) * 0x1p-23f - 1.0f;
+        if (x * x + y * y < 1.0f) {
+            return;
+        }
+    }
+    x = y = 0;
+}
+
+struct PathVertex {
+    bool missed = false;
+    float3 sky; // missed: what the path brings back
+    bool shadow = false;
+    Ray shadow_ray;
+    float3 contribution; // light reaching the pixel when shadow_ray is unoccluded
+    bool bounce = false;
+    Ray next;
+    float3 throughput;
+};
+
+// one path step after extend, wavefront_kernel.inl runs the same operations per lane
+PathVertex ShadePath(const Ray& ray, const Hit& hit, const TriangleMesh& mesh, float3 throughput, float disk_x, float disk_y,
+                     bool bounce) noexcept
+{
+    PathVertex vertex;
+    if (hit.Missed()) {
+        vertex.missed = true;
+        vertex.sky = throughput * MissColor(ray.dir);
+        return vertex;
+    }
+
+    float3 p = ray.origin + ray.dir * hit.t;
+    float3 v0 = mesh.positions[mesh.indices[hit.primitive * 3 + 0]];
+    float3 v1 = mesh.positions[mesh.indices[hit.primitive * 3 + 1]];
+    float3 v2 = mesh.positions[mesh.indices[hit.primitive * 3 + 2]];
+    float3 n = Normalize(Cross(v1 - v0, v2 - v0));
+    if (Dot(n, ray.dir) > 0) {
+        n = -n;
+    }
+
+    float3 albedo = hit_color * path_albedo;
+    float3 l = light - p;
+    float dist = Length(l);
+    l = l * (1.0f / dist);
+    float cos_light = Dot(n, l);
+    if (cos_light > 0) {
+        vertex.shadow = true;
+        vertex.shadow_ray = { .origin = p, .dir = l, .t_max = dist };
+        vertex.contribution = throughput * albedo * (cos_light * light_intensity);
+    }
+
+    if (bounce) {
+        float s = disk_x * disk_x + disk_y * disk_y;
+        float r = 2.0f * std::sqrt(1.0f - s);
+        float3 b = n + float3{ disk_x * r, disk_y * r, 1.0f - 2.0f * s };
+        float length2 = Dot(b, b);
+        b = length2 > 1e-12f ? b * (1.0f / std::sqrt(length2)) : n;
+        vertex.throughput = throughput * albedo;
+        vertex.bounce = std::max({ vertex.throughput.x, vertex.throughput.y, vertex.throughput.z }) > 0;
+        vertex.next = { .origin = p, .dir = b };
+    }
+    return vertex;
+}
+
+void ShadePathsScalar(const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows, float3* radiance) noexcept
+{
+    for (uint32_t i = 0; i < in.count; ++i) {
+        PathVertex vertex = ShadePath(in.rays[i], in.hits[i], mesh, { in.throughput_r[i], in.throughput_g[i], in.throughput_b[i] },
+                                      in.disk_x[i], in.disk_y[i], bounce);
+        uint32_t pixel = in.pixel[i];
+        if (vertex.missed) {
+            radiance[pixel] = radiance[pixel] + vertex.sky;
+            continue;
+        }
+        if (vertex.shadow) {
+            uint32_t s = shadows.count++;
+            shadows.rays[s] = vertex.shadow_ray;
+            shadows.pixel[s] = pixel;
+            shadows.contribution_r[s] = vertex.contribution.x, shadows.contribution_g[s] = vertex.contribution.y,
+            shadows.contribution_b[s] = vertex.contribution.z;
+        }
+        if (vertex.bounce) {
+            uint32_t c = next.count++;
+            next.rays[c] = vertex.next;
+            next.path[c] = in.path[i];
+            next.pixel[c] = pixel;
+            next.throughput_r[c] = vertex.throughput.x, next.throughput_g[c] = vertex.throughput.y, next.throughput_b[c] = vertex.throughput.z;
+        }
+    }
+}
+
+void ShadePaths(SimdIsa isa, const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows,
+                float3* radiance) noexcept
+{
+    switch (isa) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::ShadePaths(in, mesh, bounce, next, shadows, radiance);
+    case SimdIsa::AVX2:
+        return avx2::ShadePaths(in, mesh, bounce, next, shadows, radiance);
+    case SimdIsa::SSE:
+        return sse::ShadePaths(in, mesh, bounce, next, shadows, radiance);
+#endif
+    default:
+        return ShadePathsScalar(in, mesh, bounce, next, shadows, radiance);
+    }
+}
+
+void GenerateRays(SimdIsa isa, const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t count, Ray* rays) noexcept
+{
+    switch (isa) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::GenerateRays(camera, x, y, width, count, rays);
+    case SimdIsa::AVX2:
+        return avx2::GenerateRays(camera, x, y, width, count, rays);
+    case SimdIsa::SSE:
+        return sse::GenerateRays(camera, x, y, width, count, rays);
+#endif
+    default:
+        for (uint32_t i = 0; i < count; ++i) {
+            rays[i] = camera.Generate(x + i % width, y + i / width);
+        }
+    }
+}
+
+// tile x, y, width, height of the camera image, paths numbered pixel by pixel with the samples of a pixel adjacent
+struct TileRange {
+    uint32_t x, y, width, height;
+    uint32_t image_width;
+    uint32_t samples;
+
+    uint32_t Path(uint32_t pixel, uint32_t sample) const noexcept
+    {
+        return ((y + pixel / width) * image_width + x + pixel % width) * samples + sample;
+    }
+};
+
+void Megakernel(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, const TileRange& tile, std::span<float3> radiance,
+                const PathTraceSettings& settings, PathTraceStats& stats)
+{
+    for (uint32_t pixel = 0; pixel < tile.width * tile.height; ++pixel) {
+        for (uint32_t sample = 0; sample < tile.samples; ++sample) {
+            uint32_t path = tile.Path(pixel, sample);
+            Ray ray = camera.Generate(tile.x + pixel % tile.width, tile.y + pixel / tile.width);
+            float3 throughput{ 1, 1, 1 };
+            for (uint32_t bounce = 0;; ++bounce) {
+                Hit hit = blas.Trace(ray);
+                stats.extension_rays++;
+                float disk_x, disk_y;
+                DiskSample(path, bounce, settings.seed, disk_x, disk_y);
+                PathVertex vertex = ShadePath(ray, hit, mesh, throughput, disk_x, disk_y, bounce < settings.max_bounces);
+                if (vertex.missed) {
+                    radiance[pixel] = radiance[pixel] + vertex.sky;
+                    break;
+                }
+                if (vertex.shadow) {
+                    stats.shadow_rays++;
+                    if (!blas.Occluded(vertex.shadow_ray)) {
+                        radiance[pixel] = radiance[pixel] + vertex.contribution;
+                    }
+                }
+                if (!vertex.bounce) {
+                    break;
+                }
+                ray = vertex.next;
+                throughput = vertex.throughput;
+            }
+        }
+    }
+}
+
+// generate, then extend, shade and shadow connect once per bounce over all paths still alive
+void Wavefront(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, const TileRange& tile, std::span<float3> radiance,
+               const PathTraceSettings& settings, PathTraceStats& stats)
+{
+    struct Queues {
+        PathQueue paths, next;
+        ShadowQueue shadows;
+        uint32_t capacity = 0;
+        std::unique_ptr<RaySorter> sorter;
+        std::vector<uint32_t> order;
+        std::vector<Ray> camera_rays;
+        std::vector<Ray> sorted_rays;
+        std::vector<Hit> sorted_hits;
+        std::vector<uint8_t> sorted_occluded;
+    };
+    thread_local Queues queues; // kept per worker, tiles of a frame reuse the allocations
+    uint32_t path_count = tile.width * tile.height * tile.samples;
+    if (queues.capacity < path_count) {
+        queues.capacity = path_count;
+        queues.paths.Reserve(path_count);
+        queues.next.Reserve(path_count);
+        queues.shadows.Reserve(path_count);
+        queues.camera_rays.resize(path_count);
+        queues.sorted_rays.resize(path_count);
+        queues.sorted_hits.resize(path_count);
+        queues.sorted_occluded.resize(path_count);
+    }
+    if (settings.sort_rays && (!queues.sorter || queues.sorter->Settings().origin_bits != settings.sort.origin_bits ||
+                               queues.sorter->Settings().thread_count != settings.sort.thread_count)) {
+        queues.sorter = std::make_unique<RaySorter>(settings.sort);
+    }
+    SimdIsa isa = ClampSimdIsa(settings.packets.isa);
+    auto ms_since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    PathQueue& paths = queues.paths;
+    paths.count = path_count;
+    GenerateRays(isa, camera, tile.x, tile.y, tile.width, tile.width * tile.height, queues.camera_rays.data());
+    for (uint32_t pixel = 0, i = 0; pixel < tile.width * tile.height; ++pixel) {
+        for (uint32_t sample = 0; sample < tile.samples; ++sample, ++i) {
+            paths.rays[i] = queues.camera_rays[pixel];
+            paths.path[i] = tile.Path(pixel, sample);
+            paths.pixel[i] = pixel;
+            paths.throughput_r[i] = paths.throughput_g[i] = paths.throughput_b[i] = 1.0f;
+        }
+    }
+    stats.generate_ms += ms_since(start);
+
+    // traversal ms of one stage, query(rays, results) being closest hit or occlusion. With sort the rays go through
+    // the sorter and its time lands in sort_ms
+    auto trace = [&]<typename Result>(std::span<const Ray> rays, std::span<Result> results, std::vector<Result>& sorted_results, bool sort,
+                                      auto&& query) {
+        auto begin = std::chrono::steady_clock::now();
+        if (!sort) {
+            query(rays, results);
+            return ms_since(begin);
+        }
+        queues.sorter->Sort(rays, queues.order);
+        for (uint32_t i = 0; i < rays.size(); ++i) {
+            queues.sorted_rays[i] = rays[queues.order[i]];
+        }
+        double sort_ms = ms_since(begin);
+
+        begin = std::chrono::steady_clock::now();
+        query(std::span<const Ray>{ queues.sorted_rays.data(), rays.size() }, std::span<Result>{ sorted_results.data(), rays.size() });
+        double trace_ms = ms_since(begin);
+
+        begin = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < rays.size(); ++i) {
+            results[queues.order[i]] = sorted_results[i];
+        }
+        stats.sort_ms += sort_ms + ms_since(begin);
+        return trace_ms;
+    };
+    auto closest_hit = [&](std::span<const Ray> rays, std::span<Hit> hits) { blas.TracePackets(rays, hits, settings.packets); };
+    auto occlusion = [&](std::span<const Ray> rays, std::span<uint8_t> occluded) { blas.OccludedPackets(rays, occluded, settings.packets); };
+
+    for (uint32_t bounce = 0; queues.paths.count; ++bounce) {
+        PathQueue& current = queues.paths;
+        // queues stay in pixel order, so rays leaving camera ray hits are as coherent as the pixels; from the hits of
+        // bounce rays on neighbours start anywhere
+        bool sort_extend = settings.sort_rays && bounce > 1;
+        bool sort_shadows = settings.sort_rays && bounce > 0;
+        stats.extend_ms += trace(std::span<const Ray>{ current.rays.data(), current.count }, std::span<Hit>{ current.hits.data(), current.count },
+                                 queues.sorted_hits, sort_extend, closest_hit);
+        stats.extension_rays += current.count;
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < current.count; ++i) {
+            DiskSample(current.path[i], bounce, settings.seed, current.disk_x[i], current.disk_y[i]);
+        }
+        queues.next.count = 0;
+        queues.shadows.count = 0;
+        ShadePaths(isa, current, mesh, bounce < settings.max_bounces, queues.next, queues.shadows, radiance.data());
+        stats.shade_ms += ms_since(start);
+
+        ShadowQueue& shadows = queues.shadows;
+        stats.shadow_ms += trace(std::span<const Ray>{ shadows.rays.data(), shadows.count },
+                                 std::span<uint8_t>{ shadows.occluded.data(), shadows.count }, queues.sorted_occluded, sort_shadows, occlusion);
+        start = std::chrono::steady_clock::now();
+        for (uint32_t s = 0; s < shadows.count; ++s) {
+            if (!shadows.occluded[s]) {
+                float3& target = radiance[shadows.pixel[s]];
+                target = target + float3{ shadows.contribution_r[s], shadows.contribution_g[s], shadows.contribution_b[s] };
+            }
+        }
+        stats.shadow_ms += ms_since(start);
+        stats.shadow_rays += shadows.count;
+
+        std::swap(queues.paths, queues.next);
+    }
+}
+} // namespace
+
+w::cpu::PathTraceStats w::cpu::RenderPathTile(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, uint32_t x, uint32_t y,
+                                              uint32_t width, uint32_t height, std::span<uint32_t> rgba8, const PathTraceSettings& settings)
+{
+    PathTraceStats stats;
+    TileRange tile{ x, y, width, height, camera.width, std::max(1u, settings.samples_per_pixel) };
+    std::vector<float3> radiance(size_t(width) * height);
+    if (settings.kernel == PathKernel::Megakernel) {
+        Megakernel(blas, mesh, camera, tile, radiance, settings, stats);
+    } else {
+        Wavefront(blas, mesh, camera, tile, radiance, settings, stats);
+    }
+
+    float scale = 1.0f / float(tile.samples);
+    for (uint32_t pixel = 0; pixel < width * height; ++pixel) {
+        uint32_t packed = PackUnorm8(radiance[pixel] * scale);
+        rgba8[(y + pixel / width) * camera.width + x + pixel % width] = std::endian::native == std::endian::little ? packed : std::byteswap(packed);
+    }
+    return stats;
+}
+
+w::cpu::PathTraceStats w::cpu::RenderPaths(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, std::span<uint32_t> rgba8,
+                                           const PathTraceSettings& settings)
+{
+    return RenderPathTile(blas, mesh, camera, 0, 0, camera.width, camera.height, rgba8, settings);
+}
+
+void w::cpu::RenderPaths(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, std::span<uint32_t> rgba8,
+                         TileScheduler& scheduler, const PathTraceSettings& settings)
+{
+    scheduler.Run(camera.width, camera.height, [&](const Tile& tile) {
+        RenderPathTile(blas, mesh, camera, tile.x, tile.y, tile.width, tile.height, rgba8, settings);
+    });
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "ray_sort.hpp"
+#include "reference_renderer.hpp"
+#include "triangle_mesh.hpp"
+#include <span>
+
+// Paths past the first hit, which the GPU shader does not trace yet. Miss and the first hit color follow
+// raytracing.lib.hlsl; from there hit_color scaled by path_albedo is a diffuse albedo, every hit is connected
+// to light with a shadow ray and the sky of Miss lights every path that escapes.
+// Both kernels draw the same random numbers per path and bounce, and the SIMD stages repeat the scalar operations
+// without contracting them into fused multiply adds, so they render the same image
+namespace w::cpu {
+inline constexpr float path_albedo = 0.5f;
+inline constexpr float light_intensity = 1.0f; // irradiance from light at normal incidence, far enough to not fall off
+
+enum class PathKernel {
+    Megakernel, // each path runs every bounce on its own, single ray traversal
+    Wavefront, // all paths of a tile advance one stage at a time over compacted queues
+};
+
+struct PathTraceSettings {
+    PathKernel kernel = PathKernel::Wavefront;
+    uint32_t max_bounces = 4; // diffuse bounces after the camera ray
+    uint32_t samples_per_pixel = 1;
+    uint32_t seed = 0; // frame index, picks the noise
+    PacketTraceSettings packets; // isa of the wavefront stages, packet traversal for extend and shadow rays
+    bool sort_rays = false; // Wavefront only: rays leaving bounce ray hits are traced in RaySorter order, see ray_sort_bench
+    RaySortSettings sort;
+};
+
+// summed over the tiles a call rendered
+struct PathTraceStats {
+    uint64_t extension_rays = 0; // camera and bounce rays
+    uint64_t shadow_rays = 0;
+    double generate_ms = 0; // Wavefront only, per stage
+    double extend_ms = 0;
+    double shade_ms = 0;
+    double shadow_ms = 0;
+    double sort_ms = 0; // keys, sort and the gather and scatter around traversal, extend_ms and shadow_ms leave it out
+};
+
+// rgba8 as in RenderTile, the radiance of the pixel's samples averaged and packed like the GPU image
+PathTraceStats RenderPathTile(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, uint32_t x, uint32_t y,
+                              uint32_t width, uint32_t height, std::span<uint32_t> rgba8, const PathTraceSettings& settings = {});
+PathTraceStats RenderPaths(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, std::span<uint32_t> rgba8,
+                           const PathTraceSettings& settings = {});
+// tiles spread over the scheduler's workers, the wavefront runs one tile at a time per worker
+void RenderPaths(const Blas& blas, const TriangleMesh& mesh, const PrimaryRays& camera, std::span<uint32_t> rgba8,
+                 TileScheduler& scheduler, const PathTraceSettings& settings = {});
+} // namespace w::cpu
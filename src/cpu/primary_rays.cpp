@@ -0,0 +1,45 @@
+#include "primary_rays.hpp"
+#include <cstring>
+
+w::cpu::PrimaryRays::PrimaryRays(const w::Camera::CBuffer& camera, uint32_t width, uint32_t height) noexcept
+    : width(width), height(height)
+{
+    std::memcpy(inv_view, &camera.inv_view, sizeof(inv_view));
+    std::memcpy(inv_projection, &camera.inv_projection, sizeof(inv_projection));
+}
+
+w::cpu::Ray w::cpu::PrimaryRays::Generate(uint32_t x, uint32_t y) const noexcept
+{
+    // HLSL reads the row major XMFLOAT4X4 as column major, so its mul(matrix, v) is v * matrix here
+    auto transform = [](const float (&m)[4][4], float x, float y, float z, float w) {
+        return float3{ x * m[0][0] + y * m[1][0] + z * m[2][0] + w * m[3][0],
+                       x * m[0][1] + y * m[1][1] + z * m[2][1] + w * m[3][1],
+                       x * m[0][2] + y * m[1][2] + z * m[2][2] + w * m[3][2] };
+    };
+    float dx = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+    float dy = (float(y) + 0.5f) / float(height) * 2.0f - 1.0f;
+    float3 target = Normalize(transform(inv_projection, dx, dy, 1, 1));
+
+    Ray ray;
+    ray.origin = transform(inv_view, 0, 0, 0, 1);
+    ray.dir = transform(inv_view, target.x, target.y, target.z, 0);
+    return ray;
+}
+
+void w::cpu::PrimaryRays::GenerateTiled(uint32_t tile_width, uint32_t tile_height, std::vector<Ray>& rays, std::vector<uint32_t>& pixels) const
+{
+    rays.clear();
+    pixels.clear();
+    rays.reserve(size_t(width) * height);
+    pixels.reserve(size_t(width) * height);
+    for (uint32_t ty = 0; ty < height; ty += tile_height) {
+        for (uint32_t tx = 0; tx < width; tx += tile_width) {
+            for (uint32_t y = ty; y < std::min(ty + tile_height, height); ++y) {
+                for (uint32_t x = tx; x < std::min(tx + tile_width, width); ++x) {
+                    rays.push_back(Generate(x, y));
+                    pixels.push_back(y * width + x);
+                }
+            }
+        }
+    }
+}
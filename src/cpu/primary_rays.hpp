@@ -0,0 +1,27 @@
+#pragma once
+#include "ray.hpp"
+#include "../camera.hpp"
+#include <vector>
+
+namespace w::cpu {
+// CPU copy of RayGeneration in shaders/raytracing.lib.hlsl, fed the same constant buffer the GPU gets
+class PrimaryRays
+{
+public:
+    PrimaryRays(const w::Camera::CBuffer& camera, uint32_t width, uint32_t height) noexcept;
+
+public:
+    Ray Generate(uint32_t x, uint32_t y) const noexcept;
+
+    // the whole image in tile_width x tile_height blocks, row major inside a block, so consecutive rays
+    // form coherent packets. pixels[i] is the y * width + x of rays[i]
+    void GenerateTiled(uint32_t tile_width, uint32_t tile_height, std::vector<Ray>& rays, std::vector<uint32_t>& pixels) const;
+
+public:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // rows as in the constant buffer, the wavefront generate kernels transform a SIMD width of pixels with them
+    float inv_view[4][4]{};
+    float inv_projection[4][4]{};
+};
+} // namespace w::cpu
@@ -0,0 +1,84 @@
+#pragma once
+#include "math.hpp"
+
+namespace w::cpu {
+// same defaults as the RayDesc in RayGeneration
+struct Ray {
+    float3 origin;
+    float t_min = 0.01f;
+    float3 dir;
+    float t_max = 1000.0f;
+};
+
+struct Hit {
+    float t = HUGE_VALF;
+    float u = 0, v = 0; // barycentrics of vertex 1 and 2, like BuiltInTriangleIntersectionAttributes
+    uint32_t primitive = ~0u; // triangle index in the TriangleMesh, ~0u for a miss
+
+    bool Missed() const noexcept
+    {
+        return primitive == ~0u;
+    }
+};
+
+// edge form, 36 bytes: what the intersection test consumes directly
+struct Triangle {
+    float3 v0;
+    float3 e1; // v1 - v0
+    float3 e2; // v2 - v0
+};
+
+// 1/d with zero components pushed off zero, keeps slab products free of 0 * inf.
+// Packet kernels must use the same value so their hits agree with the scalar path
+inline float SafeInverse(float d) noexcept
+{
+    constexpr float epsilon = 1e-20f;
+    return 1.0f / (std::fabs(d) < epsilon ? std::copysign(epsilon, d) : d);
+}
+inline float3 SafeInverse(float3 d) noexcept
+{
+    return { SafeInverse(d.x), SafeInverse(d.y), SafeInverse(d.z) };
+}
+
+// slab test, returns the entry distance or HUGE_VALF when the box is missed within [t_min, t_max]
+inline float IntersectAabb(float3 origin, float3 inv_dir, float t_min, float t_max, float3 lo, float3 hi) noexcept
+{
+    float3 t0 = (lo - origin) * inv_dir;
+    float3 t1 = (hi - origin) * inv_dir;
+    float t_near = std::max({ std::min(t0.x, t1.x), std::min(t0.y, t1.y), std::min(t0.z, t1.z), t_min });
+    float t_far = std::min({ std::max(t0.x, t1.x), std::max(t0.y, t1.y), std::max(t0.z, t1.z), t_max });
+    return t_near <= t_far ? t_near : HUGE_VALF;
+}
+
+// Moller-Trumbore, double sided like a DXR triangle without cull flags: whether the ray crosses the triangle within
+// (t_min, t_max), at t with barycentrics u, v
+inline bool CrossesTriangle(const Ray& ray, const Triangle& tri, float t_max, float& t, float& u, float& v) noexcept
+{
+    float3 p = Cross(ray.dir, tri.e2);
+    float inv_det = 1.0f / Dot(tri.e1, p);
+    float3 s = ray.origin - tri.v0;
+    u = Dot(s, p) * inv_det;
+    float3 q = Cross(s, tri.e1);
+    v = Dot(ray.dir, q) * inv_det;
+    t = Dot(tri.e2, q) * inv_det;
+    return u >= 0 && v >= 0 && u + v <= 1 && t > ray.t_min && t < t_max;
+}
+
+// updates hit when closer
+inline bool IntersectTriangle(const Ray& ray, const Triangle& tri, uint32_t primitive, Hit& hit) noexcept
+{
+    float t, u, v;
+    if (CrossesTriangle(ray, tri, std::min(hit.t, ray.t_max), t, u, v)) {
+        hit = { t, u, v, primitive };
+        return true;
+    }
+    return false;
+}
+
+// for occlusion: whether the triangle lies within (t_min, t_max), nothing is recorded
+inline bool OccludesTriangle(const Ray& ray, const Triangle& tri) noexcept
+{
+    float t, u, v;
+    return CrossesTriangle(ray, tri, ray.t_max, t, u, v);
+}
+} // namespace w::cpu
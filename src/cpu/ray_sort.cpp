@@ -0,0 +1,62 @@
+#include "ray_sort.hpp"
+#include "morton_sort.hpp"
+#include "../worker_pool.hpp"
+
+namespace {
+constexpr uint32_t min_chunk_size = 4096; // rays per parallel chunk, smaller batches sort on the calling thread
+constexpr uint32_t max_origin_bits = 9; // 27 bits of cell and 3 of octant fit the code half of a key
+} // namespace
+
+w::cpu::RaySorter::RaySorter(const RaySortSettings& settings)
+    : settings(settings)
+{
+    thread_count = settings.thread_count ? settings.thread_count : std::max(1u, std::thread::hardware_concurrency());
+    if (thread_count > 1) {
+        pool = std::make_unique<w::WorkerPool>(thread_count);
+    }
+}
+
+w::cpu::RaySorter::~RaySorter() = default;
+
+void w::cpu::RaySorter::Sort(std::span<const Ray> rays, std::vector<uint32_t>& order)
+{
+    uint32_t count = uint32_t(rays.size());
+    chunk_count = pool ? std::clamp(count / min_chunk_size, 1u, thread_count) : 1u;
+
+    std::vector<Aabb> chunk_bounds(chunk_count);
+    w::ParallelFor(pool.get(), count, chunk_count, [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+        Aabb bounds;
+        for (uint32_t i = begin; i < end; ++i) {
+            bounds.Grow(rays[i].origin);
+        }
+        chunk_bounds[chunk] = bounds;
+    });
+    Aabb origins;
+    for (const Aabb& bounds : chunk_bounds) {
+        origins.Grow(bounds);
+    }
+
+    // top origin_bits of every axis, then the octant: rays of a cell are grouped by direction before the next cell starts
+    float3 extent = origins.Extent();
+    float3 scale{ extent.x > 0 ? 1.0f / extent.x : 0.0f, extent.y > 0 ? 1.0f / extent.y : 0.0f, extent.z > 0 ? 1.0f / extent.z : 0.0f };
+    uint32_t origin_bits = std::clamp(settings.origin_bits, 1u, max_origin_bits);
+    uint32_t cell_shift = 3 * (10 - origin_bits);
+    keys.resize(count);
+    w::ParallelFor(pool.get(), count, chunk_count, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            const Ray& ray = rays[i];
+            uint32_t cell = MortonCode((ray.origin - origins.lo) * scale) >> cell_shift;
+            uint32_t octant = uint32_t(ray.dir.x < 0) << 2 | uint32_t(ray.dir.y < 0) << 1 | uint32_t(ray.dir.z < 0);
+            keys[i] = uint64_t(cell << 3 | octant) << 32 | i;
+        }
+    });
+
+    RadixSortKeys(keys, scratch, chunk_count, [this](uint32_t n, auto&& f) { w::ParallelFor(pool.get(), n, chunk_count, f); }, 3 * origin_bits + 3);
+
+    order.resize(count);
+    w::ParallelFor(pool.get(), count, chunk_count, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            order[i] = uint32_t(keys[i]);
+        }
+    });
+}
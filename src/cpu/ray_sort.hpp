@@ -0,0 +1,44 @@
+#pragma once
+#include "ray.hpp"
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace w {
+class WorkerPool;
+}
+
+namespace w::cpu {
+struct RaySortSettings {
+    // per axis, cells are 1 / 2^origin_bits of the origin bounds of the batch, at most 9. Coarse cells put far apart
+    // origins in one packet, below 5 tracing gets slower than unsorted
+    uint32_t origin_bits = 6;
+    uint32_t thread_count = 1; // 0 for hardware concurrency, batches of a few thousand rays stay on the calling thread
+};
+
+// Puts incoherent batches (bounce and shadow rays) in an order that keeps consecutive rays in the same origin cell
+// and direction octant, so packets of neighbours visit the same nodes. Keys are the Morton code of the cell followed by
+// the three direction sign bits, sorted with the parallel radix sort of the LBVH builder
+class RaySorter
+{
+public:
+    explicit RaySorter(const RaySortSettings& settings = {});
+    ~RaySorter();
+
+public:
+    // order gets rays.size() indices, rays[order[0]], rays[order[1]], ... is the sorted batch; equal keys keep their order
+    void Sort(std::span<const Ray> rays, std::vector<uint32_t>& order);
+
+    const RaySortSettings& Settings() const noexcept
+    {
+        return settings;
+    }
+
+private:
+    RaySortSettings settings;
+    uint32_t thread_count = 1;
+    uint32_t chunk_count = 1; // of the current batch
+    std::vector<uint64_t> keys, scratch; // key << 32 | ray index, kept between batches
+    std::unique_ptr<w::WorkerPool> pool;
+};
+} // namespace w::cpu
@@ -0,0 +1,45 @@
+#include "reference_renderer.hpp"
+#include <bit>
+
+void w::cpu::RenderTile(const Blas& blas, const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                        std::span<uint32_t> rgba8, const PacketTraceSettings& settings)
+{
+    // tile rows are cut into packet shaped blocks of 4 x (width / 4) pixels
+    uint32_t packet = PacketWidth(ClampSimdIsa(settings.isa));
+    uint32_t block_width = std::min(packet, 4u);
+    uint32_t block_height = packet / block_width;
+
+    Ray rays[16];
+    Hit hits[16];
+    uint32_t pixels[16];
+    for (uint32_t by = y; by < y + height; by += block_height) {
+        for (uint32_t bx = x; bx < x + width; bx += block_width) {
+            uint32_t count = 0;
+            for (uint32_t py = by; py < std::min(by + block_height, y + height); ++py) {
+                for (uint32_t px = bx; px < std::min(bx + block_width, x + width); ++px) {
+                    rays[count] = camera.Generate(px, py);
+                    pixels[count++] = py * camera.width + px;
+                }
+            }
+            blas.TracePackets({ rays, count }, { hits, count }, settings);
+            for (uint32_t i = 0; i < count; ++i) {
+                float3 color = hits[i].Missed() ? MissColor(rays[i].dir) : hit_color;
+                uint32_t packed = PackUnorm8(color);
+                rgba8[pixels[i]] = std::endian::native == std::endian::little ? packed : std::byteswap(packed);
+            }
+        }
+    }
+}
+
+void w::cpu::RenderFrame(const Blas& blas, const PrimaryRays& camera, std::span<uint32_t> rgba8, const PacketTraceSettings& settings)
+{
+    RenderTile(blas, camera, 0, 0, camera.width, camera.height, rgba8, settings);
+}
+
+void w::cpu::RenderFrame(const Blas& blas, const PrimaryRays& camera, std::span<uint32_t> rgba8, TileScheduler& scheduler,
+                         const PacketTraceSettings& settings)
+{
+    scheduler.Run(camera.width, camera.height, [&](const Tile& tile) {
+        RenderTile(blas, camera, tile.x, tile.y, tile.width, tile.height, rgba8, settings);
+    });
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "blas.hpp"
+#include "primary_rays.hpp"
+#include "tile_scheduler.hpp"
+#include <span>
+
+// CPU mirror of shaders/raytracing.lib.hlsl: RayGeneration through PrimaryRays, Miss and ClosestHit below.
+// Constants and operation order follow the shader, change both together
+namespace w::cpu {
+inline constexpr float3 light{ 0, 200, 0 };
+inline constexpr float3 sky_top{ 0.24f, 0.44f, 0.72f };
+inline constexpr float3 sky_bottom{ 0.75f, 0.86f, 0.93f };
+inline constexpr float3 hit_color{ 1, 1, 0 };
+
+// HLSL lerp: x + s * (y - x)
+inline float3 Lerp(float3 x, float3 y, float s) noexcept
+{
+    return x + (y - x) * s;
+}
+
+inline float3 MissColor(float3 world_dir) noexcept
+{
+    float slope = Normalize(world_dir).y;
+    float t = std::clamp(slope * 5 + 0.5f, 0.0f, 1.0f);
+    return Lerp(sky_bottom, sky_top, t);
+}
+
+// float4(color, 1) stored to the RGBA8Unorm UAV: saturate, scale, round to nearest even
+inline uint32_t PackUnorm8(float3 color) noexcept
+{
+    auto channel = [](float c) { return uint32_t(std::nearbyint(std::clamp(c, 0.0f, 1.0f) * 255.0f)); };
+    return channel(color.x) | channel(color.y) << 8 | channel(color.z) << 16 | 0xffu << 24;
+}
+
+// rgba8 holds width * height pixels, row major, RGBA bytes in memory order like the GPU image
+void RenderTile(const Blas& blas, const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                std::span<uint32_t> rgba8, const PacketTraceSettings& settings = {});
+void RenderFrame(const Blas& blas, const PrimaryRays& camera, std::span<uint32_t> rgba8, const PacketTraceSettings& settings = {});
+// tiles spread over the scheduler's workers
+void RenderFrame(const Blas& blas, const PrimaryRays& camera, std::span<uint32_t> rgba8, TileScheduler& scheduler,
+                 const PacketTraceSettings& settings = {});
+} // namespace w::cpu
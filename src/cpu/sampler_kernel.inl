@@ -0,0 +1,113 @@
+// Texture filtering, compiled once per instruction set: the including file defines W_SIMD_<ISA> and W_SIMD_NS.
+// Footprints and texel fetches are per lane, coordinates and blends run a SIMD width of lookups at once in the
+// operation order of the scalar TrilinearTap in texture_sampler.cpp
+#include "sampler_kernels.hpp"
+#include "simd.hpp"
+
+namespace w::cpu::W_SIMD_NS {
+namespace {
+struct alignas(64) SampleLanes {
+    float u[width], v[width];
+    float step_u[width], step_v[width];
+    float taps[width]; // 0 past the end of the batch
+    float level_weight[width];
+    uint32_t level[2][width];
+    float level_width[2][width], level_height[2][width];
+    float x0[width], y0[width]; // of the tap and level being fetched
+    float fx[2][width], fy[2][width];
+    uint32_t texels[2][4][width]; // t00, t10, t01, t11 of both levels
+    float rgba[4][width];
+};
+
+template<typename Lookup, typename Footprint>
+void Sample(const TiledTexture& texture, const SamplerSettings& settings, std::span<const Lookup> lookups, std::span<Rgba> out,
+            Footprint&& footprint) noexcept
+{
+    SampleLanes lanes;
+    uint32_t count = uint32_t(lookups.size());
+    for (uint32_t first = 0; first < count; first += width) {
+        uint32_t n = std::min(width, count - first);
+        uint32_t max_taps = 0;
+        for (uint32_t i = 0; i < width; ++i) {
+            FilterFootprint f = i < n ? footprint(texture, settings, lookups[first + i]) : FilterFootprint{ .taps = 0 };
+            lanes.u[i] = f.u;
+            lanes.v[i] = f.v;
+            lanes.step_u[i] = f.step_u;
+            lanes.step_v[i] = f.step_v;
+            lanes.taps[i] = float(f.taps);
+            lanes.level_weight[i] = f.level_weight;
+            lanes.level[0][i] = f.level0;
+            lanes.level[1][i] = f.level1;
+            for (uint32_t l = 0; l < 2; ++l) {
+                lanes.level_width[l][i] = float(texture.levels[lanes.level[l][i]].width);
+                lanes.level_height[l][i] = float(texture.levels[lanes.level[l][i]].height);
+            }
+            max_taps = std::max(max_taps, f.taps);
+        }
+
+        vfloat taps = Load(lanes.taps);
+        vfloat level_weight = Load(lanes.level_weight);
+        vfloat zero = Broadcast(0.0f);
+        vfloat sum[4] = { zero, zero, zero, zero };
+        for (uint32_t tap = 0; tap < max_taps; ++tap) {
+            vfloat tap_index = Broadcast(float(tap));
+            vmask active = tap_index < taps;
+            uint32_t active_bits = Bits(active);
+            vfloat u = Load(lanes.u) + Load(lanes.step_u) * tap_index;
+            vfloat v = Load(lanes.v) + Load(lanes.step_v) * tap_index;
+            vfloat fu = u - Floor(u), fv = v - Floor(v);
+            for (uint32_t l = 0; l < 2; ++l) {
+                vfloat x = fu * Load(lanes.level_width[l]) - Broadcast(0.5f);
+                vfloat y = fv * Load(lanes.level_height[l]) - Broadcast(0.5f);
+                vfloat x0 = Floor(x), y0 = Floor(y);
+                Store(lanes.x0, x0);
+                Store(lanes.y0, y0);
+                Store(lanes.fx[l], x - x0);
+                Store(lanes.fy[l], y - y0);
+                auto& t = lanes.texels[l];
+                for (uint32_t i = 0; i < width; ++i) {
+                    if (active_bits & (1u << i)) {
+                        BilinearTexels(texture, lanes.level[l][i], lanes.x0[i], lanes.y0[i], t[0][i], t[1][i], t[2][i], t[3][i]);
+                    } else {
+                        t[0][i] = t[1][i] = t[2][i] = t[3][i] = 0;
+                    }
+                }
+            }
+
+            for (uint32_t c = 0; c < 4; ++c) {
+                vfloat filtered[2];
+                for (uint32_t l = 0; l < 2; ++l) {
+                    auto& t = lanes.texels[l];
+                    vfloat t00 = UnpackByte(t[0], 8 * c), t10 = UnpackByte(t[1], 8 * c);
+                    vfloat t01 = UnpackByte(t[2], 8 * c), t11 = UnpackByte(t[3], 8 * c);
+                    vfloat fx = Load(lanes.fx[l]);
+                    vfloat top = t00 + (t10 - t00) * fx;
+                    vfloat bottom = t01 + (t11 - t01) * fx;
+                    filtered[l] = top + (bottom - top) * Load(lanes.fy[l]);
+                }
+                sum[c] = sum[c] + Select(active, filtered[0] + (filtered[1] - filtered[0]) * level_weight, zero);
+            }
+        }
+
+        vfloat scale = Broadcast(1.0f) / taps; // inf past the end, those lanes are not written
+        vfloat unorm = Broadcast(1.0f / 255.0f);
+        for (uint32_t c = 0; c < 4; ++c) {
+            Store(lanes.rgba[c], sum[c] * scale * unorm);
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            out[first + i] = { lanes.rgba[0][i], lanes.rgba[1][i], lanes.rgba[2][i], lanes.rgba[3][i] };
+        }
+    }
+}
+} // namespace
+
+void SampleLevel(const TiledTexture& texture, const SamplerSettings& settings, std::span<const LevelLookup> lookups, std::span<Rgba> out) noexcept
+{
+    Sample(texture, settings, lookups, out, LevelFootprint);
+}
+
+void SampleGrad(const TiledTexture& texture, const SamplerSettings& settings, std::span<const GradLookup> lookups, std::span<Rgba> out) noexcept
+{
+    Sample(texture, settings, lookups, out, GradFootprint);
+}
+} // namespace w::cpu::W_SIMD_NS
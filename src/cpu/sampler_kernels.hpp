@@ -0,0 +1,91 @@
+#pragma once
+#include "texture_sampler.hpp"
+
+// per lookup setup shared by the scalar sampler and the kernels built per instruction set from sampler_kernel.inl
+namespace w::cpu {
+// what a lookup filters: taps trilinear taps from (u, v) on, step apart, between level0 and level1
+struct FilterFootprint {
+    uint32_t level0 = 0, level1 = 0;
+    float level_weight = 0; // of level1
+    uint32_t taps = 1;
+    float u = 0, v = 0; // first tap
+    float step_u = 0, step_v = 0;
+};
+
+inline void SelectLevels(const TiledTexture& texture, const SamplerSettings& settings, float lod, FilterFootprint& footprint) noexcept
+{
+    float last = float(texture.LevelCount() - 1);
+    lod = std::min(std::max(lod + settings.mip_lod_bias, settings.min_lod), std::min(settings.max_lod, last));
+    lod = lod >= 0 ? lod : 0.0f; // also catches nan from a degenerate footprint
+    float level = std::floor(lod);
+    footprint.level0 = uint32_t(level);
+    footprint.level1 = std::min(footprint.level0 + 1, texture.LevelCount() - 1);
+    footprint.level_weight = lod - level;
+}
+
+inline FilterFootprint LevelFootprint(const TiledTexture& texture, const SamplerSettings& settings, const LevelLookup& lookup) noexcept
+{
+    FilterFootprint footprint{ .u = lookup.u, .v = lookup.v };
+    SelectLevels(texture, settings, lookup.lod, footprint);
+    return footprint;
+}
+
+// level 0 texel lengths of the x and y derivatives. Isotropic picks the level of the longer one like D3D, anisotropic
+// the level of the longer one split into taps, which leaves about one texel per tap across the short one
+inline FilterFootprint GradFootprint(const TiledTexture& texture, const SamplerSettings& settings, const GradLookup& lookup) noexcept
+{
+    float w = float(texture.Width()), h = float(texture.Height());
+    float x_du = lookup.du_dx * w, x_dv = lookup.dv_dx * h;
+    float y_du = lookup.du_dy * w, y_dv = lookup.dv_dy * h;
+    float length_x = std::sqrt(x_du * x_du + x_dv * x_dv);
+    float length_y = std::sqrt(y_du * y_du + y_dv * y_dv);
+    float major = std::max(length_x, length_y);
+
+    FilterFootprint footprint{ .u = lookup.u, .v = lookup.v };
+    if (settings.max_anisotropy > 1) {
+        float minor = std::min(length_x, length_y);
+        float ratio = minor > 0 ? std::ceil(major / minor) : major > 0 ? float(settings.max_anisotropy) : 1.0f;
+        footprint.taps = uint32_t(std::clamp(ratio, 1.0f, float(settings.max_anisotropy)));
+        float taps = float(footprint.taps);
+        bool along_x = length_x >= length_y;
+        footprint.step_u = (along_x ? lookup.du_dx : lookup.du_dy) / taps;
+        footprint.step_v = (along_x ? lookup.dv_dx : lookup.dv_dy) / taps;
+        footprint.u = lookup.u + footprint.step_u * (0.5f - 0.5f * taps); // taps centered on (u, v)
+        footprint.v = lookup.v + footprint.step_v * (0.5f - 0.5f * taps);
+        major = major / taps;
+    }
+    SelectLevels(texture, settings, std::log2(major), footprint);
+    return footprint;
+}
+
+// the 2x2 texels a bilinear tap at level coordinates (x0 + fx, y0 + fy) blends, x0 in [-1, width - 1] wraps like Repeat.
+// nan from non-finite coordinates lands on the last texel instead of out of bounds
+inline void BilinearTexels(const TiledTexture& texture, uint32_t level, float x0, float y0, uint32_t& t00, uint32_t& t10, uint32_t& t01,
+                           uint32_t& t11) noexcept
+{
+    const TiledTexture::Level& l = texture.levels[level];
+    uint32_t ix0 = x0 >= 0 ? uint32_t(x0) : l.width - 1;
+    uint32_t iy0 = y0 >= 0 ? uint32_t(y0) : l.height - 1;
+    uint32_t ix1 = ix0 + 1 == l.width ? 0 : ix0 + 1;
+    uint32_t iy1 = iy0 + 1 == l.height ? 0 : iy0 + 1;
+    const uint32_t* texels = texture.texels.data();
+    t00 = texels[TiledTexture::TexelIndex(l, ix0, iy0)];
+    t10 = texels[TiledTexture::TexelIndex(l, ix1, iy0)];
+    t01 = texels[TiledTexture::TexelIndex(l, ix0, iy1)];
+    t11 = texels[TiledTexture::TexelIndex(l, ix1, iy1)];
+}
+
+// Filters lookups into out, a SIMD width at a time
+namespace sse {
+void SampleLevel(const TiledTexture& texture, const SamplerSettings& settings, std::span<const LevelLookup> lookups, std::span<Rgba> out) noexcept;
+void SampleGrad(const TiledTexture& texture, const SamplerSettings& settings, std::span<const GradLookup> lookups, std::span<Rgba> out) noexcept;
+}
+namespace avx2 {
+void SampleLevel(const TiledTexture& texture, const SamplerSettings& settings, std::span<const LevelLookup> lookups, std::span<Rgba> out) noexcept;
+void SampleGrad(const TiledTexture& texture, const SamplerSettings& settings, std::span<const GradLookup> lookups, std::span<Rgba> out) noexcept;
+}
+namespace avx512 {
+void SampleLevel(const TiledTexture& texture, const SamplerSettings& settings, std::span<const LevelLookup> lookups, std::span<Rgba> out) noexcept;
+void SampleGrad(const TiledTexture& texture, const SamplerSettings& settings, std::span<const GradLookup> lookups, std::span<Rgba> out) noexcept;
+}
+} // namespace w::cpu
@@ -0,0 +1,417 @@
+#include "bvh.hpp"
+#include "triangle_mesh.hpp"
+#include <chrono>
+
+namespace {
+using namespace w::cpu;
+
+constexpr uint32_t max_bins = 64;
+constexpr uint32_t max_spatial_depth = traversal_stack_size / 2; // deeper nodes only get object splits, the root is 1
+
+// a triangle, or the part of it that lies inside every spatial split above
+struct Reference {
+    Aabb bounds;
+    uint32_t primitive;
+};
+
+struct ObjectBin {
+    Aabb bounds;
+    uint32_t count = 0;
+};
+
+struct SpatialBin {
+    Aabb bounds;
+    uint32_t entries = 0; // references starting in this bin
+    uint32_t exits = 0; // references ending in this bin
+};
+
+struct ObjectSplit {
+    uint32_t axis = 0;
+    uint32_t bin = 0; // first bin on the right side
+    float cost = HUGE_VALF;
+    Aabb left, right;
+};
+
+struct SpatialSplit {
+    uint32_t axis = 0;
+    uint32_t bin = 0; // first bin on the right side
+    float cost = HUGE_VALF;
+};
+
+Aabb Intersect(const Aabb& a, const Aabb& b) noexcept
+{
+    return { Max(a.lo, b.lo), Min(a.hi, b.hi) };
+}
+
+bool IsEmpty(const Aabb& box) noexcept // Aabb::Empty only looks at x, intersections can be empty on any axis
+{
+    return box.lo.x > box.hi.x || box.lo.y > box.hi.y || box.lo.z > box.hi.z;
+}
+
+float Area(const Aabb& box) noexcept
+{
+    return IsEmpty(box) ? 0.0f : box.HalfArea();
+}
+
+class SbvhBuilder
+{
+public:
+    SbvhBuilder(const TriangleMesh& mesh, const BvhBuildSettings& settings, Bvh& bvh)
+        : mesh(mesh), settings(settings), bvh(bvh)
+    {
+        bin_count = std::clamp(settings.bin_count, 2u, max_bins);
+        max_depth = std::clamp(settings.max_depth, min_bvh_depth, traversal_stack_size);
+        reference_count = mesh.TriangleCount();
+        reference_limit = uint32_t(float(reference_count) * (1.0f + std::max(0.0f, settings.reference_budget)));
+    }
+
+public:
+    void Build()
+    {
+        std::vector<Reference> references(mesh.TriangleCount());
+        Aabb root;
+        for (uint32_t t = 0; t < references.size(); ++t) {
+            references[t] = { mesh.TriangleBounds(t), t };
+            root.Grow(references[t].bounds);
+        }
+        if (references.empty()) {
+            return;
+        }
+        root_area = std::max(root.HalfArea(), std::numeric_limits<float>::min());
+        bvh.nodes.emplace_back();
+        BuildNode(0, references, 1);
+    }
+
+private:
+    uint32_t BinIndex(float x, float lo, float scale) const noexcept
+    {
+        return std::min(bin_count - 1, uint32_t(std::max(0.0f, (x - lo) * scale)));
+    }
+
+    // bounds of the triangle between two planes on axis
+    Aabb ClipTriangle(uint32_t primitive, uint32_t axis, float lo, float hi) const noexcept
+    {
+        float3 v[3]{ mesh.positions[mesh.indices[primitive * 3 + 0]], mesh.positions[mesh.indices[primitive * 3 + 1]],
+                     mesh.positions[mesh.indices[primitive * 3 + 2]] };
+        Aabb box;
+        for (uint32_t i = 0; i < 3; ++i) {
+            float3 a = v[i], b = v[(i + 1) % 3];
+            if (a[axis] >= lo && a[axis] <= hi) {
+                box.Grow(a);
+            }
+            for (float plane : { lo, hi }) {
+                if ((a[axis] < plane && b[axis] > plane) || (a[axis] > plane && b[axis] < plane)) {
+                    float3 p = a + (b - a) * ((plane - a[axis]) / (b[axis] - a[axis]));
+                    p[axis] = plane;
+                    box.Grow(p);
+                }
+            }
+        }
+        return box;
+    }
+
+    Aabb ClipReference(const Reference& reference, uint32_t axis, float lo, float hi) const noexcept
+    {
+        lo = std::max(lo, reference.bounds.lo[axis]);
+        hi = std::min(hi, reference.bounds.hi[axis]);
+        if (lo > hi) {
+            return {};
+        }
+        return Intersect(ClipTriangle(reference.primitive, axis, lo, hi), reference.bounds);
+    }
+
+    ObjectSplit FindObjectSplit(std::span<const Reference> references, const Aabb& bounds, const Aabb& centroids) const noexcept
+    {
+        ObjectSplit best;
+        float parent_area = bounds.HalfArea();
+        float3 extent = centroids.Extent();
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            if (extent[axis] <= 0) {
+                continue;
+            }
+            ObjectBin bins[max_bins]{};
+            float scale = float(bin_count) / extent[axis];
+            for (const Reference& reference : references) {
+                ObjectBin& bin = bins[BinIndex(reference.bounds.Center()[axis], centroids.lo[axis], scale)];
+                bin.bounds.Grow(reference.bounds);
+                bin.count++;
+            }
+
+            Aabb right_bounds[max_bins];
+            float right_cost[max_bins]{};
+            Aabb right;
+            uint32_t right_count = 0;
+            for (uint32_t b = bin_count - 1; b > 0; --b) {
+                right.Grow(bins[b].bounds);
+                right_count += bins[b].count;
+                right_bounds[b] = right;
+                right_cost[b] = right.HalfArea() * float(right_count);
+            }
+            Aabb left;
+            uint32_t left_count = 0;
+            for (uint32_t b = 1; b < bin_count; ++b) {
+                left.Grow(bins[b - 1].bounds);
+                left_count += bins[b - 1].count;
+                if (left_count == 0 || left_count == references.size()) {
+                    continue;
+                }
+                float cost = settings.traversal_cost + (left.HalfArea() * float(left_count) + right_cost[b]) / parent_area;
+                if (cost < best.cost) {
+                    best = { axis, b, cost, left, right_bounds[b] };
+                }
+            }
+        }
+        return best;
+    }
+
+    SpatialSplit FindSpatialSplit(std::span<const Reference> references, const Aabb& bounds) const noexcept
+    {
+        SpatialSplit best;
+        float parent_area = bounds.HalfArea();
+        float3 extent = bounds.Extent();
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            if (extent[axis] <= 0) {
+                continue;
+            }
+            SpatialBin bins[max_bins]{};
+            float lo = bounds.lo[axis];
+            float scale = float(bin_count) / extent[axis];
+            float bin_size = extent[axis] / float(bin_count);
+            for (const Reference& reference : references) {
+                uint32_t first = BinIndex(reference.bounds.lo[axis], lo, scale);
+                uint32_t last = BinIndex(reference.bounds.hi[axis], lo, scale);
+                if (first == last) {
+                    bins[first].bounds.Grow(reference.bounds);
+                } else {
+                    for (uint32_t b = first; b <= last; ++b) {
+                        Aabb part = ClipReference(reference, axis, lo + bin_size * float(b), lo + bin_size * float(b + 1));
+                        if (!IsEmpty(part)) {
+                            bins[b].bounds.Grow(part);
+                        }
+                    }
+                }
+                bins[first].entries++;
+                bins[last].exits++;
+            }
+
+            float right_cost[max_bins]{};
+            Aabb right;
+            uint32_t right_count = 0;
+            for (uint32_t b = bin_count - 1; b > 0; --b) {
+                right.Grow(bins[b].bounds);
+                right_count += bins[b].exits;
+                right_cost[b] = right_count ? Area(right) * float(right_count) : -1.0f;
+            }
+            Aabb left;
+            uint32_t left_count = 0;
+            for (uint32_t b = 1; b < bin_count; ++b) {
+                left.Grow(bins[b - 1].bounds);
+                left_count += bins[b - 1].entries;
+                if (left_count == 0 || right_cost[b] < 0) {
+                    continue;
+                }
+                float cost = settings.traversal_cost + (Area(left) * float(left_count) + right_cost[b]) / parent_area;
+                if (cost < best.cost) {
+                    best = { axis, b, cost };
+                }
+            }
+        }
+        return best;
+    }
+
+    // distributes references over the plane, straddlers are clipped into both sides unless keeping them whole on one
+    // side is cheaper (unsplitting). False when the split would break the reference budget or leave a side empty
+    bool PerformSpatialSplit(std::vector<Reference>& references, const Aabb& bounds, const SpatialSplit& split,
+                             std::vector<Reference>& left, std::vector<Reference>& right)
+    {
+        uint32_t axis = split.axis;
+        float lo = bounds.lo[axis];
+        float scale = float(bin_count) / bounds.Extent()[axis];
+        float plane = lo + bounds.Extent()[axis] * float(split.bin) / float(bin_count);
+
+        struct Straddler {
+            Reference reference;
+            Aabb left, right;
+        };
+        std::vector<Straddler> straddlers;
+        Aabb left_bounds, right_bounds;
+        for (const Reference& reference : references) {
+            if (BinIndex(reference.bounds.hi[axis], lo, scale) < split.bin) {
+                left.push_back(reference);
+                left_bounds.Grow(reference.bounds);
+            } else if (BinIndex(reference.bounds.lo[axis], lo, scale) >= split.bin) {
+                right.push_back(reference);
+                right_bounds.Grow(reference.bounds);
+            } else {
+                Straddler straddler{ reference, ClipReference(reference, axis, -HUGE_VALF, plane), ClipReference(reference, axis, plane, HUGE_VALF) };
+                if (IsEmpty(straddler.left)) {
+                    right.push_back(reference);
+                    right_bounds.Grow(reference.bounds);
+                } else if (IsEmpty(straddler.right)) {
+                    left.push_back(reference);
+                    left_bounds.Grow(reference.bounds);
+                } else {
+                    left_bounds.Grow(straddler.left);
+                    right_bounds.Grow(straddler.right);
+                    straddlers.push_back(straddler);
+                }
+            }
+        }
+
+        float left_count = float(left.size() + straddlers.size());
+        float right_count = float(right.size() + straddlers.size());
+        uint32_t duplicates = 0;
+        for (const Straddler& straddler : straddlers) {
+            Aabb whole_left = left_bounds, whole_right = right_bounds;
+            whole_left.Grow(straddler.reference.bounds);
+            whole_right.Grow(straddler.reference.bounds);
+            float split_cost = Area(left_bounds) * left_count + Area(right_bounds) * right_count;
+            float left_cost = Area(whole_left) * left_count + Area(right_bounds) * (right_count - 1);
+            float right_cost = Area(left_bounds) * (left_count - 1) + Area(whole_right) * right_count;
+            if (left_cost < split_cost && left_cost <= right_cost) {
+                left.push_back(straddler.reference);
+                left_bounds = whole_left;
+                right_count--;
+            } else if (right_cost < split_cost) {
+                right.push_back(straddler.reference);
+                right_bounds = whole_right;
+                left_count--;
+            } else {
+                left.push_back({ straddler.left, straddler.reference.primitive });
+                right.push_back({ straddler.right, straddler.reference.primitive });
+                duplicates++;
+            }
+        }
+
+        if (left.empty() || right.empty() || reference_count + duplicates > reference_limit) {
+            left.clear();
+            right.clear();
+            return false;
+        }
+        reference_count += duplicates;
+        return true;
+    }
+
+    // the best object or spatial split into left and right, false when the node should stay a leaf
+    bool SahSplit(std::vector<Reference>& references, const Aabb& bounds, const Aabb& centroids, uint32_t depth,
+                  std::vector<Reference>& left, std::vector<Reference>& right)
+    {
+        uint32_t count = uint32_t(references.size());
+        ObjectSplit object = FindObjectSplit(references, bounds, centroids);
+        SpatialSplit spatial;
+        // a spatial split can leave every reference in both children, so it needs room for halving all of them below
+        bool spatial_fits = depth + 1 + MedianSplitLevels(count, settings.max_leaf_size) <= max_depth;
+        if (spatial_fits && depth <= max_spatial_depth && reference_count < reference_limit) {
+            // spatial splits only pay off where the best object split leaves overlapping children
+            float overlap = object.cost < HUGE_VALF ? Area(Intersect(object.left, object.right)) : HUGE_VALF;
+            if (overlap / root_area > settings.spatial_split_alpha) {
+                spatial = FindSpatialSplit(references, bounds);
+            }
+        }
+        float cost = std::min(object.cost, spatial.cost);
+        if (!(cost < float(count)) && count <= settings.max_leaf_size) {
+            return false;
+        }
+
+        if (spatial.cost >= object.cost || !PerformSpatialSplit(references, bounds, spatial, left, right)) {
+            // the spatial split may have been what made splitting worth it
+            if (!(object.cost < float(count)) && count <= settings.max_leaf_size) {
+                return false;
+            }
+            if (object.cost < HUGE_VALF) {
+                float scale = float(bin_count) / centroids.Extent()[object.axis];
+                for (const Reference& reference : references) {
+                    bool goes_left = BinIndex(reference.bounds.Center()[object.axis], centroids.lo[object.axis], scale) < object.bin;
+                    (goes_left ? left : right).push_back(reference);
+                }
+            } else {
+                // centroids coincide, any split is as good as another
+                left.assign(references.begin(), references.begin() + count / 2);
+                right.assign(references.begin() + count / 2, references.end());
+            }
+        }
+        return true;
+    }
+
+    // halves at the centroid median along the widest axis, false when the node fits in a leaf
+    bool MedianSplit(std::vector<Reference>& references, const Aabb& centroids, std::vector<Reference>& left, std::vector<Reference>& right) const
+    {
+        uint32_t count = uint32_t(references.size());
+        if (count <= settings.max_leaf_size) {
+            return false;
+        }
+        uint32_t axis = centroids.LargestAxis();
+        auto middle = references.begin() + count / 2;
+        std::nth_element(references.begin(), middle, references.end(),
+                         [axis](const Reference& a, const Reference& b) { return a.bounds.Center()[axis] < b.bounds.Center()[axis]; });
+        left.assign(references.begin(), middle);
+        right.assign(middle, references.end());
+        return true;
+    }
+
+    void BuildNode(uint32_t node_index, std::vector<Reference>& references, uint32_t depth)
+    {
+        Aabb bounds, centroids;
+        for (const Reference& reference : references) {
+            bounds.Grow(reference.bounds);
+            centroids.Grow(reference.bounds.Center());
+        }
+        bvh.nodes[node_index].lo = bounds.lo;
+        bvh.nodes[node_index].hi = bounds.hi;
+        uint32_t count = uint32_t(references.size());
+        if (count == 1) {
+            MakeLeaf(node_index, references);
+            return;
+        }
+
+        // like the SAH builder: where even a split peeling off one reference could leave too few levels for halving
+        // the rest, nodes are split at the median instead, and at max_depth they fit in a leaf
+        std::vector<Reference> left, right;
+        bool split = depth + 1 + MedianSplitLevels(count - 1, settings.max_leaf_size) > max_depth
+                ? MedianSplit(references, centroids, left, right)
+                : SahSplit(references, bounds, centroids, depth, left, right);
+        if (!split) {
+            MakeLeaf(node_index, references);
+            return;
+        }
+        std::vector<Reference>().swap(references); // children own their references from here
+
+        uint32_t child = uint32_t(bvh.nodes.size());
+        bvh.nodes.resize(child + 2);
+        bvh.nodes[node_index].left_first = child;
+        bvh.nodes[node_index].count = 0;
+        BuildNode(child, left, depth + 1);
+        BuildNode(child + 1, right, depth + 1);
+    }
+
+    void MakeLeaf(uint32_t node_index, const std::vector<Reference>& references)
+    {
+        BvhNode& node = bvh.nodes[node_index];
+        node.left_first = uint32_t(bvh.references.size());
+        node.count = uint32_t(references.size());
+        for (const Reference& reference : references) {
+            bvh.references.push_back(reference.primitive);
+        }
+    }
+
+private:
+    const TriangleMesh& mesh;
+    const BvhBuildSettings& settings;
+    Bvh& bvh;
+    uint32_t bin_count = 16;
+    uint32_t max_depth = traversal_stack_size;
+    uint32_t reference_count = 0; // triangles plus the copies spatial splits made so far
+    uint32_t reference_limit = 0;
+    float root_area = 1;
+};
+} // namespace
+
+w::cpu::Bvh w::cpu::BuildSbvh(const w::cpu::TriangleMesh& mesh, const BvhBuildSettings& settings)
+{
+    auto start = std::chrono::steady_clock::now();
+    Bvh bvh;
+    SbvhBuilder{ mesh, settings, bvh }.Build();
+    ReorderBvh(bvh, settings.layout, settings.treelet_size);
+    bvh.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return bvh;
+}
@@ -0,0 +1,340 @@
+#pragma once
+// Thin SIMD wrappers for the packet kernels. Each packet_<isa>.cpp defines one of
+// W_SIMD_SSE / W_SIMD_AVX2 / W_SIMD_AVX512 and is compiled with matching flags, everything
+// here lands in a namespace per instruction set so the translation units never share a symbol.
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+
+#if defined(W_SIMD_AVX512)
+namespace w::cpu::avx512 {
+constexpr uint32_t width = 16;
+
+struct vfloat {
+    __m512 v;
+};
+struct vmask {
+    __mmask16 m;
+};
+
+inline vfloat Broadcast(float f) noexcept
+{
+    return { _mm512_set1_ps(f) };
+}
+inline vfloat BroadcastBits(uint32_t bits) noexcept
+{
+    return { _mm512_castsi512_ps(_mm512_set1_epi32(int(bits))) };
+}
+inline vfloat Load(const float* p) noexcept
+{
+    return { _mm512_load_ps(p) };
+}
+inline void Store(float* p, vfloat a) noexcept
+{
+    _mm512_store_ps(p, a.v);
+}
+inline vfloat operator+(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_add_ps(a.v, b.v) };
+}
+inline vfloat operator-(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_sub_ps(a.v, b.v) };
+}
+inline vfloat operator*(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_mul_ps(a.v, b.v) };
+}
+inline vfloat operator/(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_div_ps(a.v, b.v) };
+}
+inline vfloat Min(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_min_ps(a.v, b.v) };
+}
+inline vfloat Max(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_max_ps(a.v, b.v) };
+}
+inline vfloat Sqrt(vfloat a) noexcept
+{
+    return { _mm512_sqrt_ps(a.v) };
+}
+inline vfloat Floor(vfloat a) noexcept
+{
+    return { _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC) };
+}
+inline vfloat UnpackByte(const uint32_t* p, uint32_t shift) noexcept // (p[i] >> shift) & 0xff as float, p aligned
+{
+    __m512i bytes = _mm512_and_si512(_mm512_srli_epi32(_mm512_load_si512(p), shift), _mm512_set1_epi32(0xff));
+    return { _mm512_cvtepi32_ps(bytes) };
+}
+inline vmask operator<(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) };
+}
+inline vmask operator<=(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) };
+}
+inline vmask operator>(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) };
+}
+inline vmask operator>=(vfloat a, vfloat b) noexcept
+{
+    return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ) };
+}
+inline vmask operator&(vmask a, vmask b) noexcept
+{
+    return { __mmask16(a.m & b.m) };
+}
+inline vmask operator|(vmask a, vmask b) noexcept
+{
+    return { __mmask16(a.m | b.m) };
+}
+inline uint32_t Bits(vmask a) noexcept
+{
+    return a.m;
+}
+inline vfloat Select(vmask mask, vfloat a, vfloat b) noexcept // a where mask is set
+{
+    return { _mm512_mask_blend_ps(mask.m, b.v, a.v) };
+}
+inline float ReduceMin(vfloat a) noexcept
+{
+    return _mm512_reduce_min_ps(a.v);
+}
+inline float ReduceMax(vfloat a) noexcept
+{
+    return _mm512_reduce_max_ps(a.v);
+}
+} // namespace w::cpu::avx512
+
+#elif defined(W_SIMD_AVX2)
+namespace w::cpu::avx2 {
+constexpr uint32_t width = 8;
+
+struct vfloat {
+    __m256 v;
+};
+struct vmask {
+    __m256 m;
+};
+
+inline vfloat Broadcast(float f) noexcept
+{
+    return { _mm256_set1_ps(f) };
+}
+inline vfloat BroadcastBits(uint32_t bits) noexcept
+{
+    return { _mm256_castsi256_ps(_mm256_set1_epi32(int(bits))) };
+}
+inline vfloat Load(const float* p) noexcept
+{
+    return { _mm256_load_ps(p) };
+}
+inline void Store(float* p, vfloat a) noexcept
+{
+    _mm256_store_ps(p, a.v);
+}
+inline vfloat operator+(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_add_ps(a.v, b.v) };
+}
+inline vfloat operator-(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_sub_ps(a.v, b.v) };
+}
+inline vfloat operator*(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_mul_ps(a.v, b.v) };
+}
+inline vfloat operator/(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_div_ps(a.v, b.v) };
+}
+inline vfloat Min(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_min_ps(a.v, b.v) };
+}
+inline vfloat Max(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_max_ps(a.v, b.v) };
+}
+inline vfloat Sqrt(vfloat a) noexcept
+{
+    return { _mm256_sqrt_ps(a.v) };
+}
+inline vfloat Floor(vfloat a) noexcept
+{
+    return { _mm256_floor_ps(a.v) };
+}
+inline vfloat UnpackByte(const uint32_t* p, uint32_t shift) noexcept
+{
+    __m256i bytes = _mm256_and_si256(_mm256_srli_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(p)), int(shift)), _mm256_set1_epi32(0xff));
+    return { _mm256_cvtepi32_ps(bytes) };
+}
+inline vmask operator<(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) };
+}
+inline vmask operator<=(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) };
+}
+inline vmask operator>(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) };
+}
+inline vmask operator>=(vfloat a, vfloat b) noexcept
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) };
+}
+inline vmask operator&(vmask a, vmask b) noexcept
+{
+    return { _mm256_and_ps(a.m, b.m) };
+}
+inline vmask operator|(vmask a, vmask b) noexcept
+{
+    return { _mm256_or_ps(a.m, b.m) };
+}
+inline uint32_t Bits(vmask a) noexcept
+{
+    return uint32_t(_mm256_movemask_ps(a.m));
+}
+inline vfloat Select(vmask mask, vfloat a, vfloat b) noexcept
+{
+    return { _mm256_blendv_ps(b.v, a.v, mask.m) };
+}
+inline float ReduceMin(vfloat a) noexcept
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_min_ss(m, _mm_movehdup_ps(m)));
+}
+inline float ReduceMax(vfloat a) noexcept
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_movehdup_ps(m)));
+}
+} // namespace w::cpu::avx2
+
+#elif defined(W_SIMD_SSE)
+// two 4 wide halves, so SSE packets have the same 8 rays as AVX2 ones
+namespace w::cpu::sse {
+constexpr uint32_t width = 8;
+
+struct vfloat {
+    __m128 lo, hi;
+};
+struct vmask {
+    __m128 lo, hi;
+};
+
+inline vfloat Broadcast(float f) noexcept
+{
+    __m128 v = _mm_set1_ps(f);
+    return { v, v };
+}
+inline vfloat BroadcastBits(uint32_t bits) noexcept
+{
+    __m128 v = _mm_castsi128_ps(_mm_set1_epi32(int(bits)));
+    return { v, v };
+}
+inline vfloat Load(const float* p) noexcept
+{
+    return { _mm_load_ps(p), _mm_load_ps(p + 4) };
+}
+inline void Store(float* p, vfloat a) noexcept
+{
+    _mm_store_ps(p, a.lo);
+    _mm_store_ps(p + 4, a.hi);
+}
+inline vfloat operator+(vfloat a, vfloat b) noexcept
+{
+    return { _mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi) };
+}
+inline vfloat operator-(vfloat a, vfloat b) noexcept
+{
+    return { _mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi) };
+}
+inline vfloat operator*(vfloat a, vfloat b) noexcept
+{
+    return { _mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi) };
+}
+inline vfloat operator/(vfloat a, vfloat b) noexcept
+{
+    return { _mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi) };
+}
+inline vfloat Min(vfloat a, vfloat b) noexcept
+{
+    return { _mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi) };
+}
+inline vfloat Max(vfloat a, vfloat b) noexcept
+{
+    return { _mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi) };
+}
+inline vfloat Sqrt(vfloat a) noexcept
+{
+    return { _mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi) };
+}
+inline vfloat Floor(vfloat a) noexcept
+{
+    return { _mm_floor_ps(a.lo), _mm_floor_ps(a.hi) };
+}
+inline vfloat UnpackByte(const uint32_t* p, uint32_t shift) noexcept
+{
+    __m128i mask = _mm_set1_epi32(0xff);
+    __m128i lo = _mm_and_si128(_mm_srli_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(p)), int(shift)), mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(p + 4)), int(shift)), mask);
+    return { _mm_cvtepi32_ps(lo), _mm_cvtepi32_ps(hi) };
+}
+inline vmask operator<(vfloat a, vfloat b) noexcept
+{
+    return { _mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi) };
+}
+inline vmask operator<=(vfloat a, vfloat b) noexcept
+{
+    return { _mm_cmple_ps(a.lo, b.lo), _mm_cmple_ps(a.hi, b.hi) };
+}
+inline vmask operator>(vfloat a, vfloat b) noexcept
+{
+    return { _mm_cmpgt_ps(a.lo, b.lo), _mm_cmpgt_ps(a.hi, b.hi) };
+}
+inline vmask operator>=(vfloat a, vfloat b) noexcept
+{
+    return { _mm_cmpge_ps(a.lo, b.lo), _mm_cmpge_ps(a.hi, b.hi) };
+}
+inline vmask operator&(vmask a, vmask b) noexcept
+{
+    return { _mm_and_ps(a.lo, b.lo), _mm_and_ps(a.hi, b.hi) };
+}
+inline vmask operator|(vmask a, vmask b) noexcept
+{
+    return { _mm_or_ps(a.lo, b.lo), _mm_or_ps(a.hi, b.hi) };
+}
+inline uint32_t Bits(vmask a) noexcept
+{
+    return uint32_t(_mm_movemask_ps(a.lo) | (_mm_movemask_ps(a.hi) << 4));
+}
+inline vfloat Select(vmask mask, vfloat a, vfloat b) noexcept
+{
+    return { _mm_blendv_ps(b.lo, a.lo, mask.lo), _mm_blendv_ps(b.hi, a.hi, mask.hi) };
+}
+inline float ReduceMin(vfloat a) noexcept
+{
+    __m128 m = _mm_min_ps(a.lo, a.hi);
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+inline float ReduceMax(vfloat a) noexcept
+{
+    __m128 m = _mm_max_ps(a.lo, a.hi);
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+} // namespace w::cpu::sse
+#endif
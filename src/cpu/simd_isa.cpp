@@ -0,0 +1,61 @@
+#include "simd_isa.hpp"
+
+#if W_CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+#ifdef _MSC_VER
+bool HasCpuFeature(int leaf, int reg, int bit) noexcept
+{
+    int info[4]{};
+    __cpuidex(info, leaf, 0);
+    return (info[reg] >> bit) & 1;
+}
+
+w::cpu::SimdIsa Detect() noexcept
+{
+    using enum w::cpu::SimdIsa;
+    if (!HasCpuFeature(1, 2, 19)) { // SSE4.1
+        return Scalar;
+    }
+    if (!HasCpuFeature(1, 2, 27)) { // OSXSAVE, without it the OS does not save ymm/zmm state
+        return SSE;
+    }
+    uint64_t xcr0 = _xgetbv(0);
+    bool avx_state = (xcr0 & 0x6) == 0x6;
+    bool avx512_state = (xcr0 & 0xe6) == 0xe6;
+    if (!avx_state || !HasCpuFeature(7, 1, 5) || !HasCpuFeature(1, 2, 12)) { // AVX2, FMA
+        return SSE;
+    }
+    return avx512_state && HasCpuFeature(7, 1, 16) ? AVX512 : AVX2; // AVX-512F
+}
+#else
+w::cpu::SimdIsa Detect() noexcept
+{
+    using enum w::cpu::SimdIsa;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return AVX2;
+    }
+    return __builtin_cpu_supports("sse4.1") ? SSE : Scalar;
+}
+#endif
+} // namespace
+
+w::cpu::SimdIsa w::cpu::DetectSimdIsa() noexcept
+{
+    static const SimdIsa isa = Detect();
+    return isa;
+}
+#else
+w::cpu::SimdIsa w::cpu::DetectSimdIsa() noexcept
+{
+    return SimdIsa::Scalar; // packet kernels are x86 only
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+
+namespace w::cpu {
+// instruction sets the packet kernels are compiled for, ordered by width
+enum class SimdIsa : uint32_t {
+    Scalar, // no packet kernel, rays are traced one by one
+    SSE, // SSE4.1, 8 lanes as two 4 wide halves
+    AVX2, // AVX2 + FMA, 8 lanes
+    AVX512, // AVX-512F, 16 lanes
+};
+
+// best instruction set both this build and the running CPU support
+SimdIsa DetectSimdIsa() noexcept;
+
+// requested, lowered to what DetectSimdIsa allows
+inline SimdIsa ClampSimdIsa(SimdIsa requested) noexcept
+{
+    return std::min(requested, DetectSimdIsa());
+}
+
+constexpr uint32_t PacketWidth(SimdIsa isa) noexcept
+{
+    return isa == SimdIsa::AVX512 ? 16 : isa == SimdIsa::Scalar ? 1 : 8;
+}
+
+constexpr std::string_view SimdIsaName(SimdIsa isa) noexcept
+{
+    switch (isa) {
+    case SimdIsa::SSE:
+        return "SSE4.1";
+    case SimdIsa::AVX2:
+        return "AVX2";
+    case SimdIsa::AVX512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+} // namespace w::cpu
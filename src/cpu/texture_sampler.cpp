@@ -0,0 +1,191 @@
+#include "texture_sampler.hpp"
+#include "sampler_kernels.hpp"
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+using namespace w::cpu;
+
+constexpr uint32_t texels_per_line = cache_line_size / sizeof(uint32_t);
+
+// levels as rows of texels, largest first, into the swizzled layout
+TiledTexture Swizzle(std::span<const std::vector<uint32_t>> rows, std::span<const std::pair<uint32_t, uint32_t>> sizes)
+{
+    TiledTexture texture;
+    uint32_t offset = 0;
+    for (auto [width, height] : sizes) {
+        uint32_t padded_width = std::bit_ceil(width), padded_height = std::bit_ceil(height);
+        texture.levels.push_back({ .width = width,
+                                   .height = height,
+                                   .offset = offset,
+                                   .square_bits = uint32_t(std::countr_zero(std::min(padded_width, padded_height))) });
+        offset += (padded_width * padded_height + texels_per_line - 1) / texels_per_line * texels_per_line;
+    }
+    texture.texels.resize(offset);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const TiledTexture::Level& level = texture.levels[i];
+        for (uint32_t y = 0; y < level.height; ++y) {
+            for (uint32_t x = 0; x < level.width; ++x) {
+                texture.texels[TiledTexture::TexelIndex(level, x, y)] = rows[i][size_t(y) * level.width + x];
+            }
+        }
+    }
+    return texture;
+}
+
+// 2x2 box per channel, rounded: the cooker's box filter on even sizes, odd sizes drop the last row or column
+std::vector<uint32_t> Downsample(std::span<const uint32_t> src, uint32_t width, uint32_t height, uint32_t dst_width, uint32_t dst_height)
+{
+    std::vector<uint32_t> dst(size_t(dst_width) * dst_height);
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        uint32_t y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (uint32_t x = 0; x < dst_width; ++x) {
+            uint32_t x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            uint32_t a = src[size_t(y0) * width + x0], b = src[size_t(y0) * width + x1];
+            uint32_t c = src[size_t(y1) * width + x0], d = src[size_t(y1) * width + x1];
+            uint32_t texel = 0;
+            for (uint32_t shift = 0; shift < 32; shift += 8) {
+                uint32_t sum = (a >> shift & 0xff) + (b >> shift & 0xff) + (c >> shift & 0xff) + (d >> shift & 0xff);
+                texel |= (sum + 2) / 4 << shift;
+            }
+            dst[size_t(y) * dst_width + x] = texel;
+        }
+    }
+    return dst;
+}
+
+// one trilinear tap of footprint at (u, v), channels added to sum in texel units
+void TrilinearTap(const TiledTexture& texture, const FilterFootprint& footprint, float u, float v, float* sum) noexcept
+{
+    float fu = u - std::floor(u), fv = v - std::floor(v);
+    float filtered[2][4];
+    uint32_t levels[2] = { footprint.level0, footprint.level1 };
+    for (uint32_t i = 0; i < 2; ++i) {
+        const TiledTexture::Level& level = texture.levels[levels[i]];
+        float x = fu * float(level.width) - 0.5f, y = fv * float(level.height) - 0.5f;
+        float x0 = std::floor(x), y0 = std::floor(y);
+        float fx = x - x0, fy = y - y0;
+        uint32_t t00, t10, t01, t11;
+        BilinearTexels(texture, levels[i], x0, y0, t00, t10, t01, t11);
+        for (uint32_t c = 0; c < 4; ++c) {
+            auto channel = [c](uint32_t texel) { return float(texel >> 8 * c & 0xff); };
+            float top = channel(t00) + (channel(t10) - channel(t00)) * fx;
+            float bottom = channel(t01) + (channel(t11) - channel(t01)) * fx;
+            filtered[i][c] = top + (bottom - top) * fy;
+        }
+    }
+    for (uint32_t c = 0; c < 4; ++c) {
+        sum[c] = sum[c] + (filtered[0][c] + (filtered[1][c] - filtered[0][c]) * footprint.level_weight);
+    }
+}
+
+Rgba Filter(const TiledTexture& texture, const FilterFootprint& footprint) noexcept
+{
+    float sum[4]{};
+    for (uint32_t tap = 0; tap < footprint.taps; ++tap) {
+        TrilinearTap(texture, footprint, footprint.u + footprint.step_u * float(tap), footprint.v + footprint.step_v * float(tap), sum);
+    }
+    float scale = 1.0f / float(footprint.taps);
+    constexpr float unorm = 1.0f / 255.0f;
+    return { sum[0] * scale * unorm, sum[1] * scale * unorm, sum[2] * scale * unorm, sum[3] * scale * unorm };
+}
+} // namespace
+
+w::cpu::TiledTexture w::cpu::TiledTexture::FromRgba8(std::span<const uint32_t> texels, uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0 || texels.size() < size_t(width) * height) {
+        throw std::runtime_error("TiledTexture::FromRgba8: texels do not cover width x height");
+    }
+    std::vector<std::vector<uint32_t>> rows{ { texels.begin(), texels.begin() + size_t(width) * height } };
+    std::vector<std::pair<uint32_t, uint32_t>> sizes{ { width, height } };
+    while (width > 1 || height > 1) {
+        uint32_t next_width = std::max(1u, width / 2), next_height = std::max(1u, height / 2);
+        rows.push_back(Downsample(rows.back(), width, height, next_width, next_height));
+        sizes.emplace_back(next_width, next_height);
+        width = next_width;
+        height = next_height;
+    }
+    return Swizzle(rows, sizes);
+}
+
+w::cpu::TiledTexture w::cpu::TiledTexture::FromMipChain(std::span<const std::byte> data, std::span<const w::dds::MipLevel> mips)
+{
+    std::vector<std::vector<uint32_t>> rows;
+    std::vector<std::pair<uint32_t, uint32_t>> sizes;
+    for (const auto& mip : mips) {
+        size_t row_size = size_t(mip.width) * sizeof(uint32_t);
+        if (mip.width == 0 || mip.rows != mip.height || mip.row_bytes < row_size || mip.offset + uint64_t(mip.row_bytes) * mip.rows > data.size()) {
+            throw std::runtime_error("TiledTexture::FromMipChain: mips are not an RGBA8 chain inside data");
+        }
+        auto& level = rows.emplace_back(size_t(mip.width) * mip.height);
+        for (uint32_t y = 0; y < mip.height; ++y) {
+            std::memcpy(level.data() + size_t(y) * mip.width, data.data() + mip.offset + size_t(y) * mip.row_bytes, row_size);
+        }
+        sizes.emplace_back(mip.width, mip.height);
+    }
+    if (sizes.empty()) {
+        throw std::runtime_error("TiledTexture::FromMipChain: no mips");
+    }
+    return Swizzle(rows, sizes);
+}
+
+float w::cpu::TriangleLod(float3 p0, float3 p1, float3 p2, float u0, float v0, float u1, float v1, float u2, float v2, uint32_t width,
+                          uint32_t height) noexcept
+{
+    float texel_area = float(width) * float(height) * std::fabs((u1 - u0) * (v2 - v0) - (u2 - u0) * (v1 - v0));
+    float world_area = Length(Cross(p1 - p0, p2 - p0));
+    return 0.5f * std::log2(texel_area / world_area);
+}
+
+w::cpu::TextureSampler::TextureSampler(const SamplerSettings& settings)
+    : settings(settings)
+{
+    this->settings.isa = ClampSimdIsa(settings.isa);
+}
+
+w::cpu::Rgba w::cpu::TextureSampler::SampleLevel(const TiledTexture& texture, const LevelLookup& lookup) const noexcept
+{
+    return Filter(texture, LevelFootprint(texture, settings, lookup));
+}
+
+w::cpu::Rgba w::cpu::TextureSampler::SampleGrad(const TiledTexture& texture, const GradLookup& lookup) const noexcept
+{
+    return Filter(texture, GradFootprint(texture, settings, lookup));
+}
+
+void w::cpu::TextureSampler::SampleLevel(const TiledTexture& texture, std::span<const LevelLookup> lookups, std::span<Rgba> out) const noexcept
+{
+    switch (settings.isa) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::SampleLevel(texture, settings, lookups, out);
+    case SimdIsa::AVX2:
+        return avx2::SampleLevel(texture, settings, lookups, out);
+    case SimdIsa::SSE:
+        return sse::SampleLevel(texture, settings, lookups, out);
+#endif
+    default:
+        for (size_t i = 0; i < lookups.size(); ++i) {
+            out[i] = SampleLevel(texture, lookups[i]);
+        }
+    }
+}
+
+void w::cpu::TextureSampler::SampleGrad(const TiledTexture& texture, std::span<const GradLookup> lookups, std::span<Rgba> out) const noexcept
+{
+    switch (settings.isa) {
+#if W_CPU_X86
+    case SimdIsa::AVX512:
+        return avx512::SampleGrad(texture, settings, lookups, out);
+    case SimdIsa::AVX2:
+        return avx2::SampleGrad(texture, settings, lookups, out);
+    case SimdIsa::SSE:
+        return sse::SampleGrad(texture, settings, lookups, out);
+#endif
+    default:
+        for (size_t i = 0; i < lookups.size(); ++i) {
+            out[i] = SampleGrad(texture, lookups[i]);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "bvh.hpp"
+#include "dds.hpp"
+#include "simd_isa.hpp"
+#include <span>
+#include <vector>
+
+namespace w::cpu {
+// filtered texel, unorm channels in [0, 1] like a Texture2D<float4> read of an RGBA8 SRV
+struct Rgba {
+    float r = 0, g = 0, b = 0, a = 0;
+};
+
+// Mip-mapped RGBA8 texture swizzled for filtering: every level is stored in Morton order over its size padded to
+// powers of two, so each aligned 4x4 block of texels is one cache line and a bilinear footprint touches one or two
+// lines instead of two rows a pitch apart. Levels start on a cache line, texels are 0xAABBGGRR like the uploaded data
+class TiledTexture
+{
+public:
+    struct Level {
+        uint32_t width = 0, height = 0;
+        uint32_t offset = 0; // first texel
+        uint32_t square_bits = 0; // log2 of the smaller padded side, bits above it belong to the longer axis alone
+    };
+
+public:
+    // level 0 as rows of width texels, the rest of the chain is box filtered down to 1x1
+    static TiledTexture FromRgba8(std::span<const uint32_t> texels, uint32_t width, uint32_t height);
+    // a cooked RGBA8Unorm chain as laid out by dds::MipLayout, e.g. the data of a parsed .dds surface
+    static TiledTexture FromMipChain(std::span<const std::byte> data, std::span<const w::dds::MipLevel> mips);
+
+public:
+    uint32_t Width() const noexcept
+    {
+        return levels[0].width;
+    }
+    uint32_t Height() const noexcept
+    {
+        return levels[0].height;
+    }
+    uint32_t LevelCount() const noexcept
+    {
+        return uint32_t(levels.size());
+    }
+    // x < width, y < height of the level
+    uint32_t Texel(uint32_t level, uint32_t x, uint32_t y) const noexcept
+    {
+        return texels[TexelIndex(levels[level], x, y)];
+    }
+
+    static uint32_t TexelIndex(const Level& level, uint32_t x, uint32_t y) noexcept
+    {
+        auto spread = [](uint32_t v) { // low 16 bits one bit apart
+            v = (v | v << 8) & 0x00ff00ffu;
+            v = (v | v << 4) & 0x0f0f0f0fu;
+            v = (v | v << 2) & 0x33333333u;
+            return (v | v << 1) & 0x55555555u;
+        };
+        uint32_t mask = (1u << level.square_bits) - 1;
+        uint32_t rest = (x | y) >> level.square_bits; // only the longer axis has bits left
+        return level.offset + (spread(x & mask) | spread(y & mask) << 1 | rest << 2 * level.square_bits);
+    }
+
+public:
+    std::vector<Level> levels;
+    std::vector<uint32_t, CacheLineAllocator<uint32_t>> texels;
+};
+
+// CPU side of the wis::SamplerDesc in Scene::CreatePipelines: linear min, mag and mip filtering, Repeat on u and v
+struct SamplerSettings {
+    float min_lod = 0.0f;
+    float max_lod = 16.0f;
+    float mip_lod_bias = 0.0f;
+    // 1 is the trilinear filter the GPU sampler uses (anisotropic = false). Above 1, SampleGrad takes up to this many
+    // trilinear taps along the long axis of an elongated footprint, on the level of its short axis
+    uint32_t max_anisotropy = 1;
+    SimdIsa isa = DetectSimdIsa(); // clamped to what the CPU supports, Scalar runs the reference path
+};
+
+// explicit level of detail, e.g. from RayConeLod
+struct LevelLookup {
+    float u = 0, v = 0;
+    float lod = 0;
+};
+
+// screen space derivatives of the texture coordinates, e.g. from ray differentials. Level and anisotropy follow
+// from the footprint like SampleGrad on the GPU
+struct GradLookup {
+    float u = 0, v = 0;
+    float du_dx = 0, dv_dx = 0;
+    float du_dy = 0, dv_dy = 0;
+};
+
+// Ray cone level of detail (Akenine-Moller et al., "Texture Level of Detail Strategies for Real-Time Ray Tracing"):
+// the triangle term is half the log2 of texel area over world area, fixed per triangle and texture
+float TriangleLod(float3 p0, float3 p1, float3 p2, float u0, float v0, float u1, float v1, float u2, float v2, uint32_t width,
+                  uint32_t height) noexcept;
+// cone_width at the hit (spread angle * distance for a primary ray), cos_theta between the ray and the surface normal
+inline float RayConeLod(float triangle_lod, float cone_width, float cos_theta) noexcept
+{
+    return triangle_lod + std::log2(std::fabs(cone_width) / std::max(std::fabs(cos_theta), 1e-6f));
+}
+
+// Filters tiled textures in batches, a SIMD width of lookups at a time with per lane texel fetches. The scalar overloads
+// are the reference the kernels follow operation for operation
+class TextureSampler
+{
+public:
+    explicit TextureSampler(const SamplerSettings& settings = {});
+
+public:
+    Rgba SampleLevel(const TiledTexture& texture, const LevelLookup& lookup) const noexcept;
+    Rgba SampleGrad(const TiledTexture& texture, const GradLookup& lookup) const noexcept;
+    // out gets one texel per lookup
+    void SampleLevel(const TiledTexture& texture, std::span<const LevelLookup> lookups, std::span<Rgba> out) const noexcept;
+    void SampleGrad(const TiledTexture& texture, std::span<const GradLookup> lookups, std::span<Rgba> out) const noexcept;
+
+    const SamplerSettings& Settings() const noexcept
+    {
+        return settings;
+    }
+
+private:
+    SamplerSettings settings;
+};
+} // namespace w::cpu
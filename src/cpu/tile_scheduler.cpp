@@ -0,0 +1,185 @@
+#include "tile_scheduler.hpp"
+#include <chrono>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+void PinCurrentThread(uint32_t cpu) noexcept
+{
+#if defined(_WIN32)
+    if (cpu < 64) { // one processor group is plenty for pinning experiments
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu; // no affinity API, threads float
+#endif
+}
+} // namespace
+
+bool w::cpu::TileScheduler::TileQueue::PopBack(Tile& tile)
+{
+    std::scoped_lock lock{ mutex };
+    if (head == tiles.size()) {
+        return false;
+    }
+    tile = tiles.back();
+    tiles.pop_back();
+    return true;
+}
+
+bool w::cpu::TileScheduler::TileQueue::PopFront(Tile& tile)
+{
+    std::scoped_lock lock{ mutex };
+    if (head == tiles.size()) {
+        return false;
+    }
+    tile = tiles[head++];
+    return true;
+}
+
+w::cpu::TileScheduler::TileScheduler(const TileSchedulerSettings& settings)
+    : settings(settings)
+{
+    uint32_t threads = settings.thread_count ? settings.thread_count : std::max(1u, std::thread::hardware_concurrency());
+    this->settings.thread_count = threads;
+    this->settings.tile_width = std::max(1u, settings.tile_width);
+    this->settings.tile_height = std::max(1u, settings.tile_height);
+    for (uint32_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<TileQueue>());
+    }
+    workers.reserve(threads);
+    for (uint32_t i = 0; i < threads; i++) {
+        workers.emplace_back([this, i](std::stop_token stop) { Work(i, stop); });
+    }
+}
+
+w::cpu::TileScheduler::~TileScheduler()
+{
+    for (auto& worker : workers) {
+        worker.request_stop(); // wakes the cv wait below
+    }
+}
+
+void w::cpu::TileScheduler::Run(uint32_t width, uint32_t height, const std::function<void(const Tile&)>& work)
+{
+    std::vector<Tile> tiles;
+    for (uint32_t y = 0; y < height; y += settings.tile_height) {
+        for (uint32_t x = 0; x < width; x += settings.tile_width) {
+            tiles.push_back({ x, y, std::min(settings.tile_width, width - x), std::min(settings.tile_height, height - y) });
+        }
+    }
+    if (tiles.empty()) {
+        return;
+    }
+
+    // contiguous blocks keep each worker on one screen region until it has to steal.
+    // The owner pops from the back, so each block is reversed to run top to bottom
+    uint32_t threads = ThreadCount();
+    for (uint32_t i = 0; i < threads; i++) {
+        TileQueue& queue = *queues[i];
+        size_t begin = tiles.size() * i / threads;
+        size_t end = tiles.size() * (i + 1) / threads;
+        queue.tiles.assign(tiles.rbegin() + (tiles.size() - end), tiles.rbegin() + (tiles.size() - begin));
+        queue.head = 0;
+        queue.stats = {};
+    }
+
+    active.store(threads, std::memory_order_relaxed);
+    {
+        std::scoped_lock lock{ mutex };
+        this->work = &work;
+        generation++;
+    }
+    cv.notify_all();
+
+    // a worker only leaves once every deque is empty, so the last one out has seen all tiles finish
+    for (uint32_t left = active.load(std::memory_order_acquire); left != 0; left = active.load(std::memory_order_acquire)) {
+        active.wait(left, std::memory_order_acquire);
+    }
+}
+
+std::vector<w::cpu::TileThreadStats> w::cpu::TileScheduler::Stats() const
+{
+    std::vector<TileThreadStats> stats;
+    for (auto& queue : queues) {
+        stats.push_back(queue->stats); // workers are idle between runs
+    }
+    return stats;
+}
+
+void w::cpu::TileScheduler::Work(uint32_t index, std::stop_token stop)
+{
+    if (settings.pin_threads) {
+        PinCurrentThread(index % std::max(1u, std::thread::hardware_concurrency()));
+    }
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock lock{ mutex };
+            cv.wait(lock, stop, [&]() { return generation != seen; });
+            if (stop.stop_requested()) {
+                return;
+            }
+            seen = generation;
+        }
+        RunTiles(index);
+        if (active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            active.notify_all();
+        }
+    }
+}
+
+void w::cpu::TileScheduler::RunTiles(uint32_t index)
+{
+    TileQueue& own = *queues[index];
+    uint32_t seed = index * 0x9e3779b9u + 1;
+    Tile tile;
+    while (true) {
+        bool stolen = false;
+        if (!own.PopBack(tile)) {
+            // no tiles are added during a run, when every deque is empty this worker is done
+            if (!Steal(index, seed, tile)) {
+                return;
+            }
+            stolen = true;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        (*work)(tile);
+        own.stats.busy_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        own.stats.tiles++;
+        own.stats.stolen += stolen;
+    }
+}
+
+bool w::cpu::TileScheduler::Steal(uint32_t thief, uint32_t& seed, Tile& tile)
+{
+    uint32_t threads = ThreadCount();
+    if (threads < 2 || !settings.work_stealing) {
+        return false;
+    }
+    // xorshift picks where the sweep over the victims starts, so thieves spread over different deques
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    uint32_t start = seed % threads;
+    for (uint32_t i = 0; i < threads; i++) {
+        uint32_t victim = (start + i) % threads;
+        if (victim != thief && queues[victim]->PopFront(tile)) {
+            return true;
+        }
+    }
+    return false;
+}
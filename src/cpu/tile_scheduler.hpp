@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace w::cpu {
+struct Tile {
+    uint32_t x = 0, y = 0;
+    uint32_t width = 0, height = 0;
+};
+
+struct TileSchedulerSettings {
+    uint32_t thread_count = 0; // 0 for hardware concurrency
+    uint32_t tile_width = 16;
+    uint32_t tile_height = 16;
+    bool pin_threads = false; // worker i stays on logical CPU i % hardware concurrency
+    bool work_stealing = true; // false leaves every worker on its own block, a static split to compare against
+};
+
+struct TileThreadStats {
+    uint32_t tiles = 0; // tiles this worker ran
+    uint32_t stolen = 0; // of those, taken from another worker's deque
+    double busy_ms = 0; // time spent inside tile work
+};
+
+// Runs tile work for a frame on persistent workers. Each worker owns a deque seeded with a contiguous block of
+// tiles, works it from the back and steals from the front of a random victim once it runs dry, so threads that
+// drew cheap sky tiles end up helping with the expensive ones. Deques are locked, tiles are coarse enough that
+// the locks stay uncontended.
+class TileScheduler
+{
+public:
+    explicit TileScheduler(const TileSchedulerSettings& settings = {});
+    ~TileScheduler();
+
+public:
+    // splits width x height into tiles and blocks until work has run on all of them, work is called concurrently
+    void Run(uint32_t width, uint32_t height, const std::function<void(const Tile&)>& work);
+
+    uint32_t ThreadCount() const noexcept
+    {
+        return uint32_t(workers.size());
+    }
+    const TileSchedulerSettings& Settings() const noexcept
+    {
+        return settings;
+    }
+    // per worker, of the last Run
+    std::vector<TileThreadStats> Stats() const;
+
+private:
+    struct alignas(64) TileQueue {
+        std::mutex mutex;
+        std::vector<Tile> tiles;
+        size_t head = 0; // thieves take from here, the owner from the back
+        TileThreadStats stats;
+
+        bool PopBack(Tile& tile);
+        bool PopFront(Tile& tile);
+    };
+
+    void Work(uint32_t index, std::stop_token stop);
+    void RunTiles(uint32_t index);
+    bool Steal(uint32_t thief, uint32_t& seed, Tile& tile);
+
+private:
+    TileSchedulerSettings settings;
+    std::vector<std::unique_ptr<TileQueue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    uint64_t generation = 0; // bumped per Run, wakes the workers
+    const std::function<void(const Tile&)>* work = nullptr;
+    std::atomic<uint32_t> active{ 0 }; // workers still inside the current Run
+
+    std::vector<std::jthread> workers; // last, so threads are joined before the queues die
+};
+} // namespace w::cpu
@@ -0,0 +1,145 @@
+#include "tlas.hpp"
+
+namespace {
+using namespace w::cpu;
+using Transform = std::array<std::array<float, 4>, 3>;
+
+float3 Row(const Transform& m, uint32_t row) noexcept
+{
+    return { m[row][0], m[row][1], m[row][2] };
+}
+
+float3 TransformPoint(const Transform& m, float3 p) noexcept
+{
+    return { Dot(Row(m, 0), p) + m[0][3], Dot(Row(m, 1), p) + m[1][3], Dot(Row(m, 2), p) + m[2][3] };
+}
+
+float3 TransformVector(const Transform& m, float3 v) noexcept
+{
+    return { Dot(Row(m, 0), v), Dot(Row(m, 1), v), Dot(Row(m, 2), v) };
+}
+
+// inverse of an affine 3x4, false when the linear part is singular
+bool Invert(const Transform& m, Transform& inverse) noexcept
+{
+    float3 a = Row(m, 0), b = Row(m, 1), c = Row(m, 2);
+    float3 columns[3]{ Cross(b, c), Cross(c, a), Cross(a, b) };
+    float det = Dot(a, columns[0]);
+    if (!(std::fabs(det) > 1e-30f) || !std::isfinite(det)) {
+        return false;
+    }
+    float inv_det = 1.0f / det;
+    float3 t{ m[0][3], m[1][3], m[2][3] };
+    for (uint32_t row = 0; row < 3; ++row) {
+        float3 r{ columns[0][row] * inv_det, columns[1][row] * inv_det, columns[2][row] * inv_det };
+        inverse[row] = { r.x, r.y, r.z, -Dot(r, t) };
+    }
+    return true;
+}
+
+// world box of a transformed object box: the center moves, the half extent goes through |M|
+Aabb TransformBounds(const Transform& m, const Aabb& box) noexcept
+{
+    float3 center = TransformPoint(m, box.Center());
+    float3 half = box.Extent() * 0.5f;
+    float3 extent;
+    for (uint32_t row = 0; row < 3; ++row) {
+        extent[row] = std::fabs(m[row][0]) * half.x + std::fabs(m[row][1]) * half.y + std::fabs(m[row][2]) * half.z;
+    }
+    return { center - extent, center + extent };
+}
+} // namespace
+
+w::cpu::Tlas w::cpu::Tlas::Build(std::span<const Blas* const> blases, std::span<const Instance> instances, const BvhBuildSettings& settings)
+{
+    Tlas tlas;
+    tlas.blases.assign(blases.begin(), blases.end());
+
+    std::vector<Aabb> bounds;
+    std::vector<TlasInstance> kept;
+    bounds.reserve(instances.size());
+    kept.reserve(instances.size());
+    for (uint32_t i = 0; i < instances.size(); ++i) {
+        const Instance& instance = instances[i];
+        const Blas* blas = instance.blas < blases.size() ? blases[instance.blas] : nullptr;
+        TlasInstance entry{ .blas = instance.blas, .instance_id = instance.instance_id, .mask = instance.mask & 0xff, .index = i };
+        if (!blas || blas->bvh.nodes.empty() || !Invert(instance.transform, entry.world_to_object)) {
+            continue;
+        }
+        bounds.push_back(TransformBounds(instance.transform, blas->bvh.nodes[0].Bounds()));
+        kept.push_back(entry);
+    }
+
+    tlas.bvh = BuildBvh(bounds, settings);
+    tlas.instances.reserve(kept.size());
+    for (uint32_t reference : tlas.bvh.references) {
+        tlas.instances.push_back(kept[reference]);
+    }
+    return tlas;
+}
+
+w::cpu::TlasHit w::cpu::Tlas::Trace(const Ray& ray, uint32_t inclusion_mask) const noexcept
+{
+    TlasHit result;
+    inclusion_mask &= 0xff;
+    if (bvh.nodes.empty() || !inclusion_mask) {
+        return result;
+    }
+
+    struct Entry {
+        uint32_t node;
+        float t_near;
+    };
+    Entry stack[traversal_stack_size];
+    uint32_t top = 0;
+
+    float3 inv_dir = SafeInverse(ray.dir);
+    auto visit = [&](const BvhNode& node) {
+        return IntersectAabb(ray.origin, inv_dir, ray.t_min, std::min(result.hit.t, ray.t_max), node.lo, node.hi);
+    };
+    Entry current{ 0, visit(bvh.nodes[0]) };
+    if (current.t_near == HUGE_VALF) {
+        return result;
+    }
+    while (true) {
+        const BvhNode& node = bvh.nodes[current.node];
+        if (node.IsLeaf()) {
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i) {
+                const TlasInstance& instance = instances[i];
+                if (!(instance.mask & inclusion_mask)) {
+                    continue;
+                }
+                // the direction is not renormalized, so t means the same in both spaces
+                Ray local{ .origin = TransformPoint(instance.world_to_object, ray.origin),
+                           .t_min = ray.t_min,
+                           .dir = TransformVector(instance.world_to_object, ray.dir),
+                           .t_max = std::min(result.hit.t, ray.t_max) };
+                Hit hit = blases[instance.blas]->Trace(local);
+                if (!hit.Missed()) {
+                    result = { hit, instance.index, instance.instance_id };
+                }
+            }
+        } else {
+            Entry near{ node.left_first, visit(bvh.nodes[node.left_first]) };
+            Entry far{ node.left_first + 1, visit(bvh.nodes[node.left_first + 1]) };
+            if (far.t_near < near.t_near) {
+                std::swap(near, far);
+            }
+            if (near.t_near != HUGE_VALF) {
+                if (far.t_near != HUGE_VALF) {
+                    stack[top++] = far;
+                }
+                current = near;
+                continue;
+            }
+        }
+
+        // pop, skipping nodes a closer hit has since ruled out
+        do {
+            if (top == 0) {
+                return result;
+            }
+            current = stack[--top];
+        } while (current.t_near >= result.hit.t);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "blas.hpp"
+#include <array>
+#include <span>
+#include <vector>
+
+namespace w::cpu {
+// the CPU side of a wis::AccelerationInstance
+struct Instance {
+    std::array<std::array<float, 4>, 3> transform{ { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } }; // object to world rows, like Model::GetTransform
+    uint32_t instance_id = 0; // what InstanceID() returns for hits on it
+    uint32_t mask = 0xff; // only the low 8 bits count, ANDed with the ray's inclusion mask
+    uint32_t blas = 0; // index into the BLAS list given to Tlas::Build
+};
+
+// one cache line per instance, in leaf order: what the traversal needs to enter the BLAS
+struct alignas(64) TlasInstance {
+    std::array<std::array<float, 4>, 3> world_to_object;
+    uint32_t blas;
+    uint32_t instance_id;
+    uint32_t mask;
+    uint32_t index; // position in the instance list given to Build
+};
+static_assert(sizeof(TlasInstance) == 64);
+
+struct TlasHit {
+    Hit hit; // primitive is a triangle of the instance's BLAS, t is shared with the world space ray
+    uint32_t instance = ~0u; // index into the instance list given to Build, ~0u for a miss
+    uint32_t instance_id = 0;
+
+    bool Missed() const noexcept
+    {
+        return hit.Missed();
+    }
+};
+
+// Two-level structure, the CPU counterpart of the TLAS from Scene::CreateTLAS: a BVH over instance world bounds whose
+// leaves transform the ray into object space and continue in the shared BLAS. Memory grows with the instance count only,
+// the BLASes are referenced and must outlive the Tlas
+class Tlas
+{
+public:
+    // instances with a transform that cannot be inverted are left out
+    static Tlas Build(std::span<const Blas* const> blases, std::span<const Instance> instances, const BvhBuildSettings& settings = {});
+
+public:
+    // closest hit among the instances whose mask shares a bit with inclusion_mask, like TraceRay's InstanceInclusionMask
+    TlasHit Trace(const Ray& ray, uint32_t inclusion_mask = 0xff) const noexcept;
+
+    size_t MemoryBytes() const noexcept
+    {
+        return bvh.nodes.size() * sizeof(BvhNode) + bvh.references.size() * sizeof(uint32_t) + instances.size() * sizeof(TlasInstance);
+    }
+
+public:
+    Bvh bvh; // over instance world bounds
+    std::vector<TlasInstance> instances; // in leaf order
+    std::vector<const Blas*> blases;
+};
+} // namespace w::cpu
@@ -0,0 +1,41 @@
+#include "triangle_mesh.hpp"
+#include "../consts.hpp"
+#include "../model_loader.hpp"
+#include "../vertex_format.hpp"
+
+w::cpu::TriangleMesh w::cpu::TriangleMesh::FromModel(const w::ModelLoader& model, float3 scale)
+{
+    TriangleMesh mesh;
+    mesh.positions.reserve(model.vertices.size());
+    if constexpr (w::quantized_vertices) {
+        // the positions the GPU BLAS is built from: snorm16 relative to the mesh bounds, decoded by the instance transform
+        auto bounds = w::QuantizationBounds::FromPoints(model.vertices);
+        auto transform = w::DequantizeTransform(bounds, { scale.x, scale.y, scale.z });
+        for (auto& v : model.vertices) {
+            w::PackedPosition packed = w::PackPosition(v, bounds);
+            float3 p{ w::UnpackSnorm16(packed.x), w::UnpackSnorm16(packed.y), w::UnpackSnorm16(packed.z) };
+            auto row = [&p](const std::array<float, 4>& r) { return r[0] * p.x + r[1] * p.y + r[2] * p.z + r[3]; };
+            mesh.positions.push_back({ row(transform[0]), row(transform[1]), row(transform[2]) });
+        }
+    } else {
+        for (auto& v : model.vertices) {
+            mesh.positions.push_back(float3{ v.x, v.y, v.z } * scale);
+        }
+    }
+
+    for (uint32_t s = 0; s < model.submeshes.size(); ++s) {
+        auto& submesh = model.submeshes[s];
+        auto append = [&](auto indices) {
+            for (auto index : indices) {
+                mesh.indices.push_back(submesh.vertex_offset + uint32_t(index));
+            }
+        };
+        if (submesh.index_type == w::IndexType::UInt16) {
+            append(model.SubmeshIndices<uint16_t>(submesh));
+        } else {
+            append(model.SubmeshIndices<uint32_t>(submesh));
+        }
+        mesh.submesh_of.resize(mesh.indices.size() / 3, s);
+    }
+    return mesh;
+}
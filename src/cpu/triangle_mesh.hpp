@@ -0,0 +1,34 @@
+#pragma once
+#include "math.hpp"
+#include <span>
+#include <vector>
+
+namespace w {
+class ModelLoader;
+}
+
+namespace w::cpu {
+// Flat triangle list for the CPU reference code, every submesh rebased onto one vertex array
+struct TriangleMesh {
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices; // 3 per triangle, absolute into positions
+    std::vector<uint32_t> submesh_of; // per triangle, the geometry index the GPU BLAS would report
+
+    // scale matches what Model applies before upload, so both sides see the same world. With w::quantized_vertices the
+    // positions go through the same snorm16 packing and instance transform as the GPU BLAS
+    static TriangleMesh FromModel(const w::ModelLoader& model, float3 scale = { 0.01f, -0.01f, 0.01f });
+
+    uint32_t TriangleCount() const noexcept
+    {
+        return uint32_t(indices.size() / 3);
+    }
+    Aabb TriangleBounds(uint32_t triangle) const noexcept
+    {
+        Aabb box;
+        box.Grow(positions[indices[triangle * 3 + 0]]);
+        box.Grow(positions[indices[triangle * 3 + 1]]);
+        box.Grow(positions[indices[triangle * 3 + 2]]);
+        return box;
+    }
+};
+} // namespace w::cpu
@@ -0,0 +1,213 @@
+// Generate and shade stages of the wavefront path tracer, compiled once per instruction set: the including file defines
+// W_SIMD_<ISA> and W_SIMD_NS. Lanes run PrimaryRays::Generate and ShadePath from path_tracer.cpp in the same operation
+// order, gathers in front and the compacting appends behind are per lane
+#include "path_tracer.hpp"
+#include "simd.hpp"
+#include "wavefront_kernels.hpp"
+
+namespace w::cpu::W_SIMD_NS {
+namespace {
+struct alignas(64) ShadeLanes {
+    float ox[width], oy[width], oz[width];
+    float dx[width], dy[width], dz[width];
+    float t[width];
+    float v0x[width], v0y[width], v0z[width];
+    float v1x[width], v1y[width], v1z[width];
+    float v2x[width], v2y[width], v2z[width];
+    float tr[width], tg[width], tb[width];
+    float disk_x[width], disk_y[width];
+};
+
+struct vfloat3 {
+    vfloat x, y, z;
+};
+
+inline vfloat3 operator+(vfloat3 a, vfloat3 b) noexcept
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+inline vfloat3 operator-(vfloat3 a, vfloat3 b) noexcept
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+inline vfloat3 operator*(vfloat3 a, vfloat s) noexcept
+{
+    return { a.x * s, a.y * s, a.z * s };
+}
+inline vfloat Dot(vfloat3 a, vfloat3 b) noexcept
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+inline vfloat3 Cross(vfloat3 a, vfloat3 b) noexcept
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+inline vfloat3 Broadcast3(float3 a) noexcept
+{
+    return { Broadcast(a.x), Broadcast(a.y), Broadcast(a.z) };
+}
+inline vfloat3 Select(vmask mask, vfloat3 a, vfloat3 b) noexcept
+{
+    return { Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z) };
+}
+inline vfloat3 Load3(const float* x, const float* y, const float* z) noexcept
+{
+    return { Load(x), Load(y), Load(z) };
+}
+inline void Store3(float* x, float* y, float* z, vfloat3 a) noexcept
+{
+    Store(x, a.x);
+    Store(y, a.y);
+    Store(z, a.z);
+}
+} // namespace
+
+void GenerateRays(const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t tile_width, uint32_t count, Ray* rays) noexcept
+{
+    alignas(64) float px[width], py[width];
+    alignas(64) float dx[width], dy[width], dz[width];
+    const auto& view = camera.inv_view;
+    const auto& projection = camera.inv_projection;
+    // the origin is the same for every pixel, its w = 1 row of inv_view
+    float3 origin = camera.Generate(x, y).origin;
+
+    const vfloat one = Broadcast(1.0f);
+    const vfloat half = Broadcast(0.5f);
+    const vfloat two = Broadcast(2.0f);
+    const vfloat image_width = Broadcast(float(camera.width));
+    const vfloat image_height = Broadcast(float(camera.height));
+    for (uint32_t first = 0; first < count; first += width) {
+        uint32_t n = std::min(width, count - first);
+        for (uint32_t lane = 0; lane < width; ++lane) {
+            uint32_t i = first + std::min(lane, n - 1);
+            px[lane] = float(x + i % tile_width);
+            py[lane] = float(y + i / tile_width);
+        }
+        vfloat ndc_x = (Load(px) + half) / image_width * two - one;
+        vfloat ndc_y = (Load(py) + half) / image_height * two - one;
+        // v * matrix with z = w = 1, then z = w = 0 like the scalar transform
+        vfloat3 target;
+        target.x = ndc_x * Broadcast(projection[0][0]) + ndc_y * Broadcast(projection[1][0]) + Broadcast(projection[2][0]) + Broadcast(projection[3][0]);
+        target.y = ndc_x * Broadcast(projection[0][1]) + ndc_y * Broadcast(projection[1][1]) + Broadcast(projection[2][1]) + Broadcast(projection[3][1]);
+        target.z = ndc_x * Broadcast(projection[0][2]) + ndc_y * Broadcast(projection[1][2]) + Broadcast(projection[2][2]) + Broadcast(projection[3][2]);
+        target = target * (one / Sqrt(Dot(target, target)));
+        vfloat3 dir;
+        dir.x = target.x * Broadcast(view[0][0]) + target.y * Broadcast(view[1][0]) + target.z * Broadcast(view[2][0]) + Broadcast(0.0f * view[3][0]);
+        dir.y = target.x * Broadcast(view[0][1]) + target.y * Broadcast(view[1][1]) + target.z * Broadcast(view[2][1]) + Broadcast(0.0f * view[3][1]);
+        dir.z = target.x * Broadcast(view[0][2]) + target.y * Broadcast(view[1][2]) + target.z * Broadcast(view[2][2]) + Broadcast(0.0f * view[3][2]);
+        Store3(dx, dy, dz, dir);
+        for (uint32_t lane = 0; lane < n; ++lane) {
+            rays[first + lane] = { .origin = origin, .dir = { dx[lane], dy[lane], dz[lane] } };
+        }
+    }
+}
+
+void ShadePaths(const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows, float3* radiance) noexcept
+{
+    ShadeLanes lanes;
+    alignas(64) float sky_r[width], sky_g[width], sky_b[width];
+    alignas(64) float px[width], py[width], pz[width];
+    alignas(64) float lx[width], ly[width], lz[width], distance[width];
+    alignas(64) float cr[width], cg[width], cb[width];
+    alignas(64) float bx[width], by[width], bz[width];
+    alignas(64) float nr[width], ng[width], nb[width];
+
+    const vfloat one = Broadcast(1.0f);
+    const vfloat zero = Broadcast(0.0f);
+    const vfloat3 albedo = Broadcast3(hit_color * path_albedo);
+    for (uint32_t first = 0; first < in.count; first += width) {
+        uint32_t count = std::min(width, in.count - first);
+        uint32_t hit_bits = 0;
+        for (uint32_t lane = 0; lane < width; ++lane) {
+            uint32_t i = first + std::min(lane, count - 1); // the tail repeats the last path, its lanes are dropped
+            const Ray& ray = in.rays[i];
+            const Hit& hit = in.hits[i];
+            lanes.ox[lane] = ray.origin.x, lanes.oy[lane] = ray.origin.y, lanes.oz[lane] = ray.origin.z;
+            lanes.dx[lane] = ray.dir.x, lanes.dy[lane] = ray.dir.y, lanes.dz[lane] = ray.dir.z;
+            lanes.tr[lane] = in.throughput_r[i], lanes.tg[lane] = in.throughput_g[i], lanes.tb[lane] = in.throughput_b[i];
+            lanes.disk_x[lane] = in.disk_x[i], lanes.disk_y[lane] = in.disk_y[i];
+            float3 v0{}, v1{}, v2{};
+            lanes.t[lane] = 0;
+            if (!hit.Missed()) {
+                hit_bits |= 1u << lane;
+                lanes.t[lane] = hit.t;
+                v0 = mesh.positions[mesh.indices[hit.primitive * 3 + 0]];
+                v1 = mesh.positions[mesh.indices[hit.primitive * 3 + 1]];
+                v2 = mesh.positions[mesh.indices[hit.primitive * 3 + 2]];
+            }
+            lanes.v0x[lane] = v0.x, lanes.v0y[lane] = v0.y, lanes.v0z[lane] = v0.z;
+            lanes.v1x[lane] = v1.x, lanes.v1y[lane] = v1.y, lanes.v1z[lane] = v1.z;
+            lanes.v2x[lane] = v2.x, lanes.v2y[lane] = v2.y, lanes.v2z[lane] = v2.z;
+        }
+
+        vfloat3 origin = Load3(lanes.ox, lanes.oy, lanes.oz);
+        vfloat3 dir = Load3(lanes.dx, lanes.dy, lanes.dz);
+        vfloat3 throughput = Load3(lanes.tr, lanes.tg, lanes.tb);
+
+        // Miss
+        vfloat slope = dir.y * (one / Sqrt(Dot(dir, dir)));
+        vfloat sky_t = Min(Max(slope * Broadcast(5.0f) + Broadcast(0.5f), zero), one);
+        vfloat3 bottom = Broadcast3(sky_bottom);
+        vfloat3 sky = bottom + (Broadcast3(sky_top) - bottom) * sky_t;
+        Store3(sky_r, sky_g, sky_b, vfloat3{ throughput.x * sky.x, throughput.y * sky.y, throughput.z * sky.z });
+
+        // hit point and geometric normal, turned to face the ray
+        vfloat t = Load(lanes.t);
+        vfloat3 p = origin + dir * t;
+        vfloat3 v0 = Load3(lanes.v0x, lanes.v0y, lanes.v0z);
+        vfloat3 n = Cross(Load3(lanes.v1x, lanes.v1y, lanes.v1z) - v0, Load3(lanes.v2x, lanes.v2y, lanes.v2z) - v0);
+        n = n * (one / Sqrt(Dot(n, n)));
+        n = Select(Dot(n, dir) > zero, vfloat3{ zero - n.x, zero - n.y, zero - n.z }, n);
+        Store3(px, py, pz, p);
+
+        // shadow connection
+        vfloat3 l = Broadcast3(light) - p;
+        vfloat dist = Sqrt(Dot(l, l));
+        l = l * (one / dist);
+        vfloat cos_light = Dot(n, l);
+        uint32_t shadow_bits = hit_bits & Bits(cos_light > zero);
+        vfloat irradiance = cos_light * Broadcast(light_intensity);
+        Store3(cr, cg, cb, vfloat3{ throughput.x * albedo.x * irradiance, throughput.y * albedo.y * irradiance, throughput.z * albedo.z * irradiance });
+        Store3(lx, ly, lz, l);
+        Store(distance, dist);
+
+        // cosine weighted bounce: the normal plus a uniform point on the sphere, from the disk point (Marsaglia)
+        uint32_t bounce_bits = 0;
+        if (bounce) {
+            vfloat disk_x = Load(lanes.disk_x), disk_y = Load(lanes.disk_y);
+            vfloat s = disk_x * disk_x + disk_y * disk_y;
+            vfloat r = Broadcast(2.0f) * Sqrt(one - s);
+            vfloat3 b = n + vfloat3{ disk_x * r, disk_y * r, one - Broadcast(2.0f) * s };
+            vfloat length2 = Dot(b, b);
+            b = Select(length2 > Broadcast(1e-12f), b * (one / Sqrt(length2)), n);
+            vfloat3 weight{ throughput.x * albedo.x, throughput.y * albedo.y, throughput.z * albedo.z };
+            Store3(bx, by, bz, b);
+            Store3(nr, ng, nb, weight);
+            bounce_bits = hit_bits & Bits(Max(Max(weight.x, weight.y), weight.z) > zero);
+        }
+
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            uint32_t i = first + lane;
+            uint32_t pixel = in.pixel[i];
+            if (!(hit_bits >> lane & 1)) {
+                radiance[pixel] = radiance[pixel] + float3{ sky_r[lane], sky_g[lane], sky_b[lane] };
+                continue;
+            }
+            float3 hit_point{ px[lane], py[lane], pz[lane] };
+            if (shadow_bits >> lane & 1) {
+                uint32_t s = shadows.count++;
+                shadows.rays[s] = { .origin = hit_point, .dir = { lx[lane], ly[lane], lz[lane] }, .t_max = distance[lane] };
+                shadows.pixel[s] = pixel;
+                shadows.contribution_r[s] = cr[lane], shadows.contribution_g[s] = cg[lane], shadows.contribution_b[s] = cb[lane];
+            }
+            if (bounce_bits >> lane & 1) {
+                uint32_t c = next.count++;
+                next.rays[c] = { .origin = hit_point, .dir = { bx[lane], by[lane], bz[lane] } };
+                next.path[c] = in.path[i];
+                next.pixel[c] = pixel;
+                next.throughput_r[c] = nr[lane], next.throughput_g[c] = ng[lane], next.throughput_b[c] = nb[lane];
+            }
+        }
+    }
+}
+} // namespace w::cpu::W_SIMD_NS
@@ -0,0 +1,76 @@
+#pragma once
+#include "ray.hpp"
+#include <vector>
+
+// queues of the wavefront path tracer and the entry points of its shade stage, built per instruction set
+// from wavefront_kernel.inl next to the packet kernels
+namespace w::cpu {
+struct TriangleMesh;
+class PrimaryRays;
+
+// live paths, structure of arrays indexed by queue position. Arrays are sized once per wave, count says how much is used
+struct PathQueue {
+    std::vector<Ray> rays; // whole rays, what the traversal kernels read
+    std::vector<Hit> hits;
+    std::vector<uint32_t> path; // pixel * samples_per_pixel + sample, keys the random numbers
+    std::vector<uint32_t> pixel; // tile local
+    std::vector<float> throughput_r, throughput_g, throughput_b;
+    std::vector<float> disk_x, disk_y; // random point on the unit disk, turned into the bounce direction
+    uint32_t count = 0;
+
+    void Reserve(uint32_t capacity)
+    {
+        for (auto* v : { &path, &pixel }) {
+            v->resize(capacity);
+        }
+        for (auto* v : { &throughput_r, &throughput_g, &throughput_b, &disk_x, &disk_y }) {
+            v->resize(capacity);
+        }
+        rays.resize(capacity);
+        hits.resize(capacity);
+    }
+};
+
+// shadow rays towards light, contribution lands on pixel when nothing is in the way
+struct ShadowQueue {
+    std::vector<Ray> rays;
+    std::vector<uint8_t> occluded;
+    std::vector<uint32_t> pixel;
+    std::vector<float> contribution_r, contribution_g, contribution_b;
+    uint32_t count = 0;
+
+    void Reserve(uint32_t capacity)
+    {
+        for (auto* v : { &contribution_r, &contribution_g, &contribution_b }) {
+            v->resize(capacity);
+        }
+        rays.resize(capacity);
+        occluded.resize(capacity);
+        pixel.resize(capacity);
+    }
+};
+
+// Camera rays of the first count pixels of a tile width pixels wide at (x, y), pixel i at (x + i % width, y + i / width).
+// Lanes run PrimaryRays::Generate in the same operation order
+namespace sse {
+void GenerateRays(const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t count, Ray* rays) noexcept;
+}
+namespace avx2 {
+void GenerateRays(const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t count, Ray* rays) noexcept;
+}
+namespace avx512 {
+void GenerateRays(const PrimaryRays& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t count, Ray* rays) noexcept;
+}
+
+// Shades in.count paths after extend: misses add the sky to radiance, hits queue a shadow ray and, with bounce set,
+// a continuation into next. next and shadows are appended to, they need room for in.count more
+namespace sse {
+void ShadePaths(const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows, float3* radiance) noexcept;
+}
+namespace avx2 {
+void ShadePaths(const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows, float3* radiance) noexcept;
+}
+namespace avx512 {
+void ShadePaths(const PathQueue& in, const TriangleMesh& mesh, bool bounce, PathQueue& next, ShadowQueue& shadows, float3* radiance) noexcept;
+}
+} // namespace w::cpu
@@ -0,0 +1,3 @@
+#define W_SIMD_NS avx2
+#define W_WIDE_N 8
+#include "wide_kernel.inl"
@@ -0,0 +1,281 @@
+#include "wide_bvh.hpp"
+#include "wide_kernels.hpp"
+#include "wide_traversal.hpp"
+#include <bit>
+#include <stdexcept>
+
+namespace {
+template<uint32_t N>
+uint32_t ScalarBoxTest(const w::cpu::WideNode<N>& node, w::cpu::float3 origin, w::cpu::float3 inv_dir, float t_min, float t_max,
+                       float* t_near) noexcept
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        float t = w::cpu::IntersectAabb(origin, inv_dir, t_min, t_max, { node.lo_x[i], node.lo_y[i], node.lo_z[i] },
+                                        { node.hi_x[i], node.hi_y[i], node.hi_z[i] });
+        t_near[i] = t;
+        mask |= uint32_t(t != HUGE_VALF) << i;
+    }
+    return mask & node.child_mask;
+}
+
+template<uint32_t N>
+uint32_t ScalarQuantizedBoxTest(const w::cpu::QuantizedNode<N>& node, w::cpu::float3 origin, w::cpu::float3 inv_dir, float t_min,
+                                float t_max, float* t_near) noexcept
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        float t = w::cpu::IntersectAabb(origin, inv_dir, t_min, t_max,
+                                        { node.Decode(0, node.lo_x[i]), node.Decode(1, node.lo_y[i]), node.Decode(2, node.lo_z[i]) },
+                                        { node.Decode(0, node.hi_x[i]), node.Decode(1, node.hi_y[i]), node.Decode(2, node.hi_z[i]) });
+        t_near[i] = t;
+        mask |= uint32_t(t != HUGE_VALF) << i;
+    }
+    return mask & node.child_mask;
+}
+
+// one axis of a QuantizedNode: the smallest exponent at which every child, rounded outward, still fits in 8 bits
+template<uint32_t N>
+void QuantizeAxis(const w::cpu::WideNode<N>& node, uint32_t count, uint32_t axis, w::cpu::QuantizedNode<N>& quantized)
+{
+    const float* lo[3]{ node.lo_x, node.lo_y, node.lo_z };
+    const float* hi[3]{ node.hi_x, node.hi_y, node.hi_z };
+    uint8_t* q_lo[3]{ quantized.lo_x, quantized.lo_y, quantized.lo_z };
+    uint8_t* q_hi[3]{ quantized.hi_x, quantized.hi_y, quantized.hi_z };
+
+    float extent = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        extent = std::max(extent, hi[axis][i] - quantized.origin[axis]);
+    }
+    int32_t exponent = extent > 0 ? int32_t(std::ceil(std::log2(extent / 255.0f))) : -126;
+    for (exponent = std::clamp(exponent, -126, 127);; ++exponent) {
+        quantized.exponent[axis] = int8_t(exponent);
+        float scale = quantized.Scale(axis);
+        bool fits = true;
+        for (uint32_t i = 0; i < count && fits; ++i) {
+            // the float estimate can be off by one either way, the decoded value decides
+            float first = std::clamp(std::floor((lo[axis][i] - quantized.origin[axis]) / scale), 0.0f, 255.0f);
+            float last = std::clamp(std::ceil((hi[axis][i] - quantized.origin[axis]) / scale), 0.0f, 255.0f);
+            uint32_t a = uint32_t(first), b = uint32_t(last);
+            while (a > 0 && quantized.Decode(axis, uint8_t(a)) > lo[axis][i]) {
+                a--;
+            }
+            while (b < 255 && quantized.Decode(axis, uint8_t(b)) < hi[axis][i]) {
+                b++;
+            }
+            fits = quantized.Decode(axis, uint8_t(b)) >= hi[axis][i];
+            q_lo[axis][i] = uint8_t(a);
+            q_hi[axis][i] = uint8_t(b);
+        }
+        if (fits || exponent == 127) {
+            return;
+        }
+    }
+}
+} // namespace
+
+template<uint32_t N>
+w::cpu::WideBvh<N> w::cpu::WideBvh<N>::Collapse(const Blas& blas)
+{
+    WideBvh wide;
+    wide.triangles = blas.triangles;
+    wide.references = blas.bvh.references;
+    const auto& binary = blas.bvh.nodes;
+    if (binary.empty()) {
+        return wide;
+    }
+
+    auto make_slot = [&](uint32_t index, std::vector<std::pair<uint32_t, uint32_t>>& work) {
+        const BvhNode& node = binary[index];
+        if (node.IsLeaf()) {
+            if (node.count > WideSlot::max_leaf_size || node.left_first + node.count - 1 > WideSlot::max_first) {
+                throw std::runtime_error("Leaf does not fit a wide BVH slot, build with max_leaf_size <= 16");
+            }
+            return WideSlot::Leaf(node.left_first, node.count);
+        }
+        uint32_t wide_index = uint32_t(wide.nodes.size());
+        wide.nodes.emplace_back();
+        work.push_back({ index, wide_index });
+        return wide_index;
+    };
+
+    // a wide node starts from the two children of its binary node and keeps opening the largest inner one
+    // until it has N children, which pulls up the nodes a ray is most likely to visit
+    std::vector<std::pair<uint32_t, uint32_t>> work; // binary node, wide node
+    wide.nodes.emplace_back();
+    if (binary[0].IsLeaf()) {
+        WideNode<N>& root = wide.nodes[0];
+        for (uint32_t i = 0; i < N; ++i) {
+            root.lo_x[i] = root.lo_y[i] = root.lo_z[i] = HUGE_VALF;
+            root.hi_x[i] = root.hi_y[i] = root.hi_z[i] = -HUGE_VALF;
+            root.slot[i] = WideSlot::Leaf(0, 1);
+        }
+        root.lo_x[0] = binary[0].lo.x, root.lo_y[0] = binary[0].lo.y, root.lo_z[0] = binary[0].lo.z;
+        root.hi_x[0] = binary[0].hi.x, root.hi_y[0] = binary[0].hi.y, root.hi_z[0] = binary[0].hi.z;
+        root.slot[0] = make_slot(0, work);
+        root.child_mask = 1;
+        return wide;
+    }
+    work.push_back({ 0, 0 });
+    while (!work.empty()) {
+        auto [binary_index, wide_index] = work.back();
+        work.pop_back();
+
+        uint32_t children[N];
+        uint32_t count = 2;
+        children[0] = binary[binary_index].left_first;
+        children[1] = binary[binary_index].left_first + 1;
+        while (count < N) {
+            int32_t largest = -1;
+            float largest_area = -1;
+            for (uint32_t i = 0; i < count; ++i) {
+                const BvhNode& child = binary[children[i]];
+                if (!child.IsLeaf() && child.Bounds().HalfArea() > largest_area) {
+                    largest = int32_t(i);
+                    largest_area = child.Bounds().HalfArea();
+                }
+            }
+            if (largest < 0) {
+                break;
+            }
+            uint32_t opened = binary[children[largest]].left_first;
+            children[largest] = opened;
+            children[count++] = opened + 1;
+        }
+
+        WideNode<N> node;
+        for (uint32_t i = 0; i < N; ++i) {
+            if (i < count) {
+                const BvhNode& child = binary[children[i]];
+                node.lo_x[i] = child.lo.x, node.lo_y[i] = child.lo.y, node.lo_z[i] = child.lo.z;
+                node.hi_x[i] = child.hi.x, node.hi_y[i] = child.hi.y, node.hi_z[i] = child.hi.z;
+                node.slot[i] = make_slot(children[i], work);
+            } else {
+                node.lo_x[i] = node.lo_y[i] = node.lo_z[i] = HUGE_VALF;
+                node.hi_x[i] = node.hi_y[i] = node.hi_z[i] = -HUGE_VALF;
+                node.slot[i] = WideSlot::Leaf(0, 1); // never entered, child_mask leaves it out
+            }
+        }
+        node.child_mask = (1u << count) - 1;
+        wide.nodes[wide_index] = node; // after make_slot, which may have grown the vector
+    }
+    return wide;
+}
+
+template<uint32_t N>
+bool w::cpu::WideBvh<N>::HasKernel() noexcept
+{
+#if W_CPU_X86
+    return DetectSimdIsa() >= (N == 4 ? SimdIsa::SSE : SimdIsa::AVX2);
+#else
+    return false;
+#endif
+}
+
+template<uint32_t N>
+w::cpu::Hit w::cpu::WideBvh<N>::Trace(const Ray& ray) const noexcept
+{
+#if W_CPU_X86
+    if (HasKernel()) {
+        if constexpr (N == 4) {
+            return sse::TraceWide(*this, ray);
+        } else {
+            return avx2::TraceWide(*this, ray);
+        }
+    }
+#endif
+    return TraceWideBvh(*this, ray, ScalarBoxTest<N>);
+}
+
+template<uint32_t N>
+void w::cpu::WideBvh<N>::Trace(std::span<const Ray> rays, std::span<Hit> hits) const noexcept
+{
+    for (size_t i = 0; i < rays.size(); ++i) {
+        hits[i] = Trace(rays[i]);
+    }
+}
+
+template<uint32_t N>
+w::cpu::WideBvhStats w::cpu::WideBvh<N>::Stats() const noexcept
+{
+    WideBvhStats stats{ .node_count = uint32_t(nodes.size()), .node_bytes = nodes.size() * sizeof(WideNode<N>) };
+    for (const auto& node : nodes) {
+        for (uint32_t i = 0; i < N; ++i) {
+            bool used = node.child_mask >> i & 1;
+            stats.empty_slots += !used;
+            stats.leaf_slots += used && WideSlot::IsLeaf(node.slot[i]);
+        }
+    }
+    return stats;
+}
+
+template<uint32_t N>
+w::cpu::QuantizedBvh<N> w::cpu::QuantizedBvh<N>::Quantize(const WideBvh<N>& wide)
+{
+    QuantizedBvh quantized;
+    quantized.triangles = wide.triangles;
+    quantized.references = wide.references;
+    quantized.nodes.resize(wide.nodes.size());
+    for (size_t n = 0; n < wide.nodes.size(); ++n) {
+        const WideNode<N>& node = wide.nodes[n];
+        QuantizedNode<N> q{};
+        uint32_t count = uint32_t(std::popcount(node.child_mask)); // used slots are the first count
+        Aabb bounds;
+        for (uint32_t i = 0; i < count; ++i) {
+            bounds.Grow(float3{ node.lo_x[i], node.lo_y[i], node.lo_z[i] });
+            bounds.Grow(float3{ node.hi_x[i], node.hi_y[i], node.hi_z[i] });
+        }
+        q.child_mask = uint8_t(node.child_mask);
+        q.origin = count ? bounds.lo : float3{};
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            QuantizeAxis(node, count, axis, q);
+        }
+        for (uint32_t i = 0; i < N; ++i) {
+            q.slot[i] = node.slot[i];
+        }
+        quantized.nodes[n] = q;
+    }
+    return quantized;
+}
+
+template<uint32_t N>
+w::cpu::Hit w::cpu::QuantizedBvh<N>::Trace(const Ray& ray) const noexcept
+{
+#if W_CPU_X86
+    if (HasKernel()) {
+        if constexpr (N == 4) {
+            return sse::TraceWide(*this, ray);
+        } else {
+            return avx2::TraceWide(*this, ray);
+        }
+    }
+#endif
+    return TraceWideBvh(*this, ray, ScalarQuantizedBoxTest<N>);
+}
+
+template<uint32_t N>
+void w::cpu::QuantizedBvh<N>::Trace(std::span<const Ray> rays, std::span<Hit> hits) const noexcept
+{
+    for (size_t i = 0; i < rays.size(); ++i) {
+        hits[i] = Trace(rays[i]);
+    }
+}
+
+template<uint32_t N>
+w::cpu::WideBvhStats w::cpu::QuantizedBvh<N>::Stats() const noexcept
+{
+    WideBvhStats stats{ .node_count = uint32_t(nodes.size()), .node_bytes = nodes.size() * sizeof(QuantizedNode<N>) };
+    for (const auto& node : nodes) {
+        for (uint32_t i = 0; i < N; ++i) {
+            bool used = node.child_mask >> i & 1;
+            stats.empty_slots += !used;
+            stats.leaf_slots += used && WideSlot::IsLeaf(node.slot[i]);
+        }
+    }
+    return stats;
+}
+
+template class w::cpu::WideBvh<4>;
+template class w::cpu::WideBvh<8>;
+template class w::cpu::QuantizedBvh<4>;
+template class w::cpu::QuantizedBvh<8>;
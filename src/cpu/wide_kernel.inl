@@ -0,0 +1,150 @@
+// Wide BVH box test, compiled per instruction set: the including file defines W_SIMD_NS and W_WIDE_N.
+// The traversal itself is the shared one from wide_traversal.hpp, only the N children test is vectorized
+#include "wide_kernels.hpp"
+#include "wide_traversal.hpp"
+#include <immintrin.h>
+#include <cstring>
+
+namespace w::cpu::W_SIMD_NS {
+namespace {
+#if W_WIDE_N == 8
+using lanes = __m256;
+inline lanes Set(float f) noexcept
+{
+    return _mm256_set1_ps(f);
+}
+inline lanes Load(const float* p) noexcept
+{
+    return _mm256_load_ps(p);
+}
+inline lanes Sub(lanes a, lanes b) noexcept
+{
+    return _mm256_sub_ps(a, b);
+}
+inline lanes Mul(lanes a, lanes b) noexcept
+{
+    return _mm256_mul_ps(a, b);
+}
+inline lanes Min(lanes a, lanes b) noexcept
+{
+    return _mm256_min_ps(a, b);
+}
+inline lanes Max(lanes a, lanes b) noexcept
+{
+    return _mm256_max_ps(a, b);
+}
+inline void Store(float* p, lanes a) noexcept
+{
+    _mm256_store_ps(p, a);
+}
+inline uint32_t LessEqualBits(lanes a, lanes b) noexcept
+{
+    return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)));
+}
+inline lanes LoadBytes(const uint8_t* p) noexcept
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+inline lanes Add(lanes a, lanes b) noexcept
+{
+    return _mm256_add_ps(a, b);
+}
+#else
+using lanes = __m128;
+inline lanes Set(float f) noexcept
+{
+    return _mm_set1_ps(f);
+}
+inline lanes Load(const float* p) noexcept
+{
+    return _mm_load_ps(p);
+}
+inline lanes Sub(lanes a, lanes b) noexcept
+{
+    return _mm_sub_ps(a, b);
+}
+inline lanes Mul(lanes a, lanes b) noexcept
+{
+    return _mm_mul_ps(a, b);
+}
+inline lanes Min(lanes a, lanes b) noexcept
+{
+    return _mm_min_ps(a, b);
+}
+inline lanes Max(lanes a, lanes b) noexcept
+{
+    return _mm_max_ps(a, b);
+}
+inline void Store(float* p, lanes a) noexcept
+{
+    _mm_store_ps(p, a);
+}
+inline uint32_t LessEqualBits(lanes a, lanes b) noexcept
+{
+    return uint32_t(_mm_movemask_ps(_mm_cmple_ps(a, b)));
+}
+inline lanes LoadBytes(const uint8_t* p) noexcept
+{
+    int32_t bytes;
+    std::memcpy(&bytes, p, sizeof(bytes));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+}
+inline lanes Add(lanes a, lanes b) noexcept
+{
+    return _mm_add_ps(a, b);
+}
+#endif
+
+// same slab math as IntersectAabb, one lane per child
+struct BoxTest {
+    uint32_t operator()(const WideNode<W_WIDE_N>& node, float3 origin, float3 inv_dir, float t_min, float t_max,
+                        float* t_near) const noexcept
+    {
+        lanes ox = Set(origin.x), oy = Set(origin.y), oz = Set(origin.z);
+        lanes rx = Set(inv_dir.x), ry = Set(inv_dir.y), rz = Set(inv_dir.z);
+        lanes t0x = Mul(Sub(Load(node.lo_x), ox), rx);
+        lanes t1x = Mul(Sub(Load(node.hi_x), ox), rx);
+        lanes t0y = Mul(Sub(Load(node.lo_y), oy), ry);
+        lanes t1y = Mul(Sub(Load(node.hi_y), oy), ry);
+        lanes t0z = Mul(Sub(Load(node.lo_z), oz), rz);
+        lanes t1z = Mul(Sub(Load(node.hi_z), oz), rz);
+        lanes entry = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), Set(t_min)));
+        lanes exit = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), Set(t_max)));
+        Store(t_near, entry);
+        return LessEqualBits(entry, exit) & node.child_mask;
+    }
+};
+
+// decodes the children to float boxes, origin + q * scale like QuantizedNode::Decode, then the same slab test
+struct QuantizedBoxTest {
+    uint32_t operator()(const QuantizedNode<W_WIDE_N>& node, float3 origin, float3 inv_dir, float t_min, float t_max,
+                        float* t_near) const noexcept
+    {
+        lanes nx = Set(node.origin.x), ny = Set(node.origin.y), nz = Set(node.origin.z);
+        lanes sx = Set(node.Scale(0)), sy = Set(node.Scale(1)), sz = Set(node.Scale(2));
+        lanes ox = Set(origin.x), oy = Set(origin.y), oz = Set(origin.z);
+        lanes rx = Set(inv_dir.x), ry = Set(inv_dir.y), rz = Set(inv_dir.z);
+        lanes t0x = Mul(Sub(Add(nx, Mul(LoadBytes(node.lo_x), sx)), ox), rx);
+        lanes t1x = Mul(Sub(Add(nx, Mul(LoadBytes(node.hi_x), sx)), ox), rx);
+        lanes t0y = Mul(Sub(Add(ny, Mul(LoadBytes(node.lo_y), sy)), oy), ry);
+        lanes t1y = Mul(Sub(Add(ny, Mul(LoadBytes(node.hi_y), sy)), oy), ry);
+        lanes t0z = Mul(Sub(Add(nz, Mul(LoadBytes(node.lo_z), sz)), oz), rz);
+        lanes t1z = Mul(Sub(Add(nz, Mul(LoadBytes(node.hi_z), sz)), oz), rz);
+        lanes entry = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), Set(t_min)));
+        lanes exit = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), Set(t_max)));
+        Store(t_near, entry);
+        return LessEqualBits(entry, exit) & node.child_mask;
+    }
+};
+} // namespace
+
+Hit TraceWide(const WideBvh<W_WIDE_N>& bvh, const Ray& ray) noexcept
+{
+    return TraceWideBvh(bvh, ray, BoxTest{});
+}
+
+Hit TraceWide(const QuantizedBvh<W_WIDE_N>& bvh, const Ray& ray) noexcept
+{
+    return TraceWideBvh(bvh, ray, QuantizedBoxTest{});
+}
+} // namespace w::cpu::W_SIMD_NS
@@ -0,0 +1,19 @@
+#pragma once
+#include "ray.hpp"
+
+// entry points of the wide BVH kernels, built from wide_kernel.inl with their own flags
+namespace w::cpu {
+template<uint32_t N>
+class WideBvh;
+template<uint32_t N>
+class QuantizedBvh;
+
+namespace sse {
+Hit TraceWide(const WideBvh<4>& bvh, const Ray& ray) noexcept;
+Hit TraceWide(const QuantizedBvh<4>& bvh, const Ray& ray) noexcept;
+}
+namespace avx2 {
+Hit TraceWide(const WideBvh<8>& bvh, const Ray& ray) noexcept;
+Hit TraceWide(const QuantizedBvh<8>& bvh, const Ray& ray) noexcept;
+}
+} // namespace w::cpu
@@ -0,0 +1,3 @@
+#define W_SIMD_NS sse
+#define W_WIDE_N 4
+#include "wide_kernel.inl"
@@ -0,0 +1,69 @@
+#pragma once
+#include "wide_bvh.hpp"
+#include <bit>
+
+namespace w::cpu {
+// Closest hit through a WideBvh or QuantizedBvh, shared by the scalar path and the SIMD kernels. box_test(node, origin,
+// inv_dir, t_min, t_max, t_near) returns the bits of the children hit and writes their entry distances to t_near
+template<typename WideTree, typename BoxTest>
+Hit TraceWideBvh(const WideTree& bvh, const Ray& ray, BoxTest&& box_test) noexcept
+{
+    constexpr uint32_t N = WideTree::width;
+    Hit hit;
+    if (bvh.nodes.empty()) {
+        return hit;
+    }
+
+    struct Entry {
+        uint32_t slot;
+        float t_near;
+    };
+    Entry stack[traversal_stack_size * (N - 1)]; // a level pushes all but one child
+    uint32_t top = 0;
+
+    float3 inv_dir = SafeInverse(ray.dir);
+    Entry current{ 0, 0 }; // the root is inner node 0
+    while (true) {
+        if (WideSlot::IsLeaf(current.slot)) {
+            uint32_t first = WideSlot::First(current.slot);
+            for (uint32_t i = first; i < first + WideSlot::Count(current.slot); ++i) {
+                IntersectTriangle(ray, bvh.triangles[i], i, hit);
+            }
+        } else {
+            const auto& node = bvh.nodes[current.slot];
+            alignas(32) float t_near[N];
+            uint32_t mask = box_test(node, ray.origin, inv_dir, ray.t_min, std::min(hit.t, ray.t_max), t_near);
+            if (mask) {
+                // sorted along the ray: farthest entries go on the stack first, the closest is visited next
+                Entry sorted[N];
+                uint32_t count = 0;
+                for (; mask; mask &= mask - 1) {
+                    uint32_t i = uint32_t(std::countr_zero(mask));
+                    Entry entry{ node.slot[i], t_near[i] };
+                    uint32_t j = count++;
+                    for (; j > 0 && sorted[j - 1].t_near < entry.t_near; --j) {
+                        sorted[j] = sorted[j - 1];
+                    }
+                    sorted[j] = entry;
+                }
+                for (uint32_t i = 0; i + 1 < count; ++i) {
+                    stack[top++] = sorted[i];
+                }
+                current = sorted[count - 1];
+                continue;
+            }
+        }
+
+        // pop, skipping children a closer hit has since ruled out
+        do {
+            if (top == 0) {
+                if (!hit.Missed()) {
+                    hit.primitive = bvh.references[hit.primitive];
+                }
+                return hit;
+            }
+            current = stack[--top];
+        } while (current.t_near >= hit.t);
+    }
+}
+} // namespace w::cpu
@@ -0,0 +1,47 @@
+#include "dds.hpp"
+#include <cstring>
+
+std::optional<w::dds::Surface> w::dds::Parse(std::span<const std::byte> file)
+{
+    if (file.size() < data_offset) {
+        return std::nullopt;
+    }
+
+    uint32_t file_magic;
+    Header header;
+    HeaderDX10 header_dx10;
+    std::memcpy(&file_magic, file.data(), sizeof(file_magic));
+    std::memcpy(&header, file.data() + sizeof(file_magic), sizeof(header));
+    std::memcpy(&header_dx10, file.data() + sizeof(file_magic) + sizeof(header), sizeof(header_dx10));
+
+    // only what the cooker writes: single 2D textures in the DX10 layout
+    if (file_magic != magic || header.size != sizeof(Header) || header.pixel_format.four_cc != PixelFormat{}.four_cc ||
+        header_dx10.resource_dimension != HeaderDX10{}.resource_dimension || header_dx10.array_size != 1 || header.depth > 1) {
+        return std::nullopt;
+    }
+    switch (header_dx10.format) {
+    case Format::RGBA8Unorm:
+    case Format::BC4Unorm:
+    case Format::BC5Unorm:
+    case Format::BC7Unorm:
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    uint32_t mip_count = std::clamp(header.mip_map_count, 1u, MipCount(header.width, header.height));
+    Surface surface{
+        .format = header_dx10.format,
+        .width = header.width,
+        .height = header.height,
+        .mips = MipLayout(header_dx10.format, header.width, header.height, mip_count),
+    };
+
+    auto& last = surface.mips.back();
+    uint64_t size = last.offset + uint64_t(last.row_bytes) * last.rows;
+    if (header.width == 0 || header.height == 0 || size > file.size() - data_offset) {
+        return std::nullopt;
+    }
+    surface.data = file.subspan(data_offset, size);
+    return surface;
+}
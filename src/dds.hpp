@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Minimal DDS (DX10 extended header) container shared by the texture cooker and the runtime loader
+namespace w::dds {
+static constexpr uint32_t magic = 0x20534444; // "DDS "
+
+// DXGI_FORMAT values of the formats we cook
+enum class Format : uint32_t {
+    RGBA8Unorm = 28,
+    BC4Unorm = 80,
+    BC5Unorm = 83,
+    BC7Unorm = 98,
+};
+
+struct PixelFormat {
+    uint32_t size = sizeof(PixelFormat);
+    uint32_t flags = 0x4; // DDPF_FOURCC
+    uint32_t four_cc = 0x30315844; // "DX10"
+    uint32_t rgb_bit_count = 0;
+    uint32_t r_mask = 0;
+    uint32_t g_mask = 0;
+    uint32_t b_mask = 0;
+    uint32_t a_mask = 0;
+};
+
+struct Header {
+    uint32_t size = sizeof(Header);
+    uint32_t flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT
+    uint32_t height = 0;
+    uint32_t width = 0;
+    uint32_t pitch_or_linear_size = 0;
+    uint32_t depth = 0;
+    uint32_t mip_map_count = 0;
+    uint32_t reserved1[11]{};
+    PixelFormat pixel_format;
+    uint32_t caps = 0x1000 | 0x8 | 0x400000; // TEXTURE | COMPLEX | MIPMAP
+    uint32_t caps2 = 0;
+    uint32_t caps3 = 0;
+    uint32_t caps4 = 0;
+    uint32_t reserved2 = 0;
+};
+
+struct HeaderDX10 {
+    Format format = Format::RGBA8Unorm;
+    uint32_t resource_dimension = 3; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    uint32_t misc_flag = 0;
+    uint32_t array_size = 1;
+    uint32_t misc_flags2 = 0;
+};
+
+static_assert(sizeof(Header) == 124 && sizeof(HeaderDX10) == 20);
+static constexpr size_t data_offset = sizeof(uint32_t) + sizeof(Header) + sizeof(HeaderDX10);
+
+struct MipLevel {
+    uint64_t offset; // from the start of the surface data
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_bytes; // bytes per row of texels, or per row of 4x4 blocks
+    uint32_t rows; // texel rows, or block rows
+};
+
+struct Surface {
+    Format format = Format::RGBA8Unorm;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<MipLevel> mips;
+    std::span<const std::byte> data; // all mips, tightly packed
+};
+
+constexpr bool IsBlockCompressed(Format format) noexcept
+{
+    return format != Format::RGBA8Unorm;
+}
+constexpr uint32_t BytesPerBlock(Format format) noexcept
+{
+    switch (format) {
+    case Format::BC4Unorm:
+        return 8;
+    case Format::BC5Unorm:
+    case Format::BC7Unorm:
+        return 16;
+    default:
+        return 4; // per texel
+    }
+}
+constexpr uint32_t MipCount(uint32_t width, uint32_t height) noexcept
+{
+    uint32_t count = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        count++;
+    }
+    return count;
+}
+
+// Tightly packed layout of a full or partial mip chain, the same on disk and in the loader
+inline std::vector<MipLevel> MipLayout(Format format, uint32_t width, uint32_t height, uint32_t mip_count)
+{
+    std::vector<MipLevel> mips(mip_count);
+    uint64_t offset = 0;
+    for (auto& mip : mips) {
+        bool bc = IsBlockCompressed(format);
+        mip = {
+            .offset = offset,
+            .width = width,
+            .height = height,
+            .row_bytes = (bc ? (width + 3) / 4 : width) * BytesPerBlock(format),
+            .rows = bc ? (height + 3) / 4 : height,
+        };
+        offset += uint64_t(mip.row_bytes) * mip.rows;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return mips;
+}
+
+std::optional<Surface> Parse(std::span<const std::byte> file);
+} // namespace w::dds
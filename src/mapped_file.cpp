@@ -0,0 +1,114 @@
+#include "mapped_file.hpp"
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+w::MappedFile::MappedFile(const std::filesystem::path& p)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(p.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE xmapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // mapping keeps the file alive
+    if (!xmapping) {
+        return;
+    }
+
+    void* view = MapViewOfFile(xmapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(xmapping);
+        return;
+    }
+    mapping = xmapping;
+    data = static_cast<const std::byte*>(view);
+    size = size_t(file_size.QuadPart);
+#else
+    int fd = open(p.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        return;
+    }
+    data = static_cast<const std::byte*>(view);
+    size = size_t(st.st_size);
+#endif
+}
+
+void w::MappedFile::Prefetch(std::span<const std::byte> range) noexcept
+{
+    if (range.empty()) {
+        return;
+    }
+#if defined(_WIN32)
+    WIN32_MEMORY_RANGE_ENTRY entry{ const_cast<std::byte*>(range.data()), range.size() };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+#else
+    // madvise wants a page aligned start
+    static const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = uintptr_t(range.data()) & ~(page - 1);
+    uintptr_t end = uintptr_t(range.data()) + range.size();
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
+void w::MappedFile::Release() noexcept
+{
+    if (!data) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(const_cast<std::byte*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+uint64_t w::HashBytes(std::span<const std::byte> bytes) noexcept
+{
+    // FNV-1a over 8 byte words, the tail is folded in bytewise
+    constexpr uint64_t prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    size_t words = bytes.size() / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i * sizeof(uint64_t), sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (size_t i = words * sizeof(uint64_t); i < bytes.size(); ++i) {
+        hash = (hash ^ uint64_t(bytes[i])) * prime;
+    }
+    return hash ^ bytes.size();
+}
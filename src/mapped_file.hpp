@@ -0,0 +1,63 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace w {
+// Read-only memory mapping of a whole file, released on destruction
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const std::filesystem::path& p);
+    MappedFile(MappedFile&& other) noexcept
+        : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0))
+#if defined(_WIN32)
+        , mapping(std::exchange(other.mapping, nullptr))
+#endif
+    {
+    }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            Release();
+            data = std::exchange(other.data, nullptr);
+            size = std::exchange(other.size, 0);
+#if defined(_WIN32)
+            mapping = std::exchange(other.mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+    ~MappedFile()
+    {
+        Release();
+    }
+
+public:
+    explicit operator bool() const noexcept
+    {
+        return data != nullptr;
+    }
+    std::span<const std::byte> Bytes() const noexcept
+    {
+        return { data, size };
+    }
+    // asks the OS to start paging in a range of a mapping ahead of use
+    static void Prefetch(std::span<const std::byte> range) noexcept;
+
+private:
+    void Release() noexcept;
+
+private:
+    const std::byte* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    void* mapping = nullptr;
+#endif
+};
+
+uint64_t HashBytes(std::span<const std::byte> bytes) noexcept;
+} // namespace w
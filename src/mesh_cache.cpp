@@ -0,0 +1,130 @@
+#include "mesh_cache.hpp"
+#include <fstream>
+#include <cstring>
+
+namespace {
+constexpr uint64_t cache_alignment = 16;
+
+constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+template<typename T>
+bool InBounds(std::span<const std::byte> blob, uint64_t offset, uint64_t count) noexcept
+{
+    return offset % alignof(T) == 0 && offset <= blob.size() && count <= (blob.size() - offset) / sizeof(T);
+}
+
+template<typename T>
+std::span<const T> ViewAt(std::span<const std::byte> blob, uint64_t offset, uint64_t count) noexcept
+{
+    return { reinterpret_cast<const T*>(blob.data() + offset), size_t(count) };
+}
+} // namespace
+
+std::vector<std::byte> w::CookMesh(const w::MeshView& mesh, uint64_t content_hash)
+{
+    w::MeshCacheHeader header{
+        .content_hash = content_hash,
+        .vertex_count = uint32_t(mesh.positions.size()),
+        .index_bytes = uint32_t(mesh.indices.size()),
+        .submesh_count = uint32_t(mesh.submeshes.size()),
+    };
+
+    uint64_t offset = AlignUp(sizeof(header), cache_alignment);
+    auto place = [&offset](uint64_t& out_offset, uint64_t size_bytes) {
+        out_offset = offset;
+        offset = AlignUp(offset + size_bytes, cache_alignment);
+    };
+    place(header.positions_offset, mesh.positions.size_bytes());
+    place(header.normals_offset, mesh.normals.size_bytes());
+    place(header.texcoords_offset, mesh.texcoords.size_bytes());
+    place(header.tangents_offset, mesh.tangents.size_bytes());
+    place(header.indices_offset, mesh.indices.size_bytes());
+    place(header.submeshes_offset, mesh.submeshes.size_bytes());
+
+    std::vector<std::byte> blob(offset);
+    auto write = [&blob](uint64_t at, const void* data, size_t size_bytes) {
+        if (size_bytes) {
+            std::memcpy(blob.data() + at, data, size_bytes);
+        }
+    };
+    write(0, &header, sizeof(header));
+    write(header.positions_offset, mesh.positions.data(), mesh.positions.size_bytes());
+    write(header.normals_offset, mesh.normals.data(), mesh.normals.size_bytes());
+    write(header.texcoords_offset, mesh.texcoords.data(), mesh.texcoords.size_bytes());
+    write(header.tangents_offset, mesh.tangents.data(), mesh.tangents.size_bytes());
+    write(header.indices_offset, mesh.indices.data(), mesh.indices.size_bytes());
+    write(header.submeshes_offset, mesh.submeshes.data(), mesh.submeshes.size_bytes());
+    return blob;
+}
+
+std::optional<w::MeshView> w::ReadMeshCache(std::span<const std::byte> blob, std::optional<uint64_t> content_hash) noexcept
+{
+    w::MeshCacheHeader header;
+    if (blob.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, blob.data(), sizeof(header));
+
+    if (header.magic != w::MeshCacheHeader::magic_value ||
+        header.version != w::MeshCacheHeader::current_version ||
+        (content_hash && header.content_hash != *content_hash) ||
+        header.index_bytes % sizeof(uint32_t) != 0) {
+        return std::nullopt;
+    }
+
+    if (!InBounds<DirectX::XMFLOAT3>(blob, header.positions_offset, header.vertex_count) ||
+        !InBounds<DirectX::XMFLOAT3>(blob, header.normals_offset, header.vertex_count) ||
+        !InBounds<DirectX::XMFLOAT3>(blob, header.texcoords_offset, header.vertex_count) ||
+        !InBounds<DirectX::XMFLOAT3>(blob, header.tangents_offset, header.vertex_count) ||
+        !InBounds<uint32_t>(blob, header.indices_offset, header.index_bytes / sizeof(uint32_t)) ||
+        !InBounds<w::MeshSubmesh>(blob, header.submeshes_offset, header.submesh_count)) {
+        return std::nullopt;
+    }
+
+    auto submeshes = ViewAt<w::MeshSubmesh>(blob, header.submeshes_offset, header.submesh_count);
+    for (auto& submesh : submeshes) {
+        if ((submesh.index_type != w::IndexType::UInt16 && submesh.index_type != w::IndexType::UInt32) ||
+            submesh.index_offset % sizeof(uint32_t) != 0 ||
+            uint64_t(submesh.vertex_offset) + submesh.vertex_count > header.vertex_count ||
+            uint64_t(submesh.index_offset) + uint64_t(submesh.index_count) * submesh.IndexSize() > header.index_bytes) {
+            return std::nullopt;
+        }
+    }
+
+    return w::MeshView{
+        .positions = ViewAt<DirectX::XMFLOAT3>(blob, header.positions_offset, header.vertex_count),
+        .normals = ViewAt<DirectX::XMFLOAT3>(blob, header.normals_offset, header.vertex_count),
+        .texcoords = ViewAt<DirectX::XMFLOAT3>(blob, header.texcoords_offset, header.vertex_count),
+        .tangents = ViewAt<DirectX::XMFLOAT3>(blob, header.tangents_offset, header.vertex_count),
+        .indices = ViewAt<std::byte>(blob, header.indices_offset, header.index_bytes),
+        .submeshes = submeshes,
+    };
+}
+
+bool w::WriteMeshCache(const std::filesystem::path& p, std::span<const std::byte> blob)
+{
+    // write to a side file first, so a crash never leaves a truncated cache behind
+    auto temp_path = p;
+    temp_path += ".tmp";
+    {
+        std::ofstream out{ temp_path, std::ios::binary | std::ios::trunc };
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(blob.data()), std::streamsize(blob.size()));
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, p, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "mapped_file.hpp"
+#include <DirectXMath.h>
+#include <filesystem>
+#include <optional>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+namespace w {
+// values are the index size in bytes
+enum class IndexType : uint32_t {
+    UInt16 = 2,
+    UInt32 = 4,
+};
+
+struct MeshSubmesh {
+    uint32_t vertex_offset; // first vertex in the shared vertex arrays, indices are relative to it
+    uint32_t vertex_count;
+    uint32_t index_offset; // byte offset into the shared index arena, aligned to 4
+    uint32_t index_count;
+    uint32_t material_index;
+    w::IndexType index_type; // UInt16 whenever the submesh has at most 65536 vertices
+
+    uint32_t IndexSize() const noexcept
+    {
+        return uint32_t(index_type);
+    }
+};
+
+// Cooked mesh layout: header, then 16 byte aligned arrays addressed by byte offsets from the file start
+struct MeshCacheHeader {
+    static constexpr uint32_t magic_value = 0x48534d57; // "WMSH"
+    static constexpr uint32_t current_version = 3; // 3: triangles and vertices are stored optimized
+
+    uint32_t magic = magic_value;
+    uint32_t version = current_version;
+    uint64_t content_hash = 0; // hash of the source asset the cache was cooked from
+
+    uint32_t vertex_count = 0;
+    uint32_t index_bytes = 0; // size of the mixed 16/32 bit index arena
+    uint32_t submesh_count = 0;
+    uint32_t reserved = 0;
+
+    uint64_t positions_offset = 0;
+    uint64_t normals_offset = 0;
+    uint64_t texcoords_offset = 0;
+    uint64_t tangents_offset = 0;
+    uint64_t indices_offset = 0;
+    uint64_t submeshes_offset = 0;
+};
+
+// Non-owning view of mesh data, either freshly imported or pointing into a cooked blob
+struct MeshView {
+    std::span<const DirectX::XMFLOAT3> positions;
+    std::span<const DirectX::XMFLOAT3> normals;
+    std::span<const DirectX::XMFLOAT3> texcoords;
+    std::span<const DirectX::XMFLOAT3> tangents;
+    std::span<const std::byte> indices; // index arena, see w::MeshSubmesh for the layout
+    std::span<const w::MeshSubmesh> submeshes;
+};
+
+std::vector<std::byte> CookMesh(const w::MeshView& mesh, uint64_t content_hash);
+// content_hash is the source the cache must match, nullopt skips the check for caches cooked together with their source
+std::optional<w::MeshView> ReadMeshCache(std::span<const std::byte> blob, std::optional<uint64_t> content_hash) noexcept;
+bool WriteMeshCache(const std::filesystem::path& p, std::span<const std::byte> blob);
+} // namespace w
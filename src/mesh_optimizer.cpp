@@ -0,0 +1,253 @@
+#include "mesh_optimizer.hpp"
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+// spreads the low 10 bits so that two zero bits follow each of them
+uint32_t Part1By2(uint32_t x) noexcept
+{
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+} // namespace
+
+w::VertexCacheStats w::AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t cache_size)
+{
+    // timestamp FIFO: a vertex is in the cache if it was inserted less than cache_size misses ago
+    std::vector<uint32_t> inserted(vertex_count, 0);
+    std::vector<bool> referenced(vertex_count, false);
+    uint32_t misses = 0;
+    uint32_t unique = 0;
+
+    for (uint32_t index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            unique++;
+        }
+        if (misses + 1 - inserted[index] > cache_size || inserted[index] == 0) {
+            misses++;
+            inserted[index] = misses;
+        }
+    }
+
+    uint32_t triangles = uint32_t(indices.size() / 3);
+    return {
+        .acmr = triangles ? float(misses) / float(triangles) : 0.0f,
+        .atvr = unique ? float(misses) / float(unique) : 0.0f,
+    };
+}
+
+w::VertexFetchStats w::AnalyzeVertexFetch(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t vertex_stride)
+{
+    constexpr uint32_t line_size = 64;
+    constexpr uint32_t line_count = 256; // 16 KB, roughly one L1 worth of vertex data
+    std::vector<uint64_t> lines(line_count, ~uint64_t(0));
+    std::vector<bool> referenced(vertex_count, false);
+    uint64_t fetched = 0;
+    uint64_t unique = 0;
+
+    for (uint32_t index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            unique++;
+        }
+        uint64_t first = uint64_t(index) * vertex_stride / line_size;
+        uint64_t last = (uint64_t(index) * vertex_stride + vertex_stride - 1) / line_size;
+        for (uint64_t line = first; line <= last; ++line) {
+            uint64_t& slot = lines[line % line_count];
+            if (slot != line) {
+                slot = line;
+                fetched += line_size;
+            }
+        }
+    }
+    return { .overfetch = unique ? float(fetched) / float(unique * vertex_stride) : 0.0f };
+}
+
+void w::OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertex_count, uint32_t cache_size)
+{
+    uint32_t triangles = uint32_t(indices.size() / 3);
+    if (triangles < 2) {
+        return;
+    }
+
+    // vertex -> triangle adjacency
+    std::vector<uint32_t> live(vertex_count, 0); // triangles not emitted yet per vertex
+    for (uint32_t index : indices) {
+        live[index]++;
+    }
+    std::vector<uint32_t> first(vertex_count + 1, 0);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+        first[v + 1] = first[v] + live[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<uint32_t> inserted(vertex_count, 0); // FIFO timestamps, same model as AnalyzeVertexCache
+    std::vector<bool> emitted(triangles, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    uint32_t time = cache_size + 1;
+    uint32_t cursor = 0; // next vertex to try when every candidate and dead end is exhausted
+
+    auto in_cache = [&](uint32_t v) { return time - inserted[v] <= cache_size; };
+    auto next_fan = [&]() -> uint32_t {
+        // prefer a cached vertex whose remaining triangles still fit before it gets evicted
+        uint32_t best = vertex_count;
+        uint32_t best_priority = 0;
+        for (uint32_t v : candidates) {
+            if (!live[v]) {
+                continue;
+            }
+            uint32_t priority = 1;
+            if (time - inserted[v] + 2 * live[v] <= cache_size) {
+                priority = time - inserted[v] + 1;
+            }
+            if (best == vertex_count || priority > best_priority) {
+                best = v;
+                best_priority = priority;
+            }
+        }
+        if (best != vertex_count) {
+            return best;
+        }
+        while (!dead_end.empty()) {
+            uint32_t v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v]) {
+                return v;
+            }
+        }
+        for (; cursor < vertex_count; ++cursor) {
+            if (live[cursor]) {
+                return cursor;
+            }
+        }
+        return vertex_count;
+    };
+
+    for (uint32_t fan = indices[0]; fan != vertex_count; fan = next_fan()) {
+        candidates.clear();
+        for (uint32_t a = first[fan]; a < first[fan + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                result.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (!in_cache(v)) {
+                    inserted[v] = time++;
+                }
+            }
+        }
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void w::OptimizeSpatialOrder(std::span<uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions, uint32_t cache_size)
+{
+    using namespace DirectX;
+    constexpr uint32_t min_cluster = 32; // triangles, keeps tiny clusters from fragmenting the cache order
+    uint32_t triangles = uint32_t(indices.size() / 3);
+    if (triangles < 2) {
+        return;
+    }
+
+    // clusters start where a triangle misses the cache with all three vertices
+    std::vector<uint32_t> cluster_start;
+    {
+        std::vector<uint32_t> inserted(positions.size(), 0);
+        uint32_t time = cache_size + 1;
+        for (uint32_t t = 0; t < triangles; ++t) {
+            uint32_t misses = 0;
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                if (time - inserted[v] > cache_size) {
+                    inserted[v] = time++;
+                    misses++;
+                }
+            }
+            if (cluster_start.empty() || (misses == 3 && t - cluster_start.back() >= min_cluster)) {
+                cluster_start.push_back(t);
+            }
+        }
+        cluster_start.push_back(triangles);
+    }
+
+    XMVECTOR lo = XMVectorReplicate(FLT_MAX);
+    XMVECTOR hi = XMVectorReplicate(-FLT_MAX);
+    for (uint32_t index : indices) {
+        XMVECTOR p = XMLoadFloat3(&positions[index]);
+        lo = XMVectorMin(lo, p);
+        hi = XMVectorMax(hi, p);
+    }
+    // quantize centroids to a 1024^3 grid over the bounds, flat axes map to 0
+    XMVECTOR extent = XMVectorSubtract(hi, lo);
+    XMVECTOR scale = XMVectorSelect(XMVectorDivide(XMVectorReplicate(1023.0f), extent), XMVectorZero(), XMVectorLessOrEqual(extent, XMVectorZero()));
+
+    size_t clusters = cluster_start.size() - 1;
+    std::vector<std::pair<uint32_t, uint32_t>> keys(clusters); // morton code, cluster
+    for (size_t c = 0; c < clusters; ++c) {
+        XMVECTOR centroid = XMVectorZero();
+        for (uint32_t i = cluster_start[c] * 3; i < cluster_start[c + 1] * 3; ++i) {
+            centroid = XMVectorAdd(centroid, XMLoadFloat3(&positions[indices[i]]));
+        }
+        centroid = XMVectorScale(centroid, 1.0f / float((cluster_start[c + 1] - cluster_start[c]) * 3));
+        XMFLOAT3 cell;
+        XMStoreFloat3(&cell, XMVectorMultiply(XMVectorSubtract(centroid, lo), scale));
+        uint32_t code = Part1By2(uint32_t(cell.x)) | (Part1By2(uint32_t(cell.y)) << 1) | (Part1By2(uint32_t(cell.z)) << 2);
+        keys[c] = { code, uint32_t(c) };
+    }
+    std::sort(keys.begin(), keys.end()); // ties keep source order
+
+    std::vector<uint32_t> original(indices.begin(), indices.end());
+    auto out = indices.begin();
+    for (auto [code, c] : keys) {
+        out = std::copy(original.begin() + cluster_start[c] * 3, original.begin() + cluster_start[c + 1] * 3, out);
+    }
+}
+
+std::vector<uint32_t> w::OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertex_count)
+{
+    constexpr uint32_t unassigned = ~0u;
+    std::vector<uint32_t> remap(vertex_count, unassigned);
+    uint32_t next = 0;
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    for (uint32_t& slot : remap) {
+        if (slot == unassigned) {
+            slot = next++;
+        }
+    }
+    return remap;
+}
+
+void w::OptimizeMesh(std::span<uint32_t> indices, std::span<DirectX::XMFLOAT3> positions, std::span<const std::span<DirectX::XMFLOAT3>> attributes)
+{
+    w::OptimizeVertexCache(indices, uint32_t(positions.size()));
+    w::OptimizeSpatialOrder(indices, positions);
+    auto remap = w::OptimizeVertexFetch(indices, uint32_t(positions.size()));
+    w::RemapVertices(positions, remap);
+    for (auto stream : attributes) {
+        w::RemapVertices(stream, remap);
+    }
+}
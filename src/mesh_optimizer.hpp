@@ -0,0 +1,46 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace w {
+// Post-transform cache behaviour of an index stream, simulated on a FIFO cache
+struct VertexCacheStats {
+    float acmr = 0; // transformed vertices per triangle, 3 is the worst case
+    float atvr = 0; // transformed vertices per referenced vertex, 1 is ideal
+};
+
+// Memory traffic of vertex fetch, simulated on a direct mapped cache of 64 byte lines
+struct VertexFetchStats {
+    float overfetch = 0; // bytes pulled from memory per byte of referenced vertex data, 1 is ideal
+};
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t cache_size = 16);
+VertexFetchStats AnalyzeVertexFetch(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t vertex_stride);
+
+// Reorders triangles for the post-transform cache (Tipsify, Sander et al. 2007)
+void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertex_count, uint32_t cache_size = 16);
+
+// Cuts the stream into clusters where the vertex cache runs cold and sorts the clusters along a Morton curve
+// through their centroids. Run after OptimizeVertexCache, triangle order inside a cluster is kept.
+void OptimizeSpatialOrder(std::span<uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions, uint32_t cache_size = 16);
+
+// Renumbers vertices in order of first use and rewrites the indices, returns the old -> new mapping.
+// Unreferenced vertices are moved to the end.
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertex_count);
+
+// The whole pass over one submesh: vertex cache order, spatial cluster order, then first use vertex order
+// applied to positions and every attribute stream
+void OptimizeMesh(std::span<uint32_t> indices, std::span<DirectX::XMFLOAT3> positions, std::span<const std::span<DirectX::XMFLOAT3>> attributes);
+
+// Applies a mapping from OptimizeVertexFetch to one vertex stream in place
+template<typename T>
+void RemapVertices(std::span<T> vertices, std::span<const uint32_t> remap)
+{
+    std::vector<T> original(vertices.begin(), vertices.end());
+    for (size_t i = 0; i < original.size(); ++i) {
+        vertices[remap[i]] = original[i];
+    }
+}
+} // namespace w
@@ -1,55 +1,97 @@
 #include "model.hpp"
 #include "model_loader.hpp"
 #include "graphics.hpp"
-
-w::Model::Model(w::Graphics& gfx)
+#include "upload_context.hpp"
+#include "worker_pool.hpp"
+#include "consts.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+w::Model::Model(w::Graphics& gfx, w::UploadContext& upload, const w::AssetPack& assets)
 {
     using namespace wis;
+    using clock = std::chrono::steady_clock;
     wis::Result res = wis::success;
-    w::ModelLoader mesh("assets/SnowmanOBJ.obj");
-    const wis::ResourceAllocator& alloc = gfx.GetAllocator();
-    auto& device = gfx.GetDevice();
-    auto& queue = gfx.GetMainQueue();
 
-    auto cmd_list = device.CreateCommandList(res, wis::QueueType::Graphics);
-    auto fence = device.CreateFence(res);
-
-    index_buffer = alloc.CreateBuffer(res, mesh.indices.size() * sizeof(uint16_t), wis::BufferUsage::IndexBuffer | wis::BufferUsage::CopyDst | wis::BufferUsage::AccelerationStructureInput);
-    vertex_buffer = alloc.CreateBuffer(res, mesh.vertices.size() * sizeof(DirectX::XMFLOAT3), wis::BufferUsage::VertexBuffer | wis::BufferUsage::CopyDst | wis::BufferUsage::AccelerationStructureInput);
-    normal_buffer = alloc.CreateBuffer(res, mesh.normals.size() * sizeof(DirectX::XMFLOAT3), wis::BufferUsage::VertexBuffer | wis::BufferUsage::CopyDst);
+    // reserve staging memory and kick off texture decoding first, decoders write straight into the staging memory
+    // and overlap with the mesh load and recording of the geometry upload and BLAS build
+    struct TextureJob {
+        w::Texture* texture;
+        const char* path;
+        w::ImageSource source;
+        std::vector<w::StagedMip> staged;
+        std::future<bool> decoded;
+        std::chrono::duration<double, std::milli> decode_time{};
+    } texture_jobs[]{
+        { &diffuse, "assets/Snowman_C.png" },
+        { &normal, "assets/Snowman_NM.png" },
+        { &specular, "assets/Snowman_S.png" },
+        { &emissive, "assets/Snowman_Emessive.png" },
+    };
 
-    if (res.status != wis::success.status) {
-        throw std::runtime_error("Failed to create buffers");
+    w::WorkerPool pool{ uint32_t(std::size(texture_jobs)) };
+    for (auto& job : texture_jobs) {
+        job.source = w::ImageSource::Open(assets, job.path);
+        job.staged = job.texture->Stage(gfx, upload, job.source);
+        job.decoded = pool.Submit([&job]() {
+            auto start = clock::now();
+            bool decoded = w::Texture::Decode(job.source, job.staged);
+            job.decode_time = clock::now() - start;
+            return decoded;
+        });
     }
 
-    // allocate staging buffer
-    uint64_t max_size = mesh.indices.size() * sizeof(uint16_t) + mesh.vertices.size() * sizeof(DirectX::XMFLOAT3) + mesh.normals.size() * sizeof(DirectX::XMFLOAT3);
+    w::ModelLoader mesh(assets, "assets/SnowmanOBJ.obj");
+    const wis::ResourceAllocator& alloc = gfx.GetAllocator();
+    auto& cmd_list = upload.GetCommandList();
+
+    // quantized positions are snorm16 relative to the mesh bounds, normals, tangents and uvs are packed together
+    constexpr uint32_t vertex_stride = w::quantized_vertices ? sizeof(w::PackedPosition) : sizeof(DirectX::XMFLOAT3);
+    constexpr uint32_t normal_stride = w::quantized_vertices ? sizeof(w::PackedAttributes) : sizeof(DirectX::XMFLOAT3);
+    uint64_t index_bytes = mesh.index_data.size_bytes();
+    uint64_t vertex_bytes = mesh.vertices.size() * vertex_stride;
+    uint64_t normal_bytes = mesh.normals.size() * normal_stride;
+
+    index_buffer = alloc.CreateBuffer(res, index_bytes, wis::BufferUsage::IndexBuffer | wis::BufferUsage::CopyDst | wis::BufferUsage::AccelerationStructureInput);
+    vertex_buffer = alloc.CreateBuffer(res, vertex_bytes, wis::BufferUsage::VertexBuffer | wis::BufferUsage::CopyDst | wis::BufferUsage::AccelerationStructureInput);
+    normal_buffer = alloc.CreateBuffer(res, normal_bytes, wis::BufferUsage::VertexBuffer | wis::BufferUsage::CopyDst);
 
-    wis::Buffer staging = alloc.CreateUploadBuffer(res, max_size);
     if (res.status != wis::success.status) {
-        throw std::runtime_error("Failed to create staging buffer");
+        throw std::runtime_error("Failed to create buffers");
     }
 
-    // copy data to staging buffer
-    uint16_t* indices = staging.Map<uint16_t>();
-    std::copy_n(mesh.indices.data(), mesh.indices.size(), indices);
-
-    DirectX::XMFLOAT3* vertices = (DirectX::XMFLOAT3*)(indices + mesh.indices.size());
-    // scale vertices
-    DirectX::XMVECTOR scale = DirectX::XMVectorSet(0.01f, -0.01f, 0.01f, 1);
-    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
-        DirectX::XMVECTOR v = DirectX::XMLoadFloat3(&mesh.vertices[i]);
-        v = DirectX::XMVectorMultiply(v, scale);
-        DirectX::XMStoreFloat3(&vertices[i], v);
+    // copy data to staging memory, the index arena is already packed per submesh
+    auto staging_indices = upload.Allocate(index_bytes);
+    std::memcpy(staging_indices.data, mesh.index_data.data(), index_bytes);
+
+    auto staging_vertices = upload.Allocate(vertex_bytes);
+    auto staging_normals = upload.Allocate(normal_bytes);
+    if constexpr (w::quantized_vertices) {
+        // the scale goes to the instance transform together with the dequantization
+        bounds = w::QuantizationBounds::FromPoints(mesh.vertices);
+        auto* positions = (w::PackedPosition*)staging_vertices.data;
+        auto* attributes = (w::PackedAttributes*)staging_normals.data;
+        for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+            positions[i] = w::PackPosition(mesh.vertices[i], bounds);
+            attributes[i] = w::PackAttributes(mesh.normals[i], mesh.tangents[i], mesh.texcoords[i]);
+        }
+    } else {
+        DirectX::XMFLOAT3* vertices = (DirectX::XMFLOAT3*)staging_vertices.data;
+        // scale vertices
+        DirectX::XMVECTOR scale = DirectX::XMVectorSet(0.01f, -0.01f, 0.01f, 1);
+        for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+            DirectX::XMVECTOR v = DirectX::XMLoadFloat3(&mesh.vertices[i]);
+            v = DirectX::XMVectorMultiply(v, scale);
+            DirectX::XMStoreFloat3(&vertices[i], v);
+        }
+        std::memcpy(staging_normals.data, mesh.normals.data(), normal_bytes);
     }
 
-    DirectX::XMFLOAT3* normals = (DirectX::XMFLOAT3*)(vertices + mesh.vertices.size());
-    std::copy_n(mesh.normals.data(), mesh.normals.size(), normals);
-
-    staging.Unmap();
-    cmd_list.CopyBuffer(staging, index_buffer, { .size_bytes = mesh.indices.size() * sizeof(uint16_t) });
-    cmd_list.CopyBuffer(staging, vertex_buffer, { .src_offset = mesh.indices.size() * sizeof(uint16_t), .size_bytes = mesh.vertices.size() * sizeof(DirectX::XMFLOAT3) });
-    cmd_list.CopyBuffer(staging, normal_buffer, { .src_offset = mesh.indices.size() * sizeof(uint16_t) + mesh.vertices.size() * sizeof(DirectX::XMFLOAT3), .size_bytes = mesh.normals.size() * sizeof(DirectX::XMFLOAT3) });
+    upload.CopyBuffer(staging_indices, index_buffer);
+    upload.CopyBuffer(staging_vertices, vertex_buffer);
+    upload.CopyBuffer(staging_normals, normal_buffer);
 
     // slap barriers
     // clang-format off
@@ -79,37 +121,33 @@ w::Model::Model(w::Graphics& gfx)
     // clang-format on
     cmd_list.BufferBarriers(barriers, std::size(barriers));
 
-    // could have loaded it on separate thread but this is fine for now
-    diffuse.Load(gfx, "assets/Snowman_C.png");
-    normal.Load(gfx, "assets/Snowman_NM.png");
-    specular.Load(gfx, "assets/Snowman_S.png");
-    emissive.Load(gfx, "assets/Snowman_Emessive.png");
-
-    diffuse_srv = diffuse.CreateSrv(gfx);
-    normal_srv = normal.CreateSrv(gfx);
-    specular_srv = specular.CreateSrv(gfx);
-    emissive_srv = emissive.CreateSrv(gfx);
-
     // create blas
     auto& rt = gfx.GetRaytracing();
 
-    AcceleratedGeometryInput blas_input{
-        .geometry_type = ASGeometryType::Triangles,
-        .flags = ASGeometryFlags::Opaque,
-        .vertex_or_aabb_buffer_address = vertex_buffer.GetGPUAddress(),
-        .vertex_or_aabb_buffer_stride = sizeof(DirectX::XMFLOAT3),
-        .index_buffer_address = index_buffer.GetGPUAddress(),
-        .vertex_count = uint32_t(mesh.vertices.size()),
-        .triangle_or_aabb_count = uint32_t(mesh.indices.size() / 3),
-        .vertex_format = wis::DataFormat::RGB32Float,
-        .index_format = wis::IndexType::UInt16,
-    };
-    auto geometry_desc = wis::CreateGeometryDesc(blas_input);
+    // one geometry per submesh, each with its own index width.
+    // RGBA16Snorm is a required BLAS vertex format on both backends, the w component is ignored
+    constexpr wis::DataFormat vertex_format = w::quantized_vertices ? wis::DataFormat::RGBA16Snorm : wis::DataFormat::RGB32Float;
+    std::vector<wis::AcceleratedGeometryDesc> geometry_descs;
+    geometry_descs.reserve(mesh.submeshes.size());
+    for (auto& submesh : mesh.submeshes) {
+        AcceleratedGeometryInput blas_input{
+            .geometry_type = ASGeometryType::Triangles,
+            .flags = ASGeometryFlags::Opaque,
+            .vertex_or_aabb_buffer_address = vertex_buffer.GetGPUAddress() + submesh.vertex_offset * vertex_stride,
+            .vertex_or_aabb_buffer_stride = vertex_stride,
+            .index_buffer_address = index_buffer.GetGPUAddress() + submesh.index_offset,
+            .vertex_count = submesh.vertex_count,
+            .triangle_or_aabb_count = submesh.index_count / 3,
+            .vertex_format = vertex_format,
+            .index_format = submesh.index_type == w::IndexType::UInt16 ? wis::IndexType::UInt16 : wis::IndexType::UInt32,
+        };
+        geometry_descs.push_back(wis::CreateGeometryDesc(blas_input));
+    }
 
     wis::BottomLevelASBuildDesc blas_desc{
         .flags = wis::AccelerationStructureFlags::PreferFastTrace,
-        .geometry_count = 1,
-        .geometry_array = &geometry_desc,
+        .geometry_count = uint32_t(geometry_descs.size()),
+        .geometry_array = geometry_descs.data(),
     };
     auto alloc_info = rt.GetBottomLevelASSize(blas_desc);
     auto scratch = alloc.CreateBuffer(res, alloc_info.scratch_size, wis::BufferUsage::StorageBuffer);
@@ -119,12 +157,37 @@ w::Model::Model(w::Graphics& gfx)
 
     // build blas
     rt.BuildBottomLevelAS(cmd_list, blas_desc, blas, scratch.GetGPUAddress());
+    upload.Retain(std::move(scratch));
+
+    // GPU work stays on this thread, copies are recorded as soon as each decode is done
+    std::chrono::duration<double, std::milli> blocked{};
+    for (auto& job : texture_jobs) {
+        auto wait_start = clock::now();
+        bool decoded = job.decoded.get();
+        blocked += clock::now() - wait_start;
+        job.texture->Upload(upload, job.staged, decoded);
+    }
 
-    cmd_list.Close();
-    wis::CommandListView lists[] = { cmd_list };
-    queue.ExecuteCommandLists(lists, 1);
-    res = queue.SignalQueue(fence, 1);
-    res = fence.Wait(1);
+    diffuse_srv = diffuse.CreateSrv(gfx);
+    normal_srv = normal.CreateSrv(gfx);
+    specular_srv = specular.CreateSrv(gfx);
+    emissive_srv = emissive.CreateSrv(gfx);
+
+    std::chrono::duration<double, std::milli> serial{};
+    for (auto& job : texture_jobs) {
+        serial += job.decode_time;
+    }
+    std::cout << "Texture decode: " << serial.count() << " ms serial, " << blocked.count() << " ms blocking, "
+              << (serial - blocked).count() << " ms saved\n";
+}
+
+std::array<std::array<float, 4>, 3> w::Model::GetTransform() const noexcept
+{
+    if constexpr (!w::quantized_vertices) {
+        return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } }; // scale is baked into the vertices
+    }
+    // snorm -> object space, then the same scale the float path bakes in
+    return w::DequantizeTransform(bounds, { 0.01f, -0.01f, 0.01f });
 }
 
 void w::Model::Bind(wis::DescriptorStorage& storage) const
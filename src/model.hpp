@@ -1,14 +1,18 @@
 #pragma once
 #include "texture.hpp"
+#include "vertex_format.hpp"
+#include <array>
 #include <wisdom/wisdom_raytracing.hpp>
 
 
 namespace w {
 class Graphics;
+class UploadContext;
+class AssetPack;
 class Model
 {
 public:
-    Model(w::Graphics& gfx);
+    Model(w::Graphics& gfx, w::UploadContext& upload, const w::AssetPack& assets); // records uploads and the BLAS build, submission is up to the caller
 
 public:
     void Bind(wis::DescriptorStorage& storage) const;
@@ -16,6 +20,7 @@ public:
     {
         return blas;
     }
+    std::array<std::array<float, 4>, 3> GetTransform() const noexcept; // object to world rows for the TLAS instance
 
 private:
     w::Texture diffuse;
@@ -32,7 +37,8 @@ private:
     wis::Buffer instance_buffer;
 
     wis::Buffer vertex_buffer;
-    wis::Buffer normal_buffer;
+    wis::Buffer normal_buffer; // float3 normals, or PackedAttributes with quantized vertices
     wis::Buffer index_buffer;
+    w::QuantizationBounds bounds; // dequantization of vertex_buffer, folded into the instance transform
 };
 } // namespace w
\ No newline at end of file
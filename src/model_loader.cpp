@@ -1,38 +1,192 @@
 #include <assimp/Importer.hpp>
+#include <assimp/config.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "model_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
 w::ModelLoader::ModelLoader(std::filesystem::path p)
+{
+    Load(p);
+}
+
+w::ModelLoader::ModelLoader(const w::AssetPack& pack, std::filesystem::path p)
+{
+    // the source is not shipped next to the pack, so the cache is checked against the hash the packer recorded instead.
+    // Verify reads the whole blob, which the upload touches right after anyway
+    auto name = p.generic_string() + ".mesh";
+    pack.Prefetch(name);
+    if (auto view = pack.Verify(name) ? w::ReadMeshCache(pack.Find(name), std::nullopt) : std::nullopt) {
+        SetView(*view);
+        return;
+    }
+    Load(p);
+}
+
+void w::ModelLoader::Load(const std::filesystem::path& p)
+{
+    uint64_t content_hash = 0;
+    {
+        w::MappedFile source{ p };
+        if (!source) {
+            throw std::runtime_error("Failed to open model: " + p.string());
+        }
+        content_hash = w::HashBytes(source.Bytes());
+    }
+
+    auto cache_path = p;
+    cache_path += ".mesh";
+
+    mapping = w::MappedFile{ cache_path };
+    if (mapping) {
+        if (auto view = w::ReadMeshCache(mapping.Bytes(), content_hash)) {
+            SetView(*view);
+            return;
+        }
+        mapping = {}; // stale or foreign cache, recook
+    }
+
+    cooked = Import(p, content_hash);
+    if (w::WriteMeshCache(cache_path, cooked)) {
+        mapping = w::MappedFile{ cache_path };
+        if (mapping) {
+            if (auto view = w::ReadMeshCache(mapping.Bytes(), content_hash)) {
+                cooked = {};
+                SetView(*view);
+                return;
+            }
+        }
+        mapping = {};
+    }
+    SetView(*w::ReadMeshCache(cooked, content_hash));
+}
+
+std::vector<std::byte> w::ModelLoader::Import(const std::filesystem::path& p, uint64_t content_hash)
 {
     auto path_str = p.string();
     Assimp::Importer imp;
-    scene = imp.ReadFile(path_str.c_str(),
-                         aiProcess_Triangulate |
-                                 aiProcess_JoinIdenticalVertices |
-                                 aiProcess_ConvertToLeftHanded |
-                                 aiProcess_GenNormals |
-                                 aiProcess_CalcTangentSpace);
-
-    scene = imp.GetOrphanedScene();
-    vertices = { (DirectX::XMFLOAT3*)scene->mMeshes[0]->mVertices, scene->mMeshes[0]->mNumVertices };
-    normals = { (DirectX::XMFLOAT3*)scene->mMeshes[0]->mNormals, scene->mMeshes[0]->mNumVertices };
-    texcoords = { (DirectX::XMFLOAT3*)scene->mMeshes[0]->mTextureCoords[0], scene->mMeshes[0]->mNumVertices };
-    indices.reserve(scene->mMeshes[0]->mNumFaces * 3);
-    for (size_t i = 0; i < scene->mMeshes[0]->mNumFaces; ++i) {
-        auto& face = scene->mMeshes[0]->mFaces[i];
-        for (size_t j = 0; j < face.mNumIndices; ++j) {
-            indices.push_back(face.mIndices[j]);
+    // points and lines are dropped, every mesh left is triangles only
+    imp.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+    const aiScene* scene = imp.ReadFile(path_str.c_str(),
+                                        aiProcess_Triangulate |
+                                                aiProcess_SortByPType |
+                                                aiProcess_JoinIdenticalVertices |
+                                                aiProcess_ConvertToLeftHanded |
+                                                aiProcess_GenNormals |
+                                                aiProcess_CalcTangentSpace);
+    if (!scene || !scene->mNumMeshes) {
+        throw std::runtime_error("Failed to import model: " + path_str);
+    }
+
+    // pack all meshes into one arena, indices stay relative to the submesh so small submeshes keep 16 bit indices
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<DirectX::XMFLOAT3> normals;
+    std::vector<DirectX::XMFLOAT3> texcoords;
+    std::vector<DirectX::XMFLOAT3> tangents;
+    std::vector<std::byte> indices;
+    std::vector<w::MeshSubmesh> submeshes;
+    submeshes.reserve(scene->mNumMeshes);
+
+    auto append = [](std::vector<DirectX::XMFLOAT3>& out, const aiVector3D* in, uint32_t count) {
+        if (in) {
+            out.insert(out.end(), (const DirectX::XMFLOAT3*)in, (const DirectX::XMFLOAT3*)in + count);
+        } else {
+            out.resize(out.size() + count, DirectX::XMFLOAT3{}); // not uv mapped, keep the arrays dense
+        }
+    };
+    auto emit_indices = []<typename T>(std::vector<std::byte>& out, std::span<const uint32_t> in, T) {
+        size_t at = out.size();
+        out.resize(at + in.size() * sizeof(T));
+        T* dst = reinterpret_cast<T*>(out.data() + at);
+        for (uint32_t index : in) {
+            *dst++ = T(index);
+        }
+        return uint32_t(in.size());
+    };
+
+    // triangle count weighted statistics over all submeshes, reported before and after optimization
+    struct {
+        double acmr = 0;
+        double overfetch = 0;
+        void Add(std::span<const uint32_t> indices, uint32_t vertex_count)
+        {
+            acmr += w::AnalyzeVertexCache(indices, vertex_count).acmr * indices.size() / 3;
+            overfetch += w::AnalyzeVertexFetch(indices, vertex_count, sizeof(DirectX::XMFLOAT3)).overfetch * indices.size() / 3;
+        }
+    } before, after;
+    size_t triangle_count = 0;
+    std::vector<uint32_t> local_indices;
+
+    for (uint32_t m = 0; m < scene->mNumMeshes; ++m) {
+        const aiMesh* mesh = scene->mMeshes[m];
+        if (!mesh->mNumVertices || !mesh->mNumFaces || !(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)) {
+            continue;
+        }
+
+        w::MeshSubmesh& submesh = submeshes.emplace_back(w::MeshSubmesh{
+                .vertex_offset = uint32_t(positions.size()),
+                .vertex_count = mesh->mNumVertices,
+                .index_offset = uint32_t(indices.size()),
+                .material_index = mesh->mMaterialIndex,
+                .index_type = mesh->mNumVertices <= 0x10000 ? w::IndexType::UInt16 : w::IndexType::UInt32,
+        });
+
+        append(positions, mesh->mVertices, mesh->mNumVertices);
+        append(normals, mesh->mNormals, mesh->mNumVertices);
+        append(texcoords, mesh->mTextureCoords[0], mesh->mNumVertices);
+        append(tangents, mesh->mTangents, mesh->mNumVertices);
+
+        // the index buffer is a triangle list, a face of any other size that got through would shift every triangle after it
+        local_indices.clear();
+        for (size_t i = 0; i < mesh->mNumFaces; ++i) {
+            auto& face = mesh->mFaces[i];
+            if (face.mNumIndices == 3) {
+                local_indices.insert(local_indices.end(), face.mIndices, face.mIndices + 3);
+            }
         }
+
+        // spatially coherent triangles make the BLAS build and hit shading walk memory in order,
+        // first use vertex order then keeps attribute fetch of neighbouring triangles on the same cache lines
+        auto submesh_vertices = [&](std::vector<DirectX::XMFLOAT3>& stream) {
+            return std::span{ stream }.subspan(submesh.vertex_offset, submesh.vertex_count);
+        };
+        before.Add(local_indices, submesh.vertex_count);
+        std::span<DirectX::XMFLOAT3> attributes[]{ submesh_vertices(normals), submesh_vertices(texcoords), submesh_vertices(tangents) };
+        w::OptimizeMesh(local_indices, submesh_vertices(positions), attributes);
+        after.Add(local_indices, submesh.vertex_count);
+        triangle_count += local_indices.size() / 3;
+
+        submesh.index_count = submesh.index_type == w::IndexType::UInt16
+                ? emit_indices(indices, local_indices, uint16_t{})
+                : emit_indices(indices, local_indices, uint32_t{});
+        indices.resize((indices.size() + 3) & ~size_t(3)); // keep the next submesh 4 byte aligned
     }
+
+    if (triangle_count) {
+        std::cout << "Mesh optimization: ACMR " << before.acmr / triangle_count << " -> " << after.acmr / triangle_count
+                  << ", overfetch " << before.overfetch / triangle_count << " -> " << after.overfetch / triangle_count << '\n';
+    }
+
+    return w::CookMesh({ .positions = positions,
+                         .normals = normals,
+                         .texcoords = texcoords,
+                         .tangents = tangents,
+                         .indices = indices,
+                         .submeshes = submeshes },
+                       content_hash);
 }
 
-w::ModelLoader::~ModelLoader()
+void w::ModelLoader::SetView(const w::MeshView& view) noexcept
 {
-    if (scene) {
-        delete scene;
-    }
+    index_data = view.indices;
+    vertices = view.positions;
+    normals = view.normals;
+    texcoords = view.texcoords;
+    tangents = view.tangents;
+    submeshes = view.submeshes;
 }
@@ -1,22 +1,43 @@
 #pragma once
+#include "mesh_cache.hpp"
+#include "mapped_file.hpp"
+#include "asset_pack.hpp"
 #include <filesystem>
 #include <vector>
 #include <DirectXMath.h>
 #include <span>
 
-struct aiScene;
 namespace w {
+// Loads a mesh through a cooked cache next to the source (<source>.mesh).
+// The first load imports with Assimp and writes the cache, later loads map it and point the spans into the mapping.
 class ModelLoader
 {
 public:
     ModelLoader(std::filesystem::path p);
-    ~ModelLoader();
+    ModelLoader(const w::AssetPack& pack, std::filesystem::path p); // uses the packed cache if there is one, the pack must outlive the loader
 
 public:
-    std::vector<uint16_t> indices;
+    template<typename T>
+    std::span<const T> SubmeshIndices(const w::MeshSubmesh& submesh) const noexcept
+    {
+        return { reinterpret_cast<const T*>(index_data.data() + submesh.index_offset), submesh.index_count };
+    }
+
+public:
+    std::span<const std::byte> index_data; // packed 16/32 bit indices of all submeshes
     std::span<const DirectX::XMFLOAT3> vertices;
     std::span<const DirectX::XMFLOAT3> normals;
     std::span<const DirectX::XMFLOAT3> texcoords;
-    const aiScene* scene;
+    std::span<const DirectX::XMFLOAT3> tangents;
+    std::span<const w::MeshSubmesh> submeshes;
+
+private:
+    void Load(const std::filesystem::path& p);
+    std::vector<std::byte> Import(const std::filesystem::path& p, uint64_t content_hash);
+    void SetView(const w::MeshView& view) noexcept;
+
+private:
+    w::MappedFile mapping; // cooked cache
+    std::vector<std::byte> cooked; // fallback storage if the cache could not be written
 };
-} // namespace w
\ No newline at end of file
+} // namespace w
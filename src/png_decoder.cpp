@@ -0,0 +1,533 @@
+#include "png_decoder.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr uint8_t png_signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+constexpr uint32_t ChunkType(const char (&name)[5]) noexcept
+{
+    return uint32_t(uint8_t(name[0])) << 24 | uint32_t(uint8_t(name[1])) << 16 | uint32_t(uint8_t(name[2])) << 8 | uint32_t(uint8_t(name[3]));
+}
+
+uint32_t ReadBE32(const std::byte* p) noexcept
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+struct Chunk {
+    uint32_t type;
+    std::span<const std::byte> data;
+};
+
+// Walks the chunk list after the signature, stops at IEND or on truncation
+template<typename F>
+bool ForEachChunk(std::span<const std::byte> file, F&& f)
+{
+    if (file.size() < sizeof(png_signature) || std::memcmp(file.data(), png_signature, sizeof(png_signature)) != 0) {
+        return false;
+    }
+    size_t at = sizeof(png_signature);
+    while (at + 12 <= file.size()) {
+        uint32_t length = ReadBE32(file.data() + at);
+        uint32_t type = ReadBE32(file.data() + at + 4);
+        if (length > file.size() - at - 12) {
+            return false;
+        }
+        if (!f(Chunk{ type, file.subspan(at + 8, length) })) {
+            return true;
+        }
+        at += size_t(length) + 12; // length, type, data, crc
+    }
+    return true;
+}
+
+// Streaming inflate (RFC 1950 and 1951) over IDAT chunks in place. Read hands out as many bytes as asked for and
+// keeps the last 32 KiB in a window for back references, so scanlines can be unfiltered as they come out instead of
+// after the whole image is inflated. stb only inflates whole streams into one buffer
+class Inflater
+{
+public:
+    explicit Inflater(std::span<const std::span<const std::byte>> chunks) noexcept
+        : chunks(chunks)
+    {
+        for (auto c : chunks) {
+            available += c.size() * 8;
+        }
+    }
+
+    // false on a corrupt or truncated stream, or when it ends before size bytes
+    bool Read(uint8_t* out, size_t size) noexcept
+    {
+        if (state == State::ZlibHeader) {
+            uint32_t cmf = Bits(8), flg = Bits(8);
+            if ((cmf & 0xf) != 8 || (cmf << 8 | flg) % 31 != 0 || flg & 0x20) { // deflate without a preset dictionary
+                return false;
+            }
+            state = State::BlockHeader;
+        }
+        while (size > 0) {
+            if (match_length > 0) {
+                size_t n = std::min<size_t>(match_length, size);
+                Copy(out, n);
+                match_length -= uint32_t(n);
+                size -= n;
+                continue;
+            }
+            switch (state) {
+            case State::BlockHeader:
+                if (!ReadBlockHeader()) {
+                    return false;
+                }
+                break;
+            case State::Stored:
+                if (stored_left == 0) {
+                    state = final_block ? State::Done : State::BlockHeader;
+                    break;
+                }
+                Emit(out, uint8_t(Bits(8)));
+                stored_left--;
+                size--;
+                break;
+            case State::Compressed: {
+                int symbol = Decode(literals);
+                if (symbol < 0) {
+                    return false;
+                }
+                if (symbol < 256) {
+                    Emit(out, uint8_t(symbol));
+                    size--;
+                } else if (symbol == 256) {
+                    state = final_block ? State::Done : State::BlockHeader;
+                } else if (symbol <= 285) {
+                    symbol -= 257;
+                    match_length = length_base[symbol] + Bits(length_extra[symbol]);
+                    int d = Decode(distances);
+                    if (d < 0 || d >= 30) {
+                        return false;
+                    }
+                    match_distance = distance_base[d] + Bits(distance_extra[d]);
+                    if (match_distance > written) {
+                        return false;
+                    }
+                } else {
+                    return false;
+                }
+                break;
+            }
+            default:
+                return false;
+            }
+            if (consumed > available) {
+                return false; // decoded from the zero padding past the end
+            }
+        }
+        return consumed <= available;
+    }
+
+private:
+    static constexpr uint32_t window_mask = 32767;
+    static constexpr uint32_t fast_bits = 9;
+
+    static constexpr uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static constexpr uint16_t distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr uint8_t distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    // canonical code: count and symbols per length for the bitwise walk, codes up to fast_bits also in a table indexed
+    // by the next fast_bits of the stream holding symbol << 4 | length
+    struct Huffman {
+        uint16_t fast[1 << fast_bits];
+        uint16_t count[16];
+        uint16_t symbols[288];
+    };
+
+    enum class State {
+        ZlibHeader,
+        BlockHeader,
+        Stored,
+        Compressed,
+        Done,
+    };
+
+    void Emit(uint8_t*& out, uint8_t byte) noexcept
+    {
+        *out++ = byte;
+        window[position++ & window_mask] = byte;
+        written++;
+    }
+
+    // n bytes of the pending match, in runs that wrap neither the source nor the destination in the window
+    void Copy(uint8_t*& out, size_t n) noexcept
+    {
+        while (n > 0) {
+            uint32_t from = (position - match_distance) & window_mask, to = position & window_mask;
+            size_t run = std::min({ n, size_t(window_mask + 1 - from), size_t(window_mask + 1 - to) });
+            if (match_distance >= run) {
+                std::memmove(window + to, window + from, run); // from is past to when the source wraps the window
+            } else {
+                // overlapping, repeats the last match_distance bytes: copy one period, then double what is already written
+                std::memcpy(window + to, window + from, match_distance);
+                for (size_t done = match_distance, span = match_distance; done < run; done += span, span *= 2) {
+                    std::memcpy(window + to + done, window + to + done - span, std::min(span, run - done));
+                }
+            }
+            std::memcpy(out, window + to, run);
+            out += run;
+            position += uint32_t(run);
+            written += run;
+            n -= run;
+        }
+    }
+
+    void Refill() noexcept
+    {
+        while (bit_count <= 56) {
+            while (chunk < chunks.size() && at == chunks[chunk].size()) {
+                chunk++;
+                at = 0;
+            }
+            uint64_t byte = chunk < chunks.size() ? uint64_t(chunks[chunk][at++]) : 0;
+            bits |= byte << bit_count;
+            bit_count += 8;
+        }
+    }
+    uint32_t Bits(uint32_t count) noexcept
+    {
+        if (bit_count < count) {
+            Refill();
+        }
+        uint32_t value = uint32_t(bits & ((uint64_t(1) << count) - 1));
+        bits >>= count;
+        bit_count -= count;
+        consumed += count;
+        return value;
+    }
+
+    int Decode(const Huffman& h) noexcept
+    {
+        if (bit_count < 16) {
+            Refill();
+        }
+        uint16_t entry = h.fast[bits & ((1u << fast_bits) - 1)];
+        if (entry != 0) {
+            Bits(entry & 0xf);
+            return entry >> 4;
+        }
+        // longer codes, walked a bit at a time like zlib's puff
+        int code = 0, first = 0, index = 0;
+        for (uint32_t length = 1; length < 16; length++) {
+            code |= int(bits >> (length - 1) & 1);
+            int count = h.count[length];
+            if (code - count < first) {
+                Bits(length);
+                return h.symbols[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    static bool Build(Huffman& h, const uint8_t* lengths, uint32_t count) noexcept
+    {
+        std::memset(&h, 0, sizeof(h));
+        for (uint32_t i = 0; i < count; i++) {
+            h.count[lengths[i]]++;
+        }
+        h.count[0] = 0;
+        int left = 1;
+        uint16_t offsets[16]{};
+        uint16_t next_code[16]{};
+        for (uint32_t length = 1; length < 16; length++) {
+            left = (left << 1) - h.count[length];
+            if (left < 0) {
+                return false; // over-subscribed, incomplete codes are fine
+            }
+            offsets[length] = uint16_t(offsets[length - 1] + h.count[length - 1]);
+            next_code[length] = uint16_t((next_code[length - 1] + h.count[length - 1]) << 1);
+        }
+        for (uint32_t symbol = 0; symbol < count; symbol++) {
+            uint32_t length = lengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+            h.symbols[offsets[length]++] = uint16_t(symbol);
+            uint32_t code = next_code[length]++;
+            if (length <= fast_bits) {
+                uint32_t reversed = 0; // codes are packed from their top bit on
+                for (uint32_t i = 0; i < length; i++) {
+                    reversed |= (code >> i & 1) << (length - 1 - i);
+                }
+                for (uint32_t i = reversed; i < (1u << fast_bits); i += 1u << length) {
+                    h.fast[i] = uint16_t(symbol << 4 | length);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool ReadBlockHeader() noexcept
+    {
+        if (final_block) {
+            return false; // asked for more than the stream holds
+        }
+        final_block = Bits(1) != 0;
+        switch (Bits(2)) {
+        case 0: {
+            Bits(bit_count % 8);
+            uint32_t length = Bits(16), complement = Bits(16);
+            if ((length ^ 0xffff) != complement) {
+                return false;
+            }
+            stored_left = length;
+            state = State::Stored;
+            return true;
+        }
+        case 1: {
+            uint8_t lengths[288 + 30];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            std::memset(lengths + 288, 5, 30);
+            state = State::Compressed;
+            return Build(literals, lengths, 288) && Build(distances, lengths + 288, 30);
+        }
+        case 2:
+            state = State::Compressed;
+            return ReadDynamicTables();
+        default:
+            return false;
+        }
+    }
+
+    bool ReadDynamicTables() noexcept
+    {
+        constexpr uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        uint32_t literal_count = Bits(5) + 257, distance_count = Bits(5) + 1, length_count = Bits(4) + 4;
+        if (literal_count > 286 || distance_count > 30) {
+            return false;
+        }
+        uint8_t code_lengths[19]{};
+        for (uint32_t i = 0; i < length_count; i++) {
+            code_lengths[order[i]] = uint8_t(Bits(3));
+        }
+        Huffman& lengths_code = distances; // rebuilt below, only needed while reading the lengths
+        if (!Build(lengths_code, code_lengths, 19)) {
+            return false;
+        }
+        uint8_t lengths[286 + 30]{};
+        uint32_t total = literal_count + distance_count;
+        for (uint32_t i = 0; i < total;) {
+            int symbol = Decode(lengths_code);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[i++] = uint8_t(symbol);
+                continue;
+            }
+            uint8_t value = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (i == 0) {
+                    return false;
+                }
+                value = lengths[i - 1];
+                repeat = 3 + Bits(2);
+            } else {
+                repeat = symbol == 17 ? 3 + Bits(3) : 11 + Bits(7);
+            }
+            if (i + repeat > total) {
+                return false;
+            }
+            std::memset(lengths + i, value, repeat);
+            i += repeat;
+        }
+        if (lengths[256] == 0) {
+            return false; // no end of block code
+        }
+        return Build(literals, lengths, literal_count) && Build(distances, lengths + literal_count, distance_count);
+    }
+
+private:
+    std::span<const std::span<const std::byte>> chunks;
+    size_t chunk = 0, at = 0;
+    uint64_t bits = 0;
+    uint32_t bit_count = 0;
+    uint64_t consumed = 0; // bits, checked against available to catch reads past the end
+    uint64_t available = 0;
+
+    State state = State::ZlibHeader;
+    bool final_block = false;
+    uint32_t stored_left = 0;
+    uint32_t match_length = 0, match_distance = 0;
+    Huffman literals, distances;
+
+    uint8_t window[window_mask + 1];
+    uint32_t position = 0;
+    uint64_t written = 0;
+};
+
+uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c) noexcept
+{
+    int p = int(a) + int(b) - int(c);
+    int pa = std::abs(p - int(a)), pb = std::abs(p - int(b)), pc = std::abs(p - int(c));
+    return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+// In place reconstruction of one filtered scanline against the previous reconstructed one
+bool Unfilter(uint8_t filter, uint8_t* row, const uint8_t* prev, size_t size, size_t bpp) noexcept
+{
+    switch (filter) {
+    case 0:
+        return true;
+    case 1:
+        for (size_t i = bpp; i < size; i++) {
+            row[i] = uint8_t(row[i] + row[i - bpp]);
+        }
+        return true;
+    case 2:
+        for (size_t i = 0; i < size; i++) {
+            row[i] = uint8_t(row[i] + prev[i]);
+        }
+        return true;
+    case 3:
+        for (size_t i = 0; i < size; i++) {
+            uint8_t left = i >= bpp ? row[i - bpp] : 0;
+            row[i] = uint8_t(row[i] + ((uint32_t(left) + prev[i]) >> 1));
+        }
+        return true;
+    case 4:
+        for (size_t i = 0; i < size; i++) {
+            uint8_t left = i >= bpp ? row[i - bpp] : 0;
+            uint8_t upper_left = i >= bpp ? prev[i - bpp] : 0;
+            row[i] = uint8_t(row[i] + Paeth(left, prev[i], upper_left));
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+std::optional<w::png::Info> w::png::ReadInfo(std::span<const std::byte> file) noexcept
+{
+    std::optional<Info> info;
+    ForEachChunk(file, [&info](const Chunk& chunk) {
+        if (chunk.type == ChunkType("IHDR") && chunk.data.size() >= 13) {
+            info = Info{
+                .width = ReadBE32(chunk.data.data()),
+                .height = ReadBE32(chunk.data.data() + 4),
+                .bit_depth = uint8_t(chunk.data[8]),
+                .color_type = uint8_t(chunk.data[9]),
+                .interlace = uint8_t(chunk.data[12]),
+            };
+        }
+        return false; // IHDR is always first
+    });
+    if (info && (info->width == 0 || info->height == 0)) {
+        return std::nullopt;
+    }
+    return info;
+}
+
+bool w::png::DecodeRows(std::span<const std::byte> file, uint8_t* dst, uint32_t row_pitch)
+{
+    auto info = ReadInfo(file);
+    if (!info || !info->RowDecodable()) {
+        return false;
+    }
+
+    std::array<uint8_t, 256 * 4> palette{};
+    for (size_t i = 0; i < 256; i++) {
+        palette[i * 4 + 3] = 255;
+    }
+    // tRNS of grey and truecolor images names one fully transparent color. Samples are 16 bit, at bit depth 8 only
+    // the low byte counts like in stb
+    std::optional<std::array<uint8_t, 3>> color_key;
+
+    // the inflater reads split IDAT chunks in place
+    std::vector<std::span<const std::byte>> idat;
+    bool ok = ForEachChunk(file, [&](const Chunk& chunk) {
+        if (chunk.type == ChunkType("PLTE")) {
+            for (size_t i = 0; i < std::min<size_t>(256, chunk.data.size() / 3); i++) {
+                std::memcpy(&palette[i * 4], chunk.data.data() + i * 3, 3);
+            }
+        } else if (chunk.type == ChunkType("tRNS") && info->color_type == 3) {
+            for (size_t i = 0; i < std::min<size_t>(256, chunk.data.size()); i++) {
+                palette[i * 4 + 3] = uint8_t(chunk.data[i]);
+            }
+        } else if (chunk.type == ChunkType("tRNS") && (info->color_type == 0 || info->color_type == 2)) {
+            size_t samples = info->color_type == 0 ? 1 : 3;
+            if (chunk.data.size() >= samples * 2) {
+                std::array<uint8_t, 3> key{};
+                for (size_t i = 0; i < samples; i++) {
+                    key[i] = uint8_t(chunk.data[i * 2 + 1]);
+                }
+                color_key = key;
+            }
+        } else if (chunk.type == ChunkType("IDAT")) {
+            idat.push_back(chunk.data);
+        }
+        return chunk.type != ChunkType("IEND");
+    });
+    if (!ok || idat.empty()) {
+        return false;
+    }
+
+    uint32_t channels = info->color_type == 0 ? 1 : info->color_type == 2 ? 3 : info->color_type == 3 ? 1 : info->color_type == 4 ? 2 : 4;
+    size_t stride = size_t(info->width) * channels; // filtered bytes per row, without the filter byte
+
+    // two scanlines with their filter byte, the one being reconstructed and the one above it
+    std::vector<uint8_t> rows(2 * (stride + 1));
+    uint8_t* row = rows.data();
+    uint8_t* prev_row = rows.data() + stride + 1;
+    Inflater inflater{ idat };
+    for (uint32_t y = 0; y < info->height; y++) {
+        if (!inflater.Read(row, stride + 1) || !Unfilter(row[0], row + 1, prev_row + 1, stride, channels)) {
+            return false;
+        }
+        const uint8_t* in = row + 1;
+
+        // expand to RGBA into the destination row, this is the only write of the final texels
+        uint8_t* out = dst + size_t(y) * row_pitch;
+        switch (info->color_type) {
+        case 0:
+            for (uint32_t x = 0; x < info->width; x++, out += 4) {
+                out[0] = out[1] = out[2] = in[x];
+                out[3] = color_key && in[x] == (*color_key)[0] ? 0 : 255;
+            }
+            break;
+        case 2:
+            for (uint32_t x = 0; x < info->width; x++, out += 4) {
+                const uint8_t* rgb = in + x * 3;
+                std::memcpy(out, rgb, 3);
+                out[3] = color_key && rgb[0] == (*color_key)[0] && rgb[1] == (*color_key)[1] && rgb[2] == (*color_key)[2] ? 0 : 255;
+            }
+            break;
+        case 3:
+            for (uint32_t x = 0; x < info->width; x++, out += 4) {
+                std::memcpy(out, &palette[size_t(in[x]) * 4], 4);
+            }
+            break;
+        case 4:
+            for (uint32_t x = 0; x < info->width; x++, out += 4) {
+                out[0] = out[1] = out[2] = in[x * 2];
+                out[3] = in[x * 2 + 1];
+            }
+            break;
+        default:
+            std::memcpy(out, in, stride);
+            break;
+        }
+        std::swap(row, prev_row);
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+namespace w::png {
+struct Info {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t bit_depth = 0;
+    uint8_t color_type = 0;
+    uint8_t interlace = 0;
+
+    // the row decoder covers 8 bit non interlaced images, everything else goes through stb
+    bool RowDecodable() const noexcept
+    {
+        return bit_depth == 8 && interlace == 0 &&
+                (color_type == 0 || color_type == 2 || color_type == 3 || color_type == 4 || color_type == 6);
+    }
+};
+
+std::optional<Info> ReadInfo(std::span<const std::byte> file) noexcept;
+
+// Decodes to RGBA8 rows written straight to dst at row_pitch. Scanlines are inflated one at a time, the only
+// intermediates are two of them and the 32 KiB inflate window
+bool DecodeRows(std::span<const std::byte> file, uint8_t* dst, uint32_t row_pitch);
+} // namespace w::png
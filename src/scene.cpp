@@ -2,14 +2,18 @@
 #include "graphics.hpp"
 #include <fstream>
 
-std::string LoadShader(std::filesystem::path p)
+std::filesystem::path ShaderPath(std::filesystem::path p)
 {
     if constexpr (wis::shader_intermediate == wis::ShaderIntermediate::DXIL) {
         p += u".cso";
     } else {
         p += u".spv";
     }
+    return p;
+}
 
+std::string LoadShader(const std::filesystem::path& p)
+{
     if (!std::filesystem::exists(p)) {
         throw w::Exception(wis::format("Shader file not found: {}", p.string()));
     }
@@ -24,8 +28,8 @@ std::string LoadShader(std::filesystem::path p)
     return ret;
 }
 
-w::Scene::Scene(w::Graphics& gfx)
-    : model(gfx)
+w::Scene::Scene(w::Graphics& gfx, w::UploadContext& upload, const w::AssetPack& assets)
+    : model(gfx, upload, assets)
 {
     // create camera buffer
     wis::Result result = wis::success;
@@ -78,7 +82,7 @@ void w::Scene::Resize(w::Graphics& gfx, uint32_t width, uint32_t height)
     camera.SetPerspective(std::numbers::pi_v<float> / 3.0f, float(width) / float(height), 0.1f, 1000.0f);
 }
 
-void w::Scene::CreatePipelines(w::Graphics& gfx)
+void w::Scene::CreatePipelines(w::Graphics& gfx, const w::AssetPack& assets)
 {
     wis::Result result = wis::success;
     auto& rt = gfx.GetRaytracing();
@@ -95,7 +99,7 @@ void w::Scene::CreatePipelines(w::Graphics& gfx)
         .address_v = wis::AddressMode::Repeat,
         .address_w = wis::AddressMode::Repeat,
         .min_lod = 0,
-        .max_lod = 1.0f,
+        .max_lod = 16.0f, // whole mip chain of cooked textures
         .mip_lod_bias = 0.0f,
         .comparison_op = wis::Compare::None,
     };
@@ -116,7 +120,7 @@ void w::Scene::CreatePipelines(w::Graphics& gfx)
     rt_descriptor_storage = device.CreateDescriptorStorage(result, bindings, std::size(bindings));
     rt_root_signature = device.CreateRootSignature(result, push_constants, std::size(push_constants), push_descriptors, std::size(push_descriptors), bindings, std::size(bindings));
 
-    LoadShaders(gfx);
+    LoadShaders(gfx, assets);
     wis::ShaderView shaders = lib_shader;
     wis::ShaderExport exports[]{
         { .entry_point = "RayGeneration", .shader_type = wis::RaytracingShaderType::Raygen, .shader_array_index = 0 },
@@ -292,12 +296,18 @@ void w::Scene::ZoomCamera(float dz)
     camera.Zoom(dz);
 }
 
-void w::Scene::LoadShaders(w::Graphics& gfx)
+void w::Scene::LoadShaders(w::Graphics& gfx, const w::AssetPack& assets)
 {
     wis::Result result = wis::success;
     auto& device = gfx.GetDevice();
 
-    auto buf = LoadShader("shaders/raytracing.lib");
+    // bytecode straight from the pack, loose files when running without one
+    auto path = ShaderPath("shaders/raytracing.lib");
+    if (auto bytes = assets.Find(path.generic_string()); !bytes.empty()) {
+        lib_shader = device.CreateShader(result, bytes.data(), uint32_t(bytes.size()));
+        return;
+    }
+    auto buf = LoadShader(path);
     lib_shader = device.CreateShader(result, buf.data(), uint32_t(buf.size()));
 }
 
@@ -310,11 +320,12 @@ void w::Scene::CreateTLAS(w::Graphics& gfx, wis::CommandList& cmd_list)
 
     // initialize acceleration structure instance
     instance_buffer = alloc.CreateBuffer(result, sizeof(wis::AccelerationInstance), wis::BufferUsage::AccelerationStructureInput, wis::MemoryType::Upload, wis::MemoryFlags::Mapped);
+    auto transform = model.GetTransform(); // undoes vertex quantization
     instance_buffer.Map<wis::AccelerationInstance>()[0] = {
         .transform = {
-                { 1.0f, 0.0f, 0.0f, 0.0f },
-                { 0.0f, 1.0f, 0.0f, 0.0f },
-                { 0.0f, 0.0f, 1.0f, 0.0f },
+                { transform[0][0], transform[0][1], transform[0][2], transform[0][3] },
+                { transform[1][0], transform[1][1], transform[1][2], transform[1][3] },
+                { transform[2][0], transform[2][1], transform[2][2], transform[2][3] },
         },
         .instance_id = 0,
         .mask = 0xFF,
@@ -8,12 +8,12 @@ namespace w {
 class Scene
 {
 public:
-    Scene(w::Graphics& gfx);
+    Scene(w::Graphics& gfx, w::UploadContext& upload, const w::AssetPack& assets);
     ~Scene();
 
 public:
     void Resize(w::Graphics& gfx, uint32_t width, uint32_t height);
-    void CreatePipelines(w::Graphics& gfx);
+    void CreatePipelines(w::Graphics& gfx, const w::AssetPack& assets);
     void CreateTLAS(w::Graphics& gfx, wis::CommandList& cmd_list);
     void TransitionTextures(w::Graphics& gfx, wis::CommandList& cmd_list);
     void Bind(w::Graphics& gfx);
@@ -26,7 +26,7 @@ public:
     void ZoomCamera(float dz);
 
 private:
-    void LoadShaders(w::Graphics& gfx);
+    void LoadShaders(w::Graphics& gfx, const w::AssetPack& assets);
 
 private:
     w::Model model; // snowman
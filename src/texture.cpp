@@ -1,40 +1,194 @@
 #include "texture.hpp"
 #include "graphics.hpp"
+#include "png_decoder.hpp"
+#include <fpng.h>
+#include <cstring>
+#include <mutex>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb.h"
 
-void w::Texture::Load(w::Graphics& gfx, std::filesystem::path p)
+namespace {
+wis::DataFormat ToDataFormat(w::dds::Format format) noexcept
 {
-    const wis::ResourceAllocator& alloc = gfx.GetAllocator();
-    const wis::Device& device = gfx.GetDevice();
-    const wis::CommandQueue& queue = gfx.GetMainQueue();
+    switch (format) {
+    case w::dds::Format::BC4Unorm:
+        return wis::DataFormat::BC4RUnorm;
+    case w::dds::Format::BC5Unorm:
+        return wis::DataFormat::BC5RGUnorm;
+    case w::dds::Format::BC7Unorm:
+        return wis::DataFormat::BC7RGBAUnorm;
+    default:
+        return wis::DataFormat::RGBA8Unorm;
+    }
+}
 
-    int width, height, channels;
-    auto* idata = stbi_load(p.string().c_str(), &width, &height, &channels, 4);
+bool IsBlockCompressed(wis::DataFormat format) noexcept
+{
+    return format == wis::DataFormat::BC4RUnorm || format == wis::DataFormat::BC5RGUnorm || format == wis::DataFormat::BC7RGBAUnorm;
+}
+} // namespace
 
-    if (!idata) {
-        return;
+w::ImageSource w::ImageSource::Open(const std::filesystem::path& p)
+{
+    // cooked textures carry the whole mip chain
+    auto cooked = p;
+    cooked.replace_extension(".dds");
+    for (auto& candidate : { cooked, p }) {
+        if (w::MappedFile file{ candidate }) {
+            auto bytes = file.Bytes();
+            if (auto source = Open(bytes, std::move(file))) {
+                return source;
+            }
+        }
+    }
+    return {};
+}
+
+w::ImageSource w::ImageSource::Open(const w::AssetPack& pack, const std::filesystem::path& p)
+{
+    auto cooked = p;
+    cooked.replace_extension(".dds");
+    for (auto& candidate : { cooked, p }) {
+        auto bytes = pack.Find(candidate.generic_string());
+        if (bytes.empty()) {
+            continue;
+        }
+        // decoders touch the whole blob, start paging it in while the texture is created
+        w::MappedFile::Prefetch(bytes);
+        if (auto source = Open(bytes)) {
+            return source;
+        }
+    }
+    return Open(p);
+}
+
+w::ImageSource w::ImageSource::Open(std::span<const std::byte> bytes, w::MappedFile file)
+{
+    if (auto surface = w::dds::Parse(bytes)) {
+        return { .codec = Codec::DDS,
+                 .format = ToDataFormat(surface->format),
+                 .width = surface->width,
+                 .height = surface->height,
+                 .mips = std::move(surface->mips),
+                 .data = surface->data,
+                 .file = std::move(file) };
+    }
+
+    static std::once_flag fpng_init;
+    std::call_once(fpng_init, fpng::fpng_init);
+
+    uint32_t width = 0, height = 0, channels = 0;
+    Codec codec = Codec::Stb;
+    if (fpng::fpng_get_info(bytes.data(), uint32_t(bytes.size()), width, height, channels) == fpng::FPNG_DECODE_SUCCESS) {
+        codec = Codec::FPNG;
+    } else if (auto info = w::png::ReadInfo(bytes); info && info->RowDecodable()) {
+        codec = Codec::PNG;
+        width = info->width;
+        height = info->height;
+    } else {
+        int x, y, channels;
+        if (!stbi_info_from_memory(reinterpret_cast<const stbi_uc*>(bytes.data()), int(bytes.size()), &x, &y, &channels)) {
+            return {};
+        }
+        width = uint32_t(x);
+        height = uint32_t(y);
+    }
+
+    return { .codec = codec,
+             .width = width,
+             .height = height,
+             .mips = w::dds::MipLayout(w::dds::Format::RGBA8Unorm, width, height, 1),
+             .data = bytes,
+             .file = std::move(file) };
+}
+
+std::vector<w::StagedMip> w::Texture::Stage(w::Graphics& gfx, w::UploadContext& upload, const w::ImageSource& source)
+{
+    const wis::ResourceAllocator& alloc = gfx.GetAllocator();
+
+    if (!source) {
+        return {};
     }
 
-    wis::Size2D size{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    format = source.format;
+    mip_levels = uint32_t(source.mips.size());
 
     using namespace wis;
     wis::TextureDesc tdesc{
-        .format = wis::DataFormat::RGBA8Unorm,
-        .size = { size.width, size.height, 1 },
+        .format = format,
+        .size = { source.width, source.height, 1 },
+        .mip_levels = mip_levels,
         .usage = wis::TextureUsage::ShaderResource | wis::TextureUsage::CopyDst,
     };
     auto [res, tex] = alloc.CreateTexture(tdesc);
     texture = std::move(tex);
 
-    auto [res4, buf] = alloc.CreateUploadBuffer(size.width * size.height * 4);
-    std::copy(idata, idata + size.width * size.height * 4, buf.Map<uint8_t>());
-    buf.Unmap();
-    stbi_image_free(idata);
+    // rows are texel rows for RGBA8 and rows of 4x4 blocks for BC formats
+    std::vector<w::StagedMip> staged;
+    staged.reserve(mip_levels);
+    for (auto& level : source.mips) {
+        uint32_t row_pitch = w::UploadContext::TextureRowPitch(level.row_bytes);
+        staged.push_back({ .level = level,
+                           .staging = upload.Allocate(uint64_t(row_pitch) * level.rows),
+                           .row_pitch = row_pitch });
+    }
+    return staged;
+}
 
-    auto [res2, cl] = device.CreateCommandList(wis::QueueType::Graphics);
-    std::ignore = cl.Reset();
+bool w::Texture::Decode(const w::ImageSource& source, std::span<const StagedMip> staged)
+{
+    switch (source.codec) {
+    case ImageSource::Codec::DDS:
+        for (auto& mip : staged) {
+            const std::byte* src = source.data.data() + mip.level.offset;
+            for (uint32_t y = 0; y < mip.level.rows; y++) {
+                std::memcpy(mip.staging.data + uint64_t(y) * mip.row_pitch, src + uint64_t(y) * mip.level.row_bytes, mip.level.row_bytes);
+            }
+        }
+        return true;
+    case ImageSource::Codec::FPNG: {
+        // fpng only decodes into a vector, still faster than inflating ourselves
+        auto& mip = staged[0];
+        thread_local std::vector<uint8_t> pixels;
+        uint32_t width, height, channels;
+        if (fpng::fpng_decode_memory(source.data.data(), uint32_t(source.data.size()), pixels, width, height, channels, 4) != fpng::FPNG_DECODE_SUCCESS) {
+            return false;
+        }
+        for (uint32_t y = 0; y < mip.level.rows; y++) {
+            std::memcpy(mip.staging.data + uint64_t(y) * mip.row_pitch, pixels.data() + uint64_t(y) * mip.level.row_bytes, mip.level.row_bytes);
+        }
+        return true;
+    }
+    case ImageSource::Codec::PNG:
+        return w::png::DecodeRows(source.data, staged[0].staging.data, staged[0].row_pitch);
+    case ImageSource::Codec::Stb: {
+        // fallback for formats without a row decoder, costs an extra copy
+        auto& mip = staged[0];
+        int width, height, channels;
+        auto* idata = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source.data.data()), int(source.data.size()), &width, &height, &channels, 4);
+        if (!idata) {
+            return false;
+        }
+        for (uint32_t y = 0; y < mip.level.rows; y++) {
+            std::memcpy(mip.staging.data + uint64_t(y) * mip.row_pitch, idata + uint64_t(y) * mip.level.row_bytes, mip.level.row_bytes);
+        }
+        stbi_image_free(idata);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void w::Texture::Upload(w::UploadContext& upload, std::span<const StagedMip> staged, bool decoded)
+{
+    if (!decoded || staged.empty()) {
+        texture = {};
+        return;
+    }
+
+    auto& cl = upload.GetCommandList();
     cl.TextureBarrier(
             {
                     .sync_before = wis::BarrierSync::None,
@@ -43,17 +197,24 @@ void w::Texture::Load(w::Graphics& gfx, std::filesystem::path p)
                     .access_after = wis::ResourceAccess::CopyDest,
                     .state_before = wis::TextureState::Undefined,
                     .state_after = wis::TextureState::CopyDest,
+                    .subresource_range = { 0, mip_levels, 0, 1 },
             },
             texture);
 
-    wis::BufferTextureCopyRegion region{
-        .texture{
-                .size = { size.width, size.height, 1 },
-                .format = wis::DataFormat::RGBA8Unorm,
-        }
-    };
+    // D3D12 copies block compressed mips in whole blocks, the 2x2 and 1x1 levels too; Vulkan copies end at the mip's texel size
+    bool whole_blocks = wis::shader_intermediate == wis::ShaderIntermediate::DXIL && IsBlockCompressed(format);
+    for (uint32_t mip = 0; mip < mip_levels; mip++) {
+        auto& level = staged[mip].level;
+        uint32_t width = whole_blocks ? (level.width + 3) & ~3u : level.width;
+        uint32_t height = whole_blocks ? (level.height + 3) & ~3u : level.height;
+        upload.CopyTexture(staged[mip].staging, texture,
+                           {
+                                   .size = { width, height, 1 },
+                                   .mip = mip,
+                                   .format = format,
+                           });
+    }
 
-    cl.CopyBufferToTexture(buf, texture, &region, 1);
     cl.TextureBarrier(
             {
                     .sync_before = wis::BarrierSync::Copy,
@@ -62,24 +223,18 @@ void w::Texture::Load(w::Graphics& gfx, std::filesystem::path p)
                     .access_after = wis::ResourceAccess::NoAccess,
                     .state_before = wis::TextureState::CopyDest,
                     .state_after = wis::TextureState::ShaderResource,
+                    .subresource_range = { 0, mip_levels, 0, 1 },
             },
             texture);
-
-    cl.Close();
-    wis::CommandListView lists[] = { cl };
-    auto [res3, f] = device.CreateFence();
-    queue.ExecuteCommandLists(lists, 1);
-    std::ignore = queue.SignalQueue(f, 1);
-    std::ignore = f.Wait(1);
 }
 
 wis::ShaderResource w::Texture::CreateSrv(w::Graphics& gfx)
 {
     wis::Result res = wis::success;
     wis::ShaderResourceDesc srv_desc{
-        .format = wis::DataFormat::RGBA8Unorm,
+        .format = format,
         .view_type = wis::TextureViewType::Texture2D,
-        .subresource_range = { 0, 1, 0, 1 },
+        .subresource_range = { 0, mip_levels, 0, 1 },
     };
     return gfx.GetDevice().CreateShaderResource(res, texture, srv_desc);
 }
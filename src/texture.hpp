@@ -1,17 +1,72 @@
 #pragma once
+#include "dds.hpp"
+#include "mapped_file.hpp"
+#include "asset_pack.hpp"
+#include "upload_context.hpp"
 #include <wisdom/wisdom.hpp>
 #include <filesystem>
+#include <vector>
 
 namespace w {
 class Graphics;
+
+// Texel source opened and sized without decoding anything
+struct ImageSource {
+    enum class Codec {
+        None,
+        DDS, // cooked, copied from the mapping
+        FPNG, // written by fpng, decoded with its SIMD decoder
+        PNG, // row decoder
+        Stb, // everything else
+    };
+
+    Codec codec = Codec::None;
+    wis::DataFormat format = wis::DataFormat::RGBA8Unorm;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<w::dds::MipLevel> mips; // tightly packed layout of the decoded texels
+    std::span<const std::byte> data; // encoded file contents
+    w::MappedFile file;
+
+    static ImageSource Open(const std::filesystem::path& p); // prefers a cooked .dds next to p
+    static ImageSource Open(const w::AssetPack& pack, const std::filesystem::path& p); // same lookup in the pack, then loose files
+    static ImageSource Open(std::span<const std::byte> bytes, w::MappedFile file = {}); // DDS or any image, bytes stay borrowed unless file owns them
+    explicit operator bool() const noexcept
+    {
+        return codec != Codec::None;
+    }
+};
+
+// Staging memory reserved for one mip, rows at the backend copy pitch
+struct StagedMip {
+    w::dds::MipLevel level;
+    w::UploadContext::Allocation staging;
+    uint32_t row_pitch = 0;
+};
+
 class Texture
 {
 public:
-    void Load(w::Graphics& gfx, std::filesystem::path p); // uses staging buffer
+    // owning thread: creates the texture and reserves staging memory for every mip
+    std::vector<StagedMip> Stage(w::Graphics& gfx, w::UploadContext& upload, const w::ImageSource& source);
+    // any thread: writes texels straight into the staging memory, so each image crosses memory once
+    static bool Decode(const w::ImageSource& source, std::span<const StagedMip> staged);
+    // owning thread: records the copies, drops the texture if decoding failed
+    void Upload(w::UploadContext& upload, std::span<const StagedMip> staged, bool decoded);
+
+    void Load(w::Graphics& gfx, w::UploadContext& upload, const w::AssetPack& pack, std::filesystem::path p)
+    {
+        auto source = w::ImageSource::Open(pack, p);
+        auto staged = Stage(gfx, upload, source);
+        Upload(upload, staged, Decode(source, staged));
+    }
+
 public:
     wis::ShaderResource CreateSrv(w::Graphics& gfx);
 
 private:
     wis::Texture texture;
+    wis::DataFormat format = wis::DataFormat::RGBA8Unorm;
+    uint32_t mip_levels = 1;
 };
-} // namespace w
\ No newline at end of file
+} // namespace w
@@ -0,0 +1,147 @@
+#include "upload_context.hpp"
+#include "graphics.hpp"
+#include <cstring>
+
+w::UploadContext::UploadContext(w::Graphics& gfx, uint64_t ring_size)
+    : device(gfx.GetDevice()), queue(gfx.GetMainQueue()), allocator(gfx.GetAllocator()), ring_size(wis::detail::aligned_size(ring_size, 512ull))
+{
+    wis::Result result = wis::success;
+    fence = device.CreateFence(result, 0);
+    CheckResult(result);
+
+    ring = allocator.CreateUploadBuffer(result, this->ring_size);
+    CheckResult(result);
+    ring_data = ring.Map<uint8_t>(); // stays mapped for the lifetime of the context
+
+    cmd_list = device.CreateCommandList(result, wis::QueueType::Graphics);
+    CheckResult(result);
+}
+
+w::UploadContext::~UploadContext()
+{
+    std::ignore = fence.Wait(fence_value - 1);
+    for (auto& submission : in_flight) {
+        Unmap(submission.dedicated);
+    }
+    Unmap(dedicated);
+    ring.Unmap();
+}
+
+w::UploadContext::Allocation w::UploadContext::Allocate(uint64_t size, uint64_t alignment)
+{
+    while (size <= ring_size) {
+        Reclaim();
+
+        uint64_t start = wis::detail::aligned_size(head, alignment);
+        if (start % ring_size + size > ring_size) {
+            start = (head / ring_size + 1) * ring_size; // does not fit before the end, wrap around
+        }
+        if (start + size - tail <= ring_size) {
+            head = start + size;
+            return { .buffer = &ring, .data = ring_data + start % ring_size, .offset = start % ring_size, .size = size };
+        }
+
+        // recycle the oldest submission, never flush the recording one:
+        // its allocations may still be written by decoders and have no copies recorded yet
+        if (in_flight.empty()) {
+            break;
+        }
+        Wait({ in_flight.front().fence_value });
+    }
+
+    // larger than the ring, or the ring is full of unsubmitted work
+    wis::Result result = wis::success;
+    auto& buffer = dedicated.emplace_back(allocator.CreateUploadBuffer(result, size));
+    CheckResult(result);
+    return { .buffer = &buffer, .data = buffer.Map<uint8_t>(), .offset = 0, .size = size };
+}
+
+uint32_t w::UploadContext::TextureRowPitch(uint32_t row_bytes) noexcept
+{
+    // D3D12 requires buffer rows of texture copies at 256 byte pitch, Vulkan copies are tightly packed
+    if constexpr (wis::shader_intermediate == wis::ShaderIntermediate::DXIL) {
+        return wis::detail::aligned_size(row_bytes, 256u);
+    } else {
+        return row_bytes;
+    }
+}
+
+void w::UploadContext::CopyBuffer(const Allocation& src, const wis::Buffer& dst, uint64_t dst_offset)
+{
+    cmd_list.CopyBuffer(*src.buffer, dst, { .src_offset = src.offset, .dst_offset = dst_offset, .size_bytes = src.size });
+}
+
+void w::UploadContext::UploadBuffer(std::span<const std::byte> data, const wis::Buffer& dst, uint64_t dst_offset)
+{
+    auto staging = Allocate(data.size_bytes());
+    std::memcpy(staging.data, data.data(), data.size_bytes());
+    CopyBuffer(staging, dst, dst_offset);
+}
+
+void w::UploadContext::CopyTexture(const Allocation& src, const wis::Texture& dst, const wis::TextureRegion& region)
+{
+    wis::BufferTextureCopyRegion copy_region{
+        .buffer_offset = src.offset,
+        .texture = region,
+    };
+    cmd_list.CopyBufferToTexture(*src.buffer, dst, &copy_region, 1);
+}
+
+w::UploadToken w::UploadContext::Submit()
+{
+    cmd_list.Close();
+    wis::CommandListView lists[] = { cmd_list };
+    queue.ExecuteCommandLists(lists, 1);
+    CheckResult(queue.SignalQueue(fence, fence_value));
+
+    in_flight.push_back({ .fence_value = fence_value,
+                          .ring_end = head,
+                          .cmd_list = std::move(cmd_list),
+                          .retained = std::move(retained),
+                          .dedicated = std::move(dedicated) });
+    retained.clear();
+    dedicated.clear();
+
+    // command lists can only be reset once the GPU is done with them
+    Reclaim();
+    if (free_lists.empty()) {
+        wis::Result result = wis::success;
+        cmd_list = device.CreateCommandList(result, wis::QueueType::Graphics);
+        CheckResult(result);
+    } else {
+        cmd_list = std::move(free_lists.back());
+        free_lists.pop_back();
+        CheckResult(cmd_list.Reset());
+    }
+    return { fence_value++ };
+}
+
+bool w::UploadContext::IsComplete(UploadToken token) const noexcept
+{
+    return fence.GetCompletedValue() >= token.value;
+}
+
+void w::UploadContext::Wait(UploadToken token) const
+{
+    if (!IsComplete(token)) {
+        CheckResult(fence.Wait(token.value));
+    }
+}
+
+void w::UploadContext::Reclaim() noexcept
+{
+    uint64_t completed = fence.GetCompletedValue();
+    while (!in_flight.empty() && in_flight.front().fence_value <= completed) {
+        tail = in_flight.front().ring_end;
+        Unmap(in_flight.front().dedicated);
+        free_lists.push_back(std::move(in_flight.front().cmd_list)); // retained resources die here
+        in_flight.pop_front();
+    }
+}
+
+void w::UploadContext::Unmap(std::deque<wis::Buffer>& buffers) noexcept
+{
+    for (auto& buffer : buffers) {
+        buffer.Unmap();
+    }
+}
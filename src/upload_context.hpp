@@ -0,0 +1,86 @@
+#pragma once
+#include "consts.hpp"
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace w {
+class Graphics;
+
+// Completion token of an UploadContext submission, value 0 is always complete
+struct UploadToken {
+    uint64_t value = 0;
+};
+
+// Batches staging copies for many resources into a single command list.
+// Staging memory is suballocated from one persistently mapped ring buffer and recycled once the GPU is done with it.
+// Allocations stay valid until the submission they were made for completes, so they may be filled from other threads.
+class UploadContext
+{
+public:
+    struct Allocation {
+        const wis::Buffer* buffer = nullptr; // ring, or a dedicated buffer when the ring can't hold it
+        uint8_t* data = nullptr;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+public:
+    UploadContext(w::Graphics& gfx, uint64_t ring_size = 256ull * 1024 * 1024);
+    ~UploadContext();
+
+public:
+    [[nodiscard]] Allocation Allocate(uint64_t size, uint64_t alignment = 512);
+    static uint32_t TextureRowPitch(uint32_t row_bytes) noexcept;
+
+    void CopyBuffer(const Allocation& src, const wis::Buffer& dst, uint64_t dst_offset = 0);
+    void UploadBuffer(std::span<const std::byte> data, const wis::Buffer& dst, uint64_t dst_offset = 0);
+    void CopyTexture(const Allocation& src, const wis::Texture& dst, const wis::TextureRegion& region);
+
+    // keeps transient resources (scratch buffers etc.) alive until the next submission completes
+    void Retain(wis::Buffer buffer)
+    {
+        retained.push_back(std::move(buffer));
+    }
+    wis::CommandList& GetCommandList()
+    {
+        return cmd_list;
+    }
+
+    UploadToken Submit();
+    bool IsComplete(UploadToken token) const noexcept;
+    void Wait(UploadToken token) const;
+
+private:
+    void Reclaim() noexcept;
+    static void Unmap(std::deque<wis::Buffer>& buffers) noexcept;
+
+private:
+    struct Submission {
+        uint64_t fence_value;
+        uint64_t ring_end; // ring position after the last allocation of the submission
+        wis::CommandList cmd_list;
+        std::deque<wis::Buffer> retained;
+        std::deque<wis::Buffer> dedicated;
+    };
+
+    const wis::Device& device;
+    const wis::CommandQueue& queue;
+    const wis::ResourceAllocator& allocator;
+
+    wis::Fence fence;
+    uint64_t fence_value = 1;
+
+    wis::Buffer ring;
+    uint8_t* ring_data = nullptr;
+    uint64_t ring_size = 0;
+    uint64_t head = 0; // monotonic byte counters, position in the ring is counter % ring_size
+    uint64_t tail = 0;
+
+    wis::CommandList cmd_list; // recording
+    std::deque<wis::Buffer> retained; // for the recording list
+    std::deque<wis::Buffer> dedicated; // staging that did not fit the ring, mapped until its submission completes
+    std::deque<Submission> in_flight;
+    std::vector<wis::CommandList> free_lists;
+};
+} // namespace w
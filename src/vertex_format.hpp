@@ -0,0 +1,146 @@
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+// Compressed vertex layout, shaders/vertex_format.hlsli holds the matching HLSL decoders.
+// Positions live in their own stream so the BLAS can read them directly:
+//   PackedPosition   8 bytes  16 bit snorm xyz relative to the mesh bounds, w unused
+//   PackedAttributes 12 bytes octahedral normal and tangent (2x snorm16 each), half precision uv
+namespace w {
+struct PackedPosition {
+    int16_t x, y, z, w;
+};
+
+struct PackedAttributes {
+    uint32_t normal;
+    uint32_t tangent;
+    uint32_t uv; // half x in the low bits
+};
+
+// Maps [center - half_extent, center + half_extent] onto the snorm range
+struct QuantizationBounds {
+    DirectX::XMFLOAT3 center{};
+    DirectX::XMFLOAT3 half_extent{ 1, 1, 1 };
+
+    static QuantizationBounds FromPoints(std::span<const DirectX::XMFLOAT3> points) noexcept
+    {
+        DirectX::XMFLOAT3 lo{ HUGE_VALF, HUGE_VALF, HUGE_VALF };
+        DirectX::XMFLOAT3 hi{ -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+        for (auto& p : points) {
+            lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+            hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+        }
+        if (points.empty()) {
+            return {};
+        }
+        // flat axes keep a non zero extent so decoding never divides by zero
+        auto half = [](float l, float h) { return h > l ? (h - l) * 0.5f : 1.0f; };
+        return { .center = { (lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f },
+                 .half_extent = { half(lo.x, hi.x), half(lo.y, hi.y), half(lo.z, hi.z) } };
+    }
+};
+
+inline int16_t PackSnorm16(float v) noexcept
+{
+    return int16_t(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+inline float UnpackSnorm16(int16_t v) noexcept
+{
+    return std::max(float(v) / 32767.0f, -1.0f);
+}
+
+// round to nearest even, overflow goes to infinity, small values flush to zero
+inline uint16_t PackHalf(float v) noexcept
+{
+    uint32_t bits = std::bit_cast<uint32_t>(v);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude >= 0x7f800000) { // inf, nan
+        return uint16_t(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    }
+    if (magnitude >= 0x477ff000) { // rounds past the largest half
+        return uint16_t(sign | 0x7c00);
+    }
+    if (magnitude < 0x38800000) { // subnormal half
+        float f = std::bit_cast<float>(magnitude) * 16777216.0f; // scale by 2^24, the subnormal step
+        return uint16_t(sign | uint32_t(std::nearbyint(f)));
+    }
+    uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+    return uint16_t(sign | ((rounded - 0x38000000) >> 13));
+}
+inline float UnpackHalf(uint16_t v) noexcept
+{
+    uint32_t sign = uint32_t(v & 0x8000) << 16;
+    uint32_t exponent = (v >> 10) & 0x1f;
+    uint32_t mantissa = v & 0x3ff;
+    if (exponent == 0) {
+        return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(float(mantissa) / 16777216.0f));
+    }
+    if (exponent == 0x1f) {
+        return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+inline PackedPosition PackPosition(DirectX::XMFLOAT3 p, const QuantizationBounds& bounds) noexcept
+{
+    return { PackSnorm16((p.x - bounds.center.x) / bounds.half_extent.x),
+             PackSnorm16((p.y - bounds.center.y) / bounds.half_extent.y),
+             PackSnorm16((p.z - bounds.center.z) / bounds.half_extent.z), 0 };
+}
+inline DirectX::XMFLOAT3 UnpackPosition(PackedPosition p, const QuantizationBounds& bounds) noexcept
+{
+    return { bounds.center.x + UnpackSnorm16(p.x) * bounds.half_extent.x,
+             bounds.center.y + UnpackSnorm16(p.y) * bounds.half_extent.y,
+             bounds.center.z + UnpackSnorm16(p.z) * bounds.half_extent.z };
+}
+
+// object to world rows that decode PackPosition output and then apply scale, what the TLAS instance of a quantized mesh uses
+inline std::array<std::array<float, 4>, 3> DequantizeTransform(const QuantizationBounds& bounds, DirectX::XMFLOAT3 scale) noexcept
+{
+    return { {
+            { scale.x * bounds.half_extent.x, 0, 0, scale.x * bounds.center.x },
+            { 0, scale.y * bounds.half_extent.y, 0, scale.y * bounds.center.y },
+            { 0, 0, scale.z * bounds.half_extent.z, scale.z * bounds.center.z },
+    } };
+}
+
+// unit vector onto the octahedron, lower hemisphere folded over the diagonals
+inline uint32_t PackOctahedral(DirectX::XMFLOAT3 n) noexcept
+{
+    float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0) {
+        return 0;
+    }
+    float x = n.x / l1;
+    float y = n.y / l1;
+    if (n.z < 0) {
+        float fx = (1 - std::abs(y)) * (x >= 0 ? 1 : -1);
+        float fy = (1 - std::abs(x)) * (y >= 0 ? 1 : -1);
+        x = fx;
+        y = fy;
+    }
+    return uint32_t(uint16_t(PackSnorm16(x))) | (uint32_t(uint16_t(PackSnorm16(y))) << 16);
+}
+inline DirectX::XMFLOAT3 UnpackOctahedral(uint32_t packed) noexcept
+{
+    float x = UnpackSnorm16(int16_t(packed & 0xffff));
+    float y = UnpackSnorm16(int16_t(packed >> 16));
+    float z = 1 - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0 ? -t : t;
+    y += y >= 0 ? -t : t;
+    float length = std::sqrt(x * x + y * y + z * z);
+    return { x / length, y / length, z / length };
+}
+
+inline PackedAttributes PackAttributes(DirectX::XMFLOAT3 normal, DirectX::XMFLOAT3 tangent, DirectX::XMFLOAT3 uv) noexcept
+{
+    return { PackOctahedral(normal), PackOctahedral(tangent), uint32_t(PackHalf(uv.x)) | (uint32_t(PackHalf(uv.y)) << 16) };
+}
+} // namespace w
@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace w {
+// Fixed size pool for CPU side loading work (decoding, cooking), tasks are run in submission order
+class WorkerPool
+{
+public:
+    explicit WorkerPool(uint32_t thread_count = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        workers.reserve(thread_count);
+        for (uint32_t i = 0; i < thread_count; i++) {
+            workers.emplace_back([this](std::stop_token stop) { Work(stop); });
+        }
+    }
+    ~WorkerPool() = default; // jthreads request stop and join, queued tasks are drained first
+
+public:
+    template<typename F>
+    [[nodiscard]] auto Submit(F&& task) -> std::future<std::invoke_result_t<F>>
+    {
+        using R = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        {
+            std::scoped_lock lock{ mutex };
+            tasks.emplace([packaged]() { (*packaged)(); });
+        }
+        cv.notify_one();
+        return future;
+    }
+    uint32_t ThreadCount() const noexcept
+    {
+        return uint32_t(workers.size());
+    }
+
+private:
+    void Work(std::stop_token stop)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock{ mutex };
+                cv.wait(lock, stop, [this]() { return !tasks.empty(); });
+                if (tasks.empty()) {
+                    return; // stop requested and drained
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    std::queue<std::function<void()>> tasks;
+    std::vector<std::jthread> workers; // last, so threads are joined before the queue dies
+};
+
+// Splits [0, count) into chunk_count pieces of equal size, runs f(chunk, begin, end) for each on pool and waits for
+// them. Trailing chunks of a short range are empty. Without a pool or with one chunk the whole range runs here as chunk 0
+template<typename F>
+void ParallelFor(WorkerPool* pool, uint32_t count, uint32_t chunk_count, F&& f)
+{
+    if (!pool || chunk_count <= 1) {
+        f(0u, 0u, count);
+        return;
+    }
+    uint32_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(chunk_count);
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+        uint32_t begin = std::min(count, chunk * chunk_size);
+        uint32_t end = std::min(count, begin + chunk_size);
+        tasks.push_back(pool->Submit([&f, chunk, begin, end]() { f(chunk, begin, end); }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+} // namespace w
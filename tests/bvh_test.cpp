@@ -0,0 +1,117 @@
+// Builds and traversals of the CPU BVH on inputs the meshes in the app never produce.
+// Prints every failed check and returns non zero when any fails
+#include "cpu/tlas.hpp"
+#include "cpu/triangle_mesh.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace {
+using namespace w::cpu;
+
+uint32_t failures = 0;
+
+void Check(bool ok, const char* what)
+{
+    if (!ok) {
+        std::printf("FAILED %s\n", what);
+        failures++;
+    }
+}
+
+constexpr BvhBuildMode modes[] = { BvhBuildMode::FastTrace, BvhBuildMode::FastBuild, BvhBuildMode::SpatialSplits };
+
+void EmptyInput()
+{
+    for (BvhBuildMode mode : modes) {
+        Bvh bvh = BuildBvh(std::span<const Aabb>{}, { .mode = mode });
+        Check(bvh.nodes.empty() && bvh.references.empty(), "empty span builds an empty tree");
+        Check(bvh.Stats().node_count == 0, "empty tree has no nodes");
+
+        Blas blas = Blas::Build(TriangleMesh{}, { .mode = mode });
+        Ray ray{ .origin = { 0, 0, -1 }, .dir = { 0, 0, 1 } };
+        Check(blas.Trace(ray).Missed(), "empty blas misses");
+        Check(!blas.Occluded(ray), "empty blas occludes nothing");
+        std::vector<Ray> rays(16, ray);
+        std::vector<Hit> hits(rays.size());
+        std::vector<uint8_t> occluded(rays.size(), 1);
+        blas.TracePackets(rays, hits);
+        blas.OccludedPackets(rays, occluded);
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Check(hits[i].Missed() && !occluded[i], "empty blas misses packets");
+        }
+    }
+}
+
+// every instance is left out, one for its empty blas and one for a transform that cannot be inverted
+void CulledInstances()
+{
+    TriangleMesh triangle;
+    triangle.positions = { { -1, -1, 0 }, { 1, -1, 0 }, { 0, 1, 0 } };
+    triangle.indices = { 0, 1, 2 };
+    Blas empty = Blas::Build(TriangleMesh{});
+    Blas blas = Blas::Build(triangle);
+    const Blas* blases[] = { &empty, &blas };
+
+    Instance instances[2];
+    instances[0].blas = 0;
+    instances[1].blas = 1;
+    instances[1].transform[2] = { 0, 0, 0, 0 };
+    for (BvhBuildMode mode : modes) {
+        Tlas tlas = Tlas::Build(blases, instances, { .mode = mode });
+        Check(tlas.instances.empty() && tlas.bvh.nodes.empty(), "culled instances build an empty tlas");
+        Check(tlas.Trace({ .origin = { 0, 0, -1 }, .dir = { 0, 0, 1 } }).Missed(), "empty tlas misses");
+    }
+}
+
+// a chain of triangles, each 0.3 times as far from the origin as the last: every SAH split peels off the outermost
+// one, so the tree gets as deep as float areas allow. Capped to min_bvh_depth it has to fall back to median splits
+void DeepChain()
+{
+    TriangleMesh chain;
+    for (float c = 1e18f; c > 1e-18f; c *= 0.3f) {
+        float s = c * 1e-3f;
+        uint32_t base = uint32_t(chain.positions.size());
+        chain.positions.insert(chain.positions.end(), { { c - s, -s, 0 }, { c + s, -s, 0 }, { c, s, s } });
+        chain.indices.insert(chain.indices.end(), { base, base + 1, base + 2 });
+    }
+    std::vector<Ray> rays;
+    for (uint32_t t = 0; t < chain.TriangleCount(); ++t) {
+        float c = chain.positions[t * 3 + 2].x;
+        rays.push_back({ .origin = { c, 0, -c }, .t_min = 0, .dir = { 0, 0, 1 }, .t_max = HUGE_VALF });
+    }
+    rays.push_back({ .origin = { -1, 0, 1e-30f }, .t_min = 0, .dir = { 1, 0, 0 }, .t_max = HUGE_VALF }); // along the chain
+
+    for (BvhBuildMode mode : modes) {
+        BvhBuildSettings settings{ .mode = mode, .max_leaf_size = 1, .layout = BvhLayout::Build };
+        Blas deep = Blas::Build(chain, settings);
+        Check(deep.bvh.Stats().max_depth <= traversal_stack_size, "default depth fits the traversal stack");
+        if (mode != BvhBuildMode::FastBuild) {
+            Check(deep.bvh.Stats().max_depth > min_bvh_depth, "chain is deeper than the cap");
+        }
+
+        // also through the parallel top levels of the SAH builder
+        for (uint32_t threads : { 1u, 4u }) {
+            settings.max_depth = min_bvh_depth;
+            settings.thread_count = threads;
+            settings.parallel_threshold = 8;
+            Blas capped = Blas::Build(chain, settings);
+            Check(capped.bvh.Stats().max_depth <= min_bvh_depth, "capped depth");
+            Check(capped.bvh.Stats().leaf_count == chain.TriangleCount(), "capped tree keeps single triangle leaves");
+            for (const Ray& ray : rays) {
+                Hit a = deep.Trace(ray), b = capped.Trace(ray);
+                Check(a.primitive == b.primitive && a.t == b.t, "capped tree finds the same hits");
+                Check(deep.Occluded(ray) == capped.Occluded(ray), "capped tree occludes the same rays");
+            }
+        }
+    }
+}
+} // namespace
+
+int main()
+{
+    EmptyInput();
+    CulledInstances();
+    DeepChain();
+    std::printf("bvh_test: %u failed checks\n", failures);
+    return failures ? 1 : 0;
+}
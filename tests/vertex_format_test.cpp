@@ -0,0 +1,102 @@
+// Round trips of the encoders and decoders in vertex_format.hpp against the error bounds the quantized layout promises.
+// Prints every failed check and returns non zero when any fails
+#include "vertex_format.hpp"
+#include <cstdio>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace {
+uint32_t failures = 0;
+
+void Check(bool ok, const char* what, double value, double bound)
+{
+    if (!ok) {
+        std::printf("FAILED %s: %g, bound %g\n", what, value, bound);
+        failures++;
+    }
+}
+
+void PositionRoundTrip(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> coordinate{ -250.0f, 400.0f };
+    std::vector<DirectX::XMFLOAT3> points(100000);
+    for (auto& p : points) {
+        p = { coordinate(rng), coordinate(rng) * 0.01f, coordinate(rng) * 3.0f };
+    }
+    auto bounds = w::QuantizationBounds::FromPoints(points);
+    // half a snorm step of rounding, plus a few float ulps of the coordinates from the encode and decode arithmetic
+    auto bound_of = [](float center, float half_extent) {
+        return half_extent / 32767.0 * 0.5 + 4.0 * (std::abs(center) + half_extent) * std::exp2(-24.0);
+    };
+    double bound[3] = { bound_of(bounds.center.x, bounds.half_extent.x), bound_of(bounds.center.y, bounds.half_extent.y),
+                        bound_of(bounds.center.z, bounds.half_extent.z) };
+    double worst[3]{};
+    for (auto& p : points) {
+        auto q = w::UnpackPosition(w::PackPosition(p, bounds), bounds);
+        worst[0] = std::max(worst[0], double(std::abs(q.x - p.x)));
+        worst[1] = std::max(worst[1], double(std::abs(q.y - p.y)));
+        worst[2] = std::max(worst[2], double(std::abs(q.z - p.z)));
+    }
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        Check(worst[axis] <= bound[axis], "position error", worst[axis], bound[axis]);
+    }
+}
+
+void OctahedralRoundTrip(std::mt19937& rng)
+{
+    constexpr double bound = 0.04 * std::numbers::pi / 180.0; // radians
+    std::normal_distribution<float> gaussian;
+    double worst = 0;
+    auto test = [&](DirectX::XMFLOAT3 n) {
+        float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        n = { n.x / length, n.y / length, n.z / length };
+        auto d = w::UnpackOctahedral(w::PackOctahedral(n));
+        double dot = std::clamp(double(n.x) * d.x + double(n.y) * d.y + double(n.z) * d.z, -1.0, 1.0);
+        worst = std::max(worst, std::acos(dot));
+    };
+    for (uint32_t i = 0; i < 200000; ++i) {
+        test({ gaussian(rng), gaussian(rng), gaussian(rng) });
+    }
+    // axes and the folded seams of the lower hemisphere
+    for (DirectX::XMFLOAT3 n : { DirectX::XMFLOAT3{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 1, 1, -1 }, { -1, 1, -1 }, { 1, -1, -1 }, { -1, -1, -1 } }) {
+        test(n);
+    }
+    Check(worst <= bound, "octahedral angle", worst, bound);
+}
+
+void HalfRoundTrip(std::mt19937& rng)
+{
+    // every non nan half decodes to a float that encodes back to the same bits
+    uint32_t mismatches = 0;
+    for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+        bool nan = (bits & 0x7c00) == 0x7c00 && (bits & 0x3ff);
+        mismatches += !nan && w::PackHalf(w::UnpackHalf(uint16_t(bits))) != bits;
+    }
+    Check(mismatches == 0, "half bit patterns not round tripping", mismatches, 0);
+
+    // floats in the half range round to nearest: relative error of half a half ulp, absolute in the subnormals
+    std::uniform_real_distribution<float> exponent{ -26.0f, 15.9f };
+    std::bernoulli_distribution negative;
+    double worst = 0;
+    for (uint32_t i = 0; i < 200000; ++i) {
+        float v = std::exp2(exponent(rng)) * (negative(rng) ? -1.0f : 1.0f);
+        double error = std::abs(double(w::UnpackHalf(w::PackHalf(v))) - v);
+        double bound = std::max(std::abs(double(v)) * std::exp2(-11.0), std::exp2(-25.0));
+        worst = std::max(worst, error / bound);
+    }
+    Check(worst <= 1.0, "half rounding error in half ulps", worst * 0.5, 0.5);
+    Check(std::isinf(w::UnpackHalf(w::PackHalf(70000.0f))), "overflow to infinity", w::UnpackHalf(w::PackHalf(70000.0f)), HUGE_VAL);
+    Check(std::isnan(w::UnpackHalf(w::PackHalf(std::nanf("")))), "nan stays nan", 0, 0);
+}
+} // namespace
+
+int main()
+{
+    std::mt19937 rng{ 1 };
+    PositionRoundTrip(rng);
+    OctahedralRoundTrip(rng);
+    HalfRoundTrip(rng);
+    std::printf("vertex_format_test: %u failed checks\n", failures);
+    return failures ? 1 : 0;
+}
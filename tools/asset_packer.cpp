@@ -0,0 +1,39 @@
+// Packs build outputs into one file for w::AssetPack.
+// usage: asset_packer <output.pack> <root> <path>...
+// paths are relative to root and become the entry names, directories are packed recursively, missing paths are skipped
+#include "../src/asset_pack.hpp"
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: asset_packer <output.pack> <root> <path>...\n";
+        return 1;
+    }
+
+    std::filesystem::path root = argv[2];
+    std::vector<w::AssetPackSource> sources;
+    auto add = [&](const std::filesystem::path& p) {
+        sources.push_back({ .name = p.lexically_relative(root).generic_string(), .path = p });
+    };
+    for (int i = 3; i < argc; ++i) {
+        std::filesystem::path p = root / argv[i];
+        if (std::filesystem::is_directory(p)) {
+            for (auto& item : std::filesystem::recursive_directory_iterator(p)) {
+                if (item.is_regular_file()) {
+                    add(item.path());
+                }
+            }
+        } else if (std::filesystem::is_regular_file(p)) {
+            add(p);
+        } else {
+            std::cerr << "skipping missing " << p.string() << "\n";
+        }
+    }
+
+    if (!w::WriteAssetPack(argv[1], std::move(sources))) {
+        std::cerr << "failed to write " << argv[1] << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "bc_encoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Little endian bit writer for 128 bit blocks
+struct BitWriter {
+    uint8_t* out;
+    uint32_t pos = 0;
+
+    void Write(uint32_t value, uint32_t bits) noexcept
+    {
+        for (uint32_t i = 0; i < bits; i++, pos++) {
+            out[pos >> 3] |= uint8_t(((value >> i) & 1) << (pos & 7));
+        }
+    }
+};
+
+constexpr uint32_t bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+constexpr uint32_t Interpolate(uint32_t e0, uint32_t e1, uint32_t weight) noexcept
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+// Principal axis of the block colors by power iteration on the covariance matrix
+void PrincipalAxis(const uint8_t (&block)[16][4], const float (&mean)[4], float (&axis)[4]) noexcept
+{
+    float cov[4][4]{};
+    for (auto& texel : block) {
+        float d[4];
+        for (int c = 0; c < 4; c++) {
+            d[c] = float(texel[c]) - mean[c];
+        }
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                cov[i][j] += d[i] * d[j];
+            }
+        }
+    }
+
+    float v[4] = { 1.0f, 0.7f, 0.4f, 0.2f }; // arbitrary start, not orthogonal to typical axes
+    for (int iter = 0; iter < 8; iter++) {
+        float next[4]{};
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                next[i] += cov[i][j] * v[j];
+            }
+        }
+        float len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (len < 1e-6f) {
+            break; // flat block
+        }
+        for (int i = 0; i < 4; i++) {
+            v[i] = next[i] / len;
+        }
+    }
+    std::memcpy(axis, v, sizeof(v));
+}
+
+uint32_t ErrorBC7(const uint8_t (&block)[16][4], const uint32_t (&e0)[4], const uint32_t (&e1)[4], uint8_t (&indices)[16]) noexcept
+{
+    uint32_t palette[16][4];
+    for (uint32_t i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) {
+            palette[i][c] = Interpolate(e0[c], e1[c], bc7_weights4[i]);
+        }
+    }
+
+    uint32_t total = 0;
+    for (uint32_t t = 0; t < 16; t++) {
+        uint32_t best = UINT32_MAX;
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t err = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = int(block[t][c]) - int(palette[i][c]);
+                err += uint32_t(d * d);
+            }
+            if (err < best) {
+                best = err;
+                indices[t] = uint8_t(i);
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+} // namespace
+
+void w::bc::EncodeBC4(const uint8_t (&block)[16][4], uint32_t channel, uint8_t* out) noexcept
+{
+    uint8_t lo = 255, hi = 0;
+    for (auto& texel : block) {
+        lo = std::min(lo, texel[channel]);
+        hi = std::max(hi, texel[channel]);
+    }
+
+    // red0 > red1 selects the 8 value palette: red0, red1 and 6 interpolated steps
+    uint8_t palette[8] = { hi, lo };
+    for (uint32_t i = 2; i < 8; i++) {
+        palette[i] = uint8_t(((8 - i) * hi + (i - 1) * lo + 3) / 7);
+    }
+
+    uint64_t bits = uint64_t(hi) | uint64_t(lo) << 8;
+    for (uint32_t t = 0; t < 16; t++) {
+        uint32_t best_index = 0;
+        int best = 256;
+        for (uint32_t i = 0; i < (hi == lo ? 1u : 8u); i++) {
+            int err = std::abs(int(block[t][channel]) - int(palette[i]));
+            if (err < best) {
+                best = err;
+                best_index = i;
+            }
+        }
+        bits |= uint64_t(best_index) << (16 + 3 * t);
+    }
+    std::memcpy(out, &bits, sizeof(bits));
+}
+
+void w::bc::EncodeBC5(const uint8_t (&block)[16][4], uint8_t* out) noexcept
+{
+    EncodeBC4(block, 0, out);
+    EncodeBC4(block, 1, out + 8);
+}
+
+void w::bc::EncodeBC7(const uint8_t (&block)[16][4], uint8_t* out) noexcept
+{
+    float mean[4]{};
+    for (auto& texel : block) {
+        for (int c = 0; c < 4; c++) {
+            mean[c] += texel[c] / 16.0f;
+        }
+    }
+    float axis[4];
+    PrincipalAxis(block, mean, axis);
+
+    // endpoints at the extreme projections onto the principal axis
+    float tmin = 0, tmax = 0;
+    for (auto& texel : block) {
+        float t = 0;
+        for (int c = 0; c < 4; c++) {
+            t += (float(texel[c]) - mean[c]) * axis[c];
+        }
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+
+    // try all p-bit combinations for the quantized endpoints, keep the best
+    uint32_t best_error = UINT32_MAX;
+    uint32_t best_q0[4]{}, best_q1[4]{}, best_p0 = 0, best_p1 = 0;
+    uint8_t best_indices[16]{};
+    for (uint32_t p0 = 0; p0 < 2; p0++) {
+        for (uint32_t p1 = 0; p1 < 2; p1++) {
+            uint32_t q0[4], q1[4], e0[4], e1[4];
+            for (int c = 0; c < 4; c++) {
+                float v0 = std::clamp(mean[c] + axis[c] * tmin, 0.0f, 255.0f);
+                float v1 = std::clamp(mean[c] + axis[c] * tmax, 0.0f, 255.0f);
+                q0[c] = uint32_t(std::clamp(std::lround((v0 - float(p0)) / 2.0f), 0l, 127l));
+                q1[c] = uint32_t(std::clamp(std::lround((v1 - float(p1)) / 2.0f), 0l, 127l));
+                e0[c] = q0[c] << 1 | p0;
+                e1[c] = q1[c] << 1 | p1;
+            }
+            uint8_t indices[16];
+            uint32_t error = ErrorBC7(block, e0, e1, indices);
+            if (error < best_error) {
+                best_error = error;
+                std::memcpy(best_q0, q0, sizeof(q0));
+                std::memcpy(best_q1, q1, sizeof(q1));
+                std::memcpy(best_indices, indices, sizeof(indices));
+                best_p0 = p0;
+                best_p1 = p1;
+            }
+        }
+    }
+
+    // the anchor index (texel 0) is stored with an implicit zero MSB, swap endpoints to make it so
+    if (best_indices[0] & 8) {
+        std::swap(best_q0, best_q1);
+        std::swap(best_p0, best_p1);
+        for (auto& index : best_indices) {
+            index = uint8_t(15 - index);
+        }
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer{ out };
+    writer.Write(1u << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++) {
+        writer.Write(best_q0[c], 7);
+        writer.Write(best_q1[c], 7);
+    }
+    writer.Write(best_p0, 1);
+    writer.Write(best_p1, 1);
+    writer.Write(best_indices[0], 3);
+    for (uint32_t t = 1; t < 16; t++) {
+        writer.Write(best_indices[t], 4);
+    }
+}
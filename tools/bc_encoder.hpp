@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+namespace w::bc {
+// All encoders take a 4x4 block of RGBA8 texels in row order and write one compressed block
+
+// BC4: single channel (channel 0..3 selects the source component), 8 bytes
+void EncodeBC4(const uint8_t (&block)[16][4], uint32_t channel, uint8_t* out) noexcept;
+
+// BC5: red and green as two BC4 blocks, 16 bytes
+void EncodeBC5(const uint8_t (&block)[16][4], uint8_t* out) noexcept;
+
+// BC7: mode 6 (single subset, RGBA 7.7.7.7 endpoints with p-bits, 4 bit indices), 16 bytes
+void EncodeBC7(const uint8_t (&block)[16][4], uint8_t* out) noexcept;
+} // namespace w::bc
@@ -0,0 +1,92 @@
+// Headless CPU render of the frame the GPU path draws, for build agents without a ray tracing capable GPU.
+// usage: cpu_render <out.png> [width height] [compare.png]
+// compare.png is a capture of the GPU frame, pixels are reported when any channel differs
+#include "../src/asset_pack.hpp"
+#include "../src/model_loader.hpp"
+#include "../src/cpu/reference_renderer.hpp"
+#include "../src/cpu/triangle_mesh.hpp"
+#include <fpng.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/stb.h"
+
+namespace {
+int Compare(std::span<const uint32_t> rendered, uint32_t width, uint32_t height, const char* path)
+{
+    int w = 0, h = 0, channels = 0;
+    stbi_uc* reference = stbi_load(path, &w, &h, &channels, 4);
+    if (!reference) {
+        std::cerr << "Failed to load " << path << "\n";
+        return 1;
+    }
+    if (uint32_t(w) != width || uint32_t(h) != height) {
+        std::cerr << path << " is " << w << "x" << h << ", rendered " << width << "x" << height << "\n";
+        stbi_image_free(reference);
+        return 1;
+    }
+
+    auto* bytes = reinterpret_cast<const uint8_t*>(rendered.data());
+    size_t different = 0;
+    int max_error = 0;
+    for (size_t i = 0; i < size_t(width) * height; ++i) {
+        int error = 0;
+        for (size_t c = 0; c < 4; ++c) {
+            error = std::max(error, std::abs(int(bytes[i * 4 + c]) - int(reference[i * 4 + c])));
+        }
+        different += error != 0;
+        max_error = std::max(max_error, error);
+    }
+    stbi_image_free(reference);
+    std::cout << "Compared to " << path << ": " << different << " of " << size_t(width) * height
+              << " pixels differ, largest channel difference " << max_error << "\n";
+    return different ? 2 : 0;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: cpu_render <out.png> [width height] [compare.png]\n";
+        return 1;
+    }
+    const char* output = argv[1];
+    uint32_t width = argc > 3 ? uint32_t(std::atoi(argv[2])) : 800; // the window size App starts with
+    uint32_t height = argc > 3 ? uint32_t(std::atoi(argv[3])) : 600;
+    const char* compare = argc > 4 ? argv[4] : nullptr;
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        w::AssetPack assets("assets.pack");
+        w::ModelLoader model(assets, "assets/SnowmanOBJ.obj");
+        w::cpu::Blas blas = w::cpu::Blas::Build(w::cpu::TriangleMesh::FromModel(model));
+        auto loaded = std::chrono::steady_clock::now();
+
+        // same setup as Scene::Resize and the first frame
+        w::Camera camera;
+        camera.SetPerspective(std::numbers::pi_v<float> / 3.0f, float(width) / float(height), 0.1f, 1000.0f);
+        w::Camera::CBuffer cbuffer;
+        camera.PutCBuffer(&cbuffer);
+
+        std::vector<uint32_t> image(size_t(width) * height);
+        w::cpu::TileScheduler scheduler;
+        w::cpu::RenderFrame(blas, w::cpu::PrimaryRays{ cbuffer, width, height }, image, scheduler);
+        auto rendered = std::chrono::steady_clock::now();
+
+        fpng::fpng_init();
+        if (!fpng::fpng_encode_image_to_file(output, image.data(), width, height, 4)) {
+            std::cerr << "Failed to write " << output << "\n";
+            return 1;
+        }
+        std::cout << "Rendered " << width << "x" << height << " to " << output << " with "
+                  << w::cpu::SimdIsaName(w::cpu::DetectSimdIsa()) << " packets on " << scheduler.ThreadCount() << " threads: load + BVH "
+                  << std::chrono::duration<double, std::milli>(loaded - start).count() << " ms, render "
+                  << std::chrono::duration<double, std::milli>(rendered - loaded).count() << " ms\n";
+        return compare ? Compare(image, width, height, compare) : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
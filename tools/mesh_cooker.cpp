@@ -0,0 +1,17 @@
+// Cooks the mesh cache (<model>.mesh) next to each model, so it can be packed instead of imported at startup.
+// usage: mesh_cooker <model>...
+#include "../src/model_loader.hpp"
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        try {
+            w::ModelLoader mesh(argv[i]);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+// Offline texture cooker: PNG/JPG/TGA in, DDS with a full mip chain out.
+// usage: texture_cooker <input> <output.dds> <bc7|bc5|bc4|rgba8> [box|kaiser]
+#include "bc_encoder.hpp"
+#include "../src/dds.hpp"
+#include "../src/worker_pool.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/stb.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <string_view>
+
+namespace {
+enum class Filter {
+    Box,
+    Kaiser,
+};
+
+struct FloatImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> texels; // RGBA, 0..255
+
+    float* At(uint32_t x, uint32_t y) noexcept
+    {
+        return texels.data() + (size_t(y) * width + x) * 4;
+    }
+    const float* At(uint32_t x, uint32_t y) const noexcept
+    {
+        return texels.data() + (size_t(y) * width + x) * 4;
+    }
+};
+
+struct Tap {
+    uint32_t index;
+    float weight;
+};
+
+double BesselI0(double x) noexcept
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Filter taps for every destination texel of one axis, sources wrap since textures are sampled with Repeat
+std::vector<std::vector<Tap>> ComputeTaps(uint32_t src, uint32_t dst, Filter filter)
+{
+    constexpr double kaiser_radius = 3.0;
+    constexpr double kaiser_alpha = 4.0;
+
+    double scale = double(src) / double(dst);
+    std::vector<std::vector<Tap>> taps(dst);
+    for (uint32_t x = 0; x < dst; x++) {
+        auto& out = taps[x];
+        double lo = x * scale, hi = (x + 1) * scale;
+        double center = (lo + hi) * 0.5;
+
+        if (filter == Filter::Box) {
+            for (int64_t i = int64_t(std::floor(lo)); i < int64_t(std::ceil(hi)); i++) {
+                double coverage = std::min(hi, double(i + 1)) - std::max(lo, double(i));
+                out.push_back({ uint32_t((i % src + src) % src), float(coverage) });
+            }
+        } else {
+            double radius = kaiser_radius * std::max(1.0, scale);
+            for (int64_t i = int64_t(std::floor(center - radius)); i <= int64_t(std::ceil(center + radius)); i++) {
+                double t = (double(i) + 0.5 - center) / std::max(1.0, scale);
+                if (std::abs(t) >= kaiser_radius) {
+                    continue;
+                }
+                double sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+                double window = BesselI0(kaiser_alpha * std::sqrt(1.0 - (t / kaiser_radius) * (t / kaiser_radius))) / BesselI0(kaiser_alpha);
+                out.push_back({ uint32_t((i % int64_t(src) + src) % src), float(sinc * window) });
+            }
+        }
+
+        float sum = 0;
+        for (auto& tap : out) {
+            sum += tap.weight;
+        }
+        for (auto& tap : out) {
+            tap.weight /= sum;
+        }
+    }
+    return taps;
+}
+
+FloatImage Resample(const FloatImage& src, uint32_t width, uint32_t height, Filter filter, bool normal_map)
+{
+    auto taps_x = ComputeTaps(src.width, width, filter);
+    auto taps_y = ComputeTaps(src.height, height, filter);
+
+    // separable: horizontal into tmp, then vertical
+    FloatImage tmp{ width, src.height, std::vector<float>(size_t(width) * src.height * 4) };
+    for (uint32_t y = 0; y < src.height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            float* out = tmp.At(x, y);
+            for (auto& tap : taps_x[x]) {
+                const float* in = src.At(tap.index, y);
+                for (int c = 0; c < 4; c++) {
+                    out[c] += in[c] * tap.weight;
+                }
+            }
+        }
+    }
+
+    FloatImage dst{ width, height, std::vector<float>(size_t(width) * height * 4) };
+    for (uint32_t y = 0; y < height; y++) {
+        for (auto& tap : taps_y[y]) {
+            for (uint32_t x = 0; x < width; x++) {
+                const float* in = tmp.At(x, tap.index);
+                float* out = dst.At(x, y);
+                for (int c = 0; c < 4; c++) {
+                    out[c] += in[c] * tap.weight;
+                }
+            }
+        }
+    }
+
+    for (float& v : dst.texels) {
+        v = std::clamp(v, 0.0f, 255.0f); // kaiser rings
+    }
+    if (normal_map) {
+        // averaged normals shrink, put them back on the unit sphere
+        for (uint32_t i = 0; i < width * height; i++) {
+            float* n = dst.texels.data() + size_t(i) * 4;
+            float v[3] = { n[0] / 127.5f - 1.0f, n[1] / 127.5f - 1.0f, n[2] / 127.5f - 1.0f };
+            float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            if (len > 1e-5f) {
+                for (int c = 0; c < 3; c++) {
+                    n[c] = (v[c] / len + 1.0f) * 127.5f;
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+std::vector<std::byte> Encode(const FloatImage& image, w::dds::Format format, w::WorkerPool& pool)
+{
+    auto layout = w::dds::MipLayout(format, image.width, image.height, 1)[0];
+    std::vector<std::byte> out(size_t(layout.row_bytes) * layout.rows);
+
+    auto texel = [&image](uint32_t x, uint32_t y, uint8_t (&rgba)[4]) {
+        const float* in = image.At(std::min(x, image.width - 1), std::min(y, image.height - 1)); // clamp partial blocks
+        for (int c = 0; c < 4; c++) {
+            rgba[c] = uint8_t(std::lround(in[c]));
+        }
+    };
+
+    std::vector<std::future<void>> rows;
+    rows.reserve(layout.rows);
+    for (uint32_t row = 0; row < layout.rows; row++) {
+        rows.push_back(pool.Submit([&, row]() {
+            uint8_t* dst = reinterpret_cast<uint8_t*>(out.data()) + size_t(row) * layout.row_bytes;
+            if (!w::dds::IsBlockCompressed(format)) {
+                for (uint32_t x = 0; x < image.width; x++) {
+                    uint8_t rgba[4];
+                    texel(x, row, rgba);
+                    std::memcpy(dst + x * 4, rgba, 4);
+                }
+                return;
+            }
+
+            for (uint32_t bx = 0; bx < (image.width + 3) / 4; bx++) {
+                uint8_t block[16][4];
+                for (uint32_t t = 0; t < 16; t++) {
+                    texel(bx * 4 + t % 4, row * 4 + t / 4, block[t]);
+                }
+                uint8_t* block_out = dst + bx * w::dds::BytesPerBlock(format);
+                switch (format) {
+                case w::dds::Format::BC4Unorm:
+                    w::bc::EncodeBC4(block, 0, block_out);
+                    break;
+                case w::dds::Format::BC5Unorm:
+                    w::bc::EncodeBC5(block, block_out);
+                    break;
+                default:
+                    w::bc::EncodeBC7(block, block_out);
+                    break;
+                }
+            }
+        }));
+    }
+    for (auto& row : rows) {
+        row.get();
+    }
+    return out;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: texture_cooker <input> <output.dds> <bc7|bc5|bc4|rgba8> [box|kaiser]\n";
+        return 1;
+    }
+
+    std::string_view codec = argv[3];
+    w::dds::Format format = codec == "bc7" ? w::dds::Format::BC7Unorm
+            : codec == "bc5"               ? w::dds::Format::BC5Unorm
+            : codec == "bc4"               ? w::dds::Format::BC4Unorm
+            : codec == "rgba8"             ? w::dds::Format::RGBA8Unorm
+                                           : w::dds::Format(0);
+    if (format == w::dds::Format(0)) {
+        std::cerr << "unknown format: " << codec << "\n";
+        return 1;
+    }
+    Filter filter = argc > 4 && std::string_view(argv[4]) == "kaiser" ? Filter::Kaiser : Filter::Box;
+    bool normal_map = format == w::dds::Format::BC5Unorm;
+
+    int width, height, channels;
+    uint8_t* pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cerr << "failed to load " << argv[1] << ": " << stbi_failure_reason() << "\n";
+        return 1;
+    }
+
+    FloatImage level{ uint32_t(width), uint32_t(height), std::vector<float>(pixels, pixels + size_t(width) * height * 4) };
+    stbi_image_free(pixels);
+
+    // D3D12 wants block compressed top levels in whole blocks, stretch odd sizes (UVs are normalized anyway).
+    // Smaller mips keep their texel size, Encode pads them to whole blocks and the loader copies them as such
+    if (w::dds::IsBlockCompressed(format) && (level.width % 4 || level.height % 4)) {
+        level = Resample(level, (level.width + 3) & ~3u, (level.height + 3) & ~3u, filter, normal_map);
+    }
+
+    uint32_t mip_count = w::dds::MipCount(level.width, level.height);
+    w::dds::Header header{
+        .height = level.height,
+        .width = level.width,
+        .mip_map_count = mip_count,
+    };
+    w::dds::HeaderDX10 header_dx10{ .format = format };
+
+    std::ofstream out{ argv[2], std::ios::binary | std::ios::trunc };
+    if (!out) {
+        std::cerr << "failed to open " << argv[2] << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&w::dds::magic), sizeof(w::dds::magic));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&header_dx10), sizeof(header_dx10));
+
+    w::WorkerPool pool;
+    for (uint32_t mip = 0; mip < mip_count; mip++) {
+        if (mip) {
+            level = Resample(level, std::max(1u, level.width / 2), std::max(1u, level.height / 2), filter, normal_map);
+        }
+        auto data = Encode(level, format, pool);
+        out.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+    }
+    return out ? 0 : 1;
+}